@@ -58,7 +58,7 @@ static const uint8_t gbra_order[4] = { 3, 1, 0, 2 };
 static const uint8_t gbr_order[4] = { 1, 0, 2, 0 };
 static const uint8_t y_order[4] = { 0 };
 
-typedef struct EXRScanlineData {
+typedef struct EXRBlockData {
     uint8_t *compressed_data;
     unsigned int compressed_size;
 
@@ -69,7 +69,7 @@ typedef struct EXRScanlineData {
     unsigned int tmp_size;
 
     int64_t actual_size;
-} EXRScanlineData;
+} EXRBlockData;
 
 typedef struct EXRContext {
     const AVClass *class;
@@ -77,14 +77,18 @@ typedef struct EXRContext {
     int compression;
     int pixel_type;
     int planes;
-    int nb_scanlines;
-    int scanline_height;
+    int tile_width;
+    int tile_height;
+    int block_width;
+    int block_height;
+    int nb_blocks_x;
+    int nb_blocks;
     float gamma;
     const char *ch_names;
     const uint8_t *ch_order;
     PutByteContext pb;
 
-    EXRScanlineData *scanline;
+    EXRBlockData *block;
 
     Float2HalfTables f2h_tables;
 } EXRContext;
@@ -115,23 +119,37 @@ static av_cold int encode_init(AVCodecContext *avctx)
         av_assert0(0);
     }
 
-    switch (s->compression) {
-    case EXR_RAW:
-    case EXR_RLE:
-    case EXR_ZIP1:
-        s->scanline_height = 1;
-        s->nb_scanlines = avctx->height;
-        break;
-    case EXR_ZIP16:
-        s->scanline_height = 16;
-        s->nb_scanlines = (avctx->height + s->scanline_height - 1) / s->scanline_height;
-        break;
-    default:
-        av_assert0(0);
+    if (s->tile_width || s->tile_height) {
+        if (s->tile_width <= 0 || s->tile_height <= 0) {
+            av_log(avctx, AV_LOG_ERROR, "Invalid tile size %dx%d\n",
+                   s->tile_width, s->tile_height);
+            return AVERROR(EINVAL);
+        }
+        s->block_width  = FFMIN(s->tile_width,  avctx->width);
+        s->block_height = FFMIN(s->tile_height, avctx->height);
+    } else {
+        s->block_width = avctx->width;
+
+        switch (s->compression) {
+        case EXR_RAW:
+        case EXR_RLE:
+        case EXR_ZIP1:
+            s->block_height = 1;
+            break;
+        case EXR_ZIP16:
+            s->block_height = 16;
+            break;
+        default:
+            av_assert0(0);
+        }
     }
 
-    s->scanline = av_calloc(s->nb_scanlines, sizeof(*s->scanline));
-    if (!s->scanline)
+    s->nb_blocks_x = (avctx->width  + s->block_width  - 1) / s->block_width;
+    s->nb_blocks   = (avctx->height + s->block_height - 1) / s->block_height *
+                     s->nb_blocks_x;
+
+    s->block = av_calloc(s->nb_blocks, sizeof(*s->block));
+    if (!s->block)
         return AVERROR(ENOMEM);
 
     return 0;
@@ -141,15 +159,15 @@ static av_cold int encode_close(AVCodecContext *avctx)
 {
     EXRContext *s = avctx->priv_data;
 
-    for (int y = 0; y < s->nb_scanlines && s->scanline; y++) {
-        EXRScanlineData *scanline = &s->scanline[y];
+    for (int n = 0; n < s->nb_blocks && s->block; n++) {
+        EXRBlockData *block = &s->block[n];
 
-        av_freep(&scanline->tmp);
-        av_freep(&scanline->compressed_data);
-        av_freep(&scanline->uncompressed_data);
+        av_freep(&block->tmp);
+        av_freep(&block->compressed_data);
+        av_freep(&block->uncompressed_data);
     }
 
-    av_freep(&s->scanline);
+    av_freep(&s->block);
 
     return 0;
 }
@@ -217,130 +235,107 @@ static int64_t rle_compress(uint8_t *out, int64_t out_size,
     return o;
 }
 
-static int encode_scanline_rle(EXRContext *s, const AVFrame *frame)
+static void get_block_rect(const EXRContext *s, const AVFrame *frame, int n,
+                           int *x, int *y, int *w, int *h)
 {
+    *x = n % s->nb_blocks_x * s->block_width;
+    *y = n / s->nb_blocks_x * s->block_height;
+    *w = FFMIN(s->block_width,  frame->width  - *x);
+    *h = FFMIN(s->block_height, frame->height - *y);
+}
+
+static int encode_block(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    EXRContext *s = avctx->priv_data;
+    const AVFrame *frame = arg;
+    EXRBlockData *block = &s->block[jobnr];
     const int64_t element_size = s->pixel_type == EXR_HALF ? 2LL : 4LL;
+    int64_t tmp_size, max_compressed_size;
+    int bx, by, bw, bh;
 
-    for (int y = 0; y < frame->height; y++) {
-        EXRScanlineData *scanline = &s->scanline[y];
-        int64_t tmp_size = element_size * s->planes * frame->width;
-        int64_t max_compressed_size = tmp_size * 3 / 2;
+    get_block_rect(s, frame, jobnr, &bx, &by, &bw, &bh);
 
-        av_fast_padded_malloc(&scanline->uncompressed_data, &scanline->uncompressed_size, tmp_size);
-        if (!scanline->uncompressed_data)
-            return AVERROR(ENOMEM);
+    tmp_size = element_size * s->planes * bw * bh;
+    max_compressed_size = tmp_size * 3 / 2;
+
+    av_fast_padded_malloc(&block->uncompressed_data, &block->uncompressed_size, tmp_size);
+    if (!block->uncompressed_data)
+        return AVERROR(ENOMEM);
 
-        av_fast_padded_malloc(&scanline->tmp, &scanline->tmp_size, tmp_size);
-        if (!scanline->tmp)
+    if (s->compression != EXR_RAW) {
+        av_fast_padded_malloc(&block->tmp, &block->tmp_size, tmp_size);
+        if (!block->tmp)
             return AVERROR(ENOMEM);
 
-        av_fast_padded_malloc(&scanline->compressed_data, &scanline->compressed_size, max_compressed_size);
-        if (!scanline->compressed_data)
+        av_fast_padded_malloc(&block->compressed_data, &block->compressed_size, max_compressed_size);
+        if (!block->compressed_data)
             return AVERROR(ENOMEM);
+    }
+
+    /* each line of the block stores all channels, one after the other */
+    switch (s->pixel_type) {
+    case EXR_FLOAT:
+        for (int l = 0; l < bh; l++) {
+            const int line_size = bw * 4 * s->planes;
 
-        switch (s->pixel_type) {
-        case EXR_FLOAT:
             for (int p = 0; p < s->planes; p++) {
                 int ch = s->ch_order[p];
 
-                memcpy(scanline->uncompressed_data + frame->width * 4 * p,
-                       frame->data[ch] + y * frame->linesize[ch], frame->width * 4);
+                memcpy(block->uncompressed_data + line_size * l + p * bw * 4,
+                       frame->data[ch] + (by + l) * frame->linesize[ch] + bx * 4,
+                       bw * 4);
             }
-            break;
-        case EXR_HALF:
+        }
+        break;
+    case EXR_HALF:
+        for (int l = 0; l < bh; l++) {
+            const int line_size = bw * 2 * s->planes;
+
             for (int p = 0; p < s->planes; p++) {
                 int ch = s->ch_order[p];
-                uint16_t *dst = (uint16_t *)(scanline->uncompressed_data + frame->width * 2 * p);
-                const uint32_t *src = (const uint32_t *)(frame->data[ch] + y * frame->linesize[ch]);
+                uint16_t *dst = (uint16_t *)(block->uncompressed_data + line_size * l + p * bw * 2);
+                const uint32_t *src = (const uint32_t *)(frame->data[ch] + (by + l) * frame->linesize[ch]) + bx;
 
-                for (int x = 0; x < frame->width; x++)
+                for (int x = 0; x < bw; x++)
                     dst[x] = float2half(src[x], &s->f2h_tables);
             }
-            break;
-        }
-
-        reorder_pixels(scanline->tmp, scanline->uncompressed_data, tmp_size);
-        predictor(scanline->tmp, tmp_size);
-        scanline->actual_size = rle_compress(scanline->compressed_data,
-                                             max_compressed_size,
-                                             scanline->tmp, tmp_size);
-
-        if (scanline->actual_size <= 0 || scanline->actual_size >= tmp_size) {
-            FFSWAP(uint8_t *, scanline->uncompressed_data, scanline->compressed_data);
-            FFSWAP(int, scanline->uncompressed_size, scanline->compressed_size);
-            scanline->actual_size = tmp_size;
         }
+        break;
     }
 
-    return 0;
-}
-
-static int encode_scanline_zip(EXRContext *s, const AVFrame *frame)
-{
-    const int64_t element_size = s->pixel_type == EXR_HALF ? 2LL : 4LL;
-
-    for (int y = 0; y < s->nb_scanlines; y++) {
-        EXRScanlineData *scanline = &s->scanline[y];
-        const int scanline_height = FFMIN(s->scanline_height, frame->height - y * s->scanline_height);
-        int64_t tmp_size = element_size * s->planes * frame->width * scanline_height;
-        int64_t max_compressed_size = tmp_size * 3 / 2;
-        unsigned long actual_size, source_size;
-
-        av_fast_padded_malloc(&scanline->uncompressed_data, &scanline->uncompressed_size, tmp_size);
-        if (!scanline->uncompressed_data)
-            return AVERROR(ENOMEM);
-
-        av_fast_padded_malloc(&scanline->tmp, &scanline->tmp_size, tmp_size);
-        if (!scanline->tmp)
-            return AVERROR(ENOMEM);
-
-        av_fast_padded_malloc(&scanline->compressed_data, &scanline->compressed_size, max_compressed_size);
-        if (!scanline->compressed_data)
-            return AVERROR(ENOMEM);
-
-        switch (s->pixel_type) {
-        case EXR_FLOAT:
-            for (int l = 0; l < scanline_height; l++) {
-                const int scanline_size = frame->width * 4 * s->planes;
-
-                for (int p = 0; p < s->planes; p++) {
-                    int ch = s->ch_order[p];
-
-                    memcpy(scanline->uncompressed_data + scanline_size * l + p * frame->width * 4,
-                           frame->data[ch] + (y * s->scanline_height + l) * frame->linesize[ch],
-                           frame->width * 4);
-                }
-            }
-            break;
-        case EXR_HALF:
-            for (int l = 0; l < scanline_height; l++) {
-                const int scanline_size = frame->width * 2 * s->planes;
-
-                for (int p = 0; p < s->planes; p++) {
-                    int ch = s->ch_order[p];
-                    uint16_t *dst = (uint16_t *)(scanline->uncompressed_data + scanline_size * l + p * frame->width * 2);
-                    const uint32_t *src = (const uint32_t *)(frame->data[ch] + (y * s->scanline_height + l) * frame->linesize[ch]);
-
-                    for (int x = 0; x < frame->width; x++)
-                        dst[x] = float2half(src[x], &s->f2h_tables);
-                }
-            }
-            break;
-        }
+    switch (s->compression) {
+    case EXR_RAW:
+        block->actual_size = tmp_size;
+        break;
+    case EXR_RLE:
+        reorder_pixels(block->tmp, block->uncompressed_data, tmp_size);
+        predictor(block->tmp, tmp_size);
+        block->actual_size = rle_compress(block->compressed_data,
+                                          max_compressed_size,
+                                          block->tmp, tmp_size);
+        break;
+    case EXR_ZIP1:
+    case EXR_ZIP16: {
+        unsigned long actual_size = max_compressed_size;
+
+        reorder_pixels(block->tmp, block->uncompressed_data, tmp_size);
+        predictor(block->tmp, tmp_size);
+        if (compress(block->compressed_data, &actual_size,
+                     block->tmp, tmp_size) != Z_OK)
+            actual_size = 0;
+        block->actual_size = actual_size;
+        break;
+    }
+    default:
+        av_assert0(0);
+    }
 
-        reorder_pixels(scanline->tmp, scanline->uncompressed_data, tmp_size);
-        predictor(scanline->tmp, tmp_size);
-        source_size = tmp_size;
-        actual_size = max_compressed_size;
-        compress(scanline->compressed_data, &actual_size,
-                 scanline->tmp, source_size);
-
-        scanline->actual_size = actual_size;
-        if (scanline->actual_size >= tmp_size) {
-            FFSWAP(uint8_t *, scanline->uncompressed_data, scanline->compressed_data);
-            FFSWAP(int, scanline->uncompressed_size, scanline->compressed_size);
-            scanline->actual_size = tmp_size;
-        }
+    /* store the block uncompressed if compression does not pay off */
+    if (s->compression == EXR_RAW ||
+        block->actual_size <= 0 || block->actual_size >= tmp_size) {
+        FFSWAP(uint8_t *, block->uncompressed_data, block->compressed_data);
+        FFSWAP(unsigned int, block->uncompressed_size, block->compressed_size);
+        block->actual_size = tmp_size;
     }
 
     return 0;
@@ -353,7 +348,7 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     PutByteContext *pb = &s->pb;
     int64_t offset;
     int ret;
-    int64_t out_size = 2048LL + avctx->height * 16LL +
+    int64_t out_size = 2048LL + s->nb_blocks * 28LL +
                       av_image_get_buffer_size(avctx->pix_fmt,
                                                avctx->width,
                                                avctx->height, 64) * 3LL / 2;
@@ -365,7 +360,7 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
 
     bytestream2_put_le32(pb, 20000630);
     bytestream2_put_byte(pb, 2);
-    bytestream2_put_le24(pb, 0);
+    bytestream2_put_le24(pb, s->tile_width ? 0x2 : 0);
     bytestream2_put_buffer(pb, "channels\0chlist\0", 16);
     bytestream2_put_le32(pb, s->planes * 18 + 1);
 
@@ -397,6 +392,14 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     bytestream2_put_le32(pb, avctx->width - 1);
     bytestream2_put_le32(pb, avctx->height - 1);
 
+    if (s->tile_width) {
+        bytestream2_put_buffer(pb, "tiles\0tiledesc\0", 15);
+        bytestream2_put_le32(pb, 9);
+        bytestream2_put_le32(pb, s->tile_width);
+        bytestream2_put_le32(pb, s->tile_height);
+        bytestream2_put_byte(pb, 0); /* ONE_LEVEL, ROUND_DOWN */
+    }
+
     bytestream2_put_buffer(pb, "lineOrder\0lineOrder\0", 20);
     bytestream2_put_le32(pb, 1);
     bytestream2_put_byte(pb, 0);
@@ -431,83 +434,33 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     bytestream2_put_buffer(pb, "lavc", 4);
     bytestream2_put_byte(pb, 0);
 
-    switch (s->compression) {
-    case EXR_RAW:
-        /* nothing to do */
-        break;
-    case EXR_RLE:
-        encode_scanline_rle(s, frame);
-        break;
-    case EXR_ZIP16:
-    case EXR_ZIP1:
-        encode_scanline_zip(s, frame);
-        break;
-    default:
-        av_assert0(0);
-    }
-
-    switch (s->compression) {
-    case EXR_RAW:
-        offset = bytestream2_tell_p(pb) + avctx->height * 8LL;
-
-        if (s->pixel_type == EXR_FLOAT) {
-
-            for (int y = 0; y < avctx->height; y++) {
-                bytestream2_put_le64(pb, offset);
-                offset += avctx->width * s->planes * 4 + 8;
-            }
-
-            for (int y = 0; y < avctx->height; y++) {
-                bytestream2_put_le32(pb, y);
-                bytestream2_put_le32(pb, s->planes * avctx->width * 4);
-                for (int p = 0; p < s->planes; p++) {
-                    int ch = s->ch_order[p];
-                    bytestream2_put_buffer(pb, frame->data[ch] + y * frame->linesize[ch],
-                                           avctx->width * 4);
-                }
-            }
-        } else {
-            for (int y = 0; y < avctx->height; y++) {
-                bytestream2_put_le64(pb, offset);
-                offset += avctx->width * s->planes * 2 + 8;
-            }
-
-            for (int y = 0; y < avctx->height; y++) {
-                bytestream2_put_le32(pb, y);
-                bytestream2_put_le32(pb, s->planes * avctx->width * 2);
-                for (int p = 0; p < s->planes; p++) {
-                    int ch = s->ch_order[p];
-                    const uint32_t *src = (const uint32_t *)(frame->data[ch] + y * frame->linesize[ch]);
+    ret = avctx->execute2(avctx, encode_block, (void *)frame, NULL, s->nb_blocks);
+    if (ret < 0)
+        return ret;
 
-                    for (int x = 0; x < frame->width; x++)
-                        bytestream2_put_le16(pb, float2half(src[x], &s->f2h_tables));
-                }
-            }
-        }
-        break;
-    case EXR_ZIP16:
-    case EXR_ZIP1:
-    case EXR_RLE:
-        offset = bytestream2_tell_p(pb) + s->nb_scanlines * 8LL;
+    offset = bytestream2_tell_p(pb) + s->nb_blocks * 8LL;
 
-        for (int y = 0; y < s->nb_scanlines; y++) {
-            EXRScanlineData *scanline = &s->scanline[y];
+    for (int n = 0; n < s->nb_blocks; n++) {
+        EXRBlockData *block = &s->block[n];
 
-            bytestream2_put_le64(pb, offset);
-            offset += scanline->actual_size + 8;
-        }
+        bytestream2_put_le64(pb, offset);
+        offset += block->actual_size + (s->tile_width ? 20 : 8);
+    }
 
-        for (int y = 0; y < s->nb_scanlines; y++) {
-            EXRScanlineData *scanline = &s->scanline[y];
+    for (int n = 0; n < s->nb_blocks; n++) {
+        EXRBlockData *block = &s->block[n];
 
-            bytestream2_put_le32(pb, y * s->scanline_height);
-            bytestream2_put_le32(pb, scanline->actual_size);
-            bytestream2_put_buffer(pb, scanline->compressed_data,
-                                   scanline->actual_size);
+        if (s->tile_width) {
+            bytestream2_put_le32(pb, n % s->nb_blocks_x);
+            bytestream2_put_le32(pb, n / s->nb_blocks_x);
+            bytestream2_put_le32(pb, 0);
+            bytestream2_put_le32(pb, 0);
+        } else {
+            bytestream2_put_le32(pb, n * s->block_height);
         }
-        break;
-    default:
-        av_assert0(0);
+        bytestream2_put_le32(pb, block->actual_size);
+        bytestream2_put_buffer(pb, block->compressed_data,
+                               block->actual_size);
     }
 
     av_shrink_packet(pkt, bytestream2_tell_p(pb));
@@ -529,6 +482,7 @@ static const AVOption options[] = {
     { "half" ,       NULL,                   0,                   AV_OPT_TYPE_CONST, {.i64=EXR_HALF},  0, 0, VE, .unit = "pixel" },
     { "float",       NULL,                   0,                   AV_OPT_TYPE_CONST, {.i64=EXR_FLOAT}, 0, 0, VE, .unit = "pixel" },
     { "gamma", "set gamma", OFFSET(gamma), AV_OPT_TYPE_FLOAT, {.dbl=1.f}, 0.001, FLT_MAX, VE },
+    { "tiles", "set tile size and use tiled layout", OFFSET(tile_width), AV_OPT_TYPE_IMAGE_SIZE, {.str=NULL}, 0, 0, VE },
     { NULL},
 };
 
@@ -547,6 +501,7 @@ const FFCodec ff_exr_encoder = {
     .p.type         = AVMEDIA_TYPE_VIDEO,
     .p.id           = AV_CODEC_ID_EXR,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS |
                       AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE,
     .init           = encode_init,
     FF_CODEC_ENCODE_CB(encode_frame),
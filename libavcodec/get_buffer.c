@@ -62,6 +62,20 @@ static void frame_pool_free(FFRefStructOpaque unused, void *obj)
         av_buffer_pool_uninit(&pool->pools[i]);
 }
 
+static AVBufferRef *frame_pool_alloc(void *opaque, size_t size)
+{
+    return CONFIG_MEMORY_POISONING ? av_buffer_alloc(size) : av_buffer_allocz(size);
+}
+
+static AVBufferPool *frame_pool_init(AVCodecContext *avctx, size_t size)
+{
+    /* frame threads get and release buffers concurrently */
+    int flags = avctx->active_thread_type & FF_THREAD_FRAME ?
+                AV_BUFFER_POOL_FLAG_THREAD_CACHES : 0;
+
+    return av_buffer_pool_init3(size, NULL, frame_pool_alloc, NULL, flags);
+}
+
 static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
 {
     FramePool *pool = avctx->internal->pool;
@@ -119,10 +133,7 @@ static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
                     ret = AVERROR(EINVAL);
                     goto fail;
                 }
-                pool->pools[i] = av_buffer_pool_init(size[i] + 16 + STRIDE_ALIGN - 1,
-                                                     CONFIG_MEMORY_POISONING ?
-                                                        NULL :
-                                                        av_buffer_allocz);
+                pool->pools[i] = frame_pool_init(avctx, size[i] + 16 + STRIDE_ALIGN - 1);
                 if (!pool->pools[i]) {
                     ret = AVERROR(ENOMEM);
                     goto fail;
@@ -70,6 +70,7 @@
 #include "encode.h"
 #include "bytestream.h"
 #include "jpeg2000.h"
+#include "jpeg2000htenc.h"
 #include "version.h"
 #include "libavutil/common.h"
 #include "libavutil/mem.h"
@@ -87,6 +88,8 @@
 #define CODEC_JP2 1
 #define CODEC_J2K 0
 
+#define CBLK_DATA_SIZE 8192
+
 static int lut_nmsedec_ref [1<<NMSEDEC_BITS],
            lut_nmsedec_ref0[1<<NMSEDEC_BITS],
            lut_nmsedec_sig [1<<NMSEDEC_BITS],
@@ -109,6 +112,15 @@ typedef struct {
    double *layer_rates;
 } Jpeg2000Tile;
 
+typedef struct {
+    Jpeg2000Component *comp;
+    Jpeg2000Band *band;
+    Jpeg2000Cblk *cblk;
+    int x0, y0, x1, y1; ///< code-block coordinates in the component
+    int bandpos, lev;
+    int ret;
+} Jpeg2000CblkJob;
+
 typedef struct {
     AVClass *class;
     AVCodecContext *avctx;
@@ -134,6 +146,9 @@ typedef struct {
     Jpeg2000QuantStyle  qntsty;
 
     Jpeg2000Tile *tile;
+    Jpeg2000T1Context *t1; ///< one tier-1 context per slice thread
+    Jpeg2000CblkJob *cblk_jobs;
+    unsigned cblk_jobs_allocated;
     int layer_rates[100];
     uint8_t compression_rate_enc; ///< Is compression done using compression ratio?
 
@@ -144,6 +159,7 @@ typedef struct {
     int prog;
     int nlayers;
     char *lr_str;
+    int ht;
 } Jpeg2000EncoderContext;
 
 
@@ -307,7 +323,7 @@ static int put_siz(Jpeg2000EncoderContext *s)
 
     bytestream_put_be16(&s->buf, JPEG2000_SIZ);
     bytestream_put_be16(&s->buf, 38 + 3 * s->ncomponents); // Lsiz
-    bytestream_put_be16(&s->buf, 0); // Rsiz
+    bytestream_put_be16(&s->buf, s->ht ? 1 << 14 : 0); // Rsiz, bit 14: HTJ2K
     bytestream_put_be32(&s->buf, s->width); // width
     bytestream_put_be32(&s->buf, s->height); // height
     bytestream_put_be32(&s->buf, 0); // X0Siz
@@ -327,6 +343,33 @@ static int put_siz(Jpeg2000EncoderContext *s)
     return 0;
 }
 
+static int put_cap(Jpeg2000EncoderContext *s)
+{
+    Jpeg2000CodingStyle *codsty = &s->codsty;
+    Jpeg2000QuantStyle  *qntsty = &s->qntsty;
+    int i, magb = 0, ccap = 0;
+
+    if (s->buf_end - s->buf < 10)
+        return -1;
+
+    for (i = 0; i < 3 * codsty->nreslevels - 2; i++)
+        magb = FFMAX(magb, qntsty->expn[i] + qntsty->nguardbits - 1);
+
+    // Ccap^15: HTONLY, single HT set, no RGN, homogeneous
+    if (codsty->transform != FF_DWT53)
+        ccap |= 1 << 5; // HTIRV
+    if (magb > 27)
+        ccap |= 19 + (magb - 24) / 4;
+    else if (magb > 8)
+        ccap |= magb - 8;
+
+    bytestream_put_be16(&s->buf, JPEG2000_CAP);
+    bytestream_put_be16(&s->buf, 8); // Lcap
+    bytestream_put_be32(&s->buf, 1 << (31 - 14)); // Pcap, only Ccap^15 present
+    bytestream_put_be16(&s->buf, ccap);
+    return 0;
+}
+
 static int put_cod(Jpeg2000EncoderContext *s)
 {
     Jpeg2000CodingStyle *codsty = &s->codsty;
@@ -354,7 +397,7 @@ static int put_cod(Jpeg2000EncoderContext *s)
     bytestream_put_byte(&s->buf, codsty->nreslevels - 1); // num of decomp. levels
     bytestream_put_byte(&s->buf, codsty->log2_cblk_width-2); // cblk width
     bytestream_put_byte(&s->buf, codsty->log2_cblk_height-2); // cblk height
-    bytestream_put_byte(&s->buf, 0); // cblk style
+    bytestream_put_byte(&s->buf, s->ht ? JPEG2000_CTSY_HTJ2K_F : 0); // cblk style
     bytestream_put_byte(&s->buf, codsty->transform == FF_DWT53); // transformation
     return 0;
 }
@@ -764,6 +807,78 @@ static void encode_cblk(Jpeg2000EncoderContext *s, Jpeg2000T1Context *t1, Jpeg20
     }
 }
 
+/**
+ * Code a code-block as a single HT cleanup pass. The HT cleanup segment is
+ * not embedded, so instead of truncating passes afterwards the bit-plane of
+ * the cleanup pass is chosen up front from a rate estimate of roughly one bit
+ * per significant sample on top of its magnitude and sign bits.
+ */
+static int encode_cblk_ht(Jpeg2000T1Context *t1, Jpeg2000Cblk *cblk, int width, int height,
+                          int64_t lambda)
+{
+    int64_t disto[32] = { 0 }, bits[32] = { 0 }, best = 0;
+    int x, y, p, len, max = 0, nplanes, plane = -1;
+
+    for (y = 0; y < height; y++)
+        for (x = 0; x < width; x++)
+            max = FFMAX(max, FFABS(t1->data[y * t1->stride + x]) >> NMSEDEC_FRACBITS);
+
+    cblk->npasses = cblk->ninclpasses = 0;
+    if (!max) {
+        cblk->nonzerobits = 0;
+        return 0;
+    }
+
+    nplanes = lambda ? av_log2(max) + 1 : 1;
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            int mag = FFABS(t1->data[y * t1->stride + x]), q = mag >> NMSEDEC_FRACBITS;
+
+            for (p = 0; p < nplanes && q >> p; p++) {
+                int mu = q >> p;
+                int err = mag - ((mu << p) << NMSEDEC_FRACBITS) - (1 << (p + NMSEDEC_FRACBITS - 1));
+                disto[p] += ((int64_t)mag * mag - (int64_t)err * err) << (13 - 2 * NMSEDEC_FRACBITS);
+                bits[p]  += av_log2(mu) + 3;
+            }
+        }
+    }
+
+    for (p = 0; p < nplanes; p++) {
+        int64_t gain = disto[p] - (bits[p] >> 3) * lambda;
+        if (gain > best || (!lambda && !p)) {
+            best  = gain;
+            plane = p;
+        }
+    }
+    if (plane < 0) {
+        cblk->nonzerobits = 0;
+        return 0;
+    }
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            int *val = &t1->data[y * t1->stride + x];
+            int q = (FFABS(*val) >> NMSEDEC_FRACBITS) >> plane;
+            *val = *val < 0 ? -q : q;
+        }
+    }
+
+    len = ff_jpeg2000_encode_htj2k(cblk->data + 1, CBLK_DATA_SIZE, t1->data, t1->stride,
+                                   width, height);
+    if (len < 0)
+        return len;
+
+    // Bit-planes above and including the cleanup pass are coded, everything
+    // else is signalled as missing MSBs; the decoder only reconstructs down
+    // to the cleanup bit-plane.
+    cblk->nonzerobits = 1 + plane;
+    cblk->npasses = cblk->ninclpasses = 1;
+    cblk->passes[0].rate = len;
+    cblk->passes[0].flushed_len = 0;
+    cblk->passes[0].disto = disto[plane];
+    return 0;
+}
+
 /* tier-2 routines: */
 
 static void putnumpasses(Jpeg2000EncoderContext *s, int n)
@@ -1367,6 +1482,12 @@ static int getcut(Jpeg2000Cblk *cblk, uint64_t lambda)
     return res;
 }
 
+static int64_t band_lambda(Jpeg2000EncoderContext *s, Jpeg2000Band *band, int bandpos, int lev)
+{
+    int64_t dwt_norm = dwt_norms[s->codsty.transform == FF_DWT53][bandpos][lev] * (int64_t)band->i_stepsize >> 15;
+    return av_rescale(s->lambda, 1 << WMSEDEC_SHIFT, dwt_norm * dwt_norm);
+}
+
 static void truncpasses(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile)
 {
     int precno, compno, reslevelno, bandno, cblkno, lev;
@@ -1384,8 +1505,7 @@ static void truncpasses(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile)
                     Jpeg2000Band *band = reslevel->band + bandno;
                     Jpeg2000Prec *prec = band->prec + precno;
 
-                    int64_t dwt_norm = dwt_norms[codsty->transform == FF_DWT53][bandpos][lev] * (int64_t)band->i_stepsize >> 15;
-                    int64_t lambda_prime = av_rescale(s->lambda, 1 << WMSEDEC_SHIFT, dwt_norm * dwt_norm);
+                    int64_t lambda_prime = band_lambda(s, band, bandpos, lev);
                     for (cblkno = 0; cblkno < prec->nb_codeblocks_height * prec->nb_codeblocks_width; cblkno++){
                         Jpeg2000Cblk *cblk = prec->cblk + cblkno;
 
@@ -1402,16 +1522,50 @@ static void truncpasses(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile)
     }
 }
 
+static int encode_cblk_job(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    Jpeg2000EncoderContext *s = avctx->priv_data;
+    Jpeg2000Tile *tile = arg;
+    Jpeg2000T1Context *t1 = &s->t1[threadnr];
+    Jpeg2000CblkJob *job = &s->cblk_jobs[jobnr];
+    Jpeg2000Component *comp = job->comp;
+    int y, x, comp_width = comp->coord[0][1] - comp->coord[0][0];
+
+    t1->stride = (1<<s->codsty.log2_cblk_width) + 2;
+
+    if (s->codsty.transform == FF_DWT53){
+        for (y = job->y0; y < job->y1; y++){
+            int *ptr = t1->data + (y-job->y0)*t1->stride;
+            for (x = job->x0; x < job->x1; x++){
+                *ptr++ = comp->i_data[comp_width * y + x] * (1 << NMSEDEC_FRACBITS);
+            }
+        }
+    } else{
+        for (y = job->y0; y < job->y1; y++){
+            int *ptr = t1->data + (y-job->y0)*t1->stride;
+            for (x = job->x0; x < job->x1; x++){
+                *ptr = (comp->i_data[comp_width * y + x]);
+                *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / job->band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
+                ptr++;
+            }
+        }
+    }
+    if (s->ht)
+        job->ret = encode_cblk_ht(t1, job->cblk, job->x1 - job->x0, job->y1 - job->y0,
+                                  band_lambda(s, job->band, job->bandpos, job->lev));
+    else
+        encode_cblk(s, t1, job->cblk, tile, job->x1 - job->x0, job->y1 - job->y0,
+                    job->bandpos, job->lev);
+    return 0;
+}
+
 static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno)
 {
-    int compno, reslevelno, bandno, ret;
-    Jpeg2000T1Context t1;
+    int compno, reslevelno, bandno, ret, i, nb_jobs = 0;
     Jpeg2000CodingStyle *codsty = &s->codsty;
     for (compno = 0; compno < s->ncomponents; compno++){
         Jpeg2000Component *comp = s->tile[tileno].comp + compno;
 
-        t1.stride = (1<<codsty->log2_cblk_width) + 2;
-
         av_log(s->avctx, AV_LOG_DEBUG,"dwt\n");
         if ((ret = ff_dwt_encode(&comp->dwt, comp->i_data)) < 0)
             return ret;
@@ -1444,32 +1598,32 @@ static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno
                                 band->coord[0][1]) - band->coord[0][0] + xx0;
 
                     for (cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
-                        int y, x;
-                        if (codsty->transform == FF_DWT53){
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
-                                }
-                            }
-                        } else{
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
-                                    *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
-                                    ptr++;
-                                }
-                            }
-                        }
+                        Jpeg2000CblkJob *job;
+
                         if (!prec->cblk[cblkno].data)
-                            prec->cblk[cblkno].data = av_malloc(1 + 8192);
+                            prec->cblk[cblkno].data = av_malloc(1 + CBLK_DATA_SIZE);
                         if (!prec->cblk[cblkno].passes)
                             prec->cblk[cblkno].passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof (*prec->cblk[cblkno].passes));
                         if (!prec->cblk[cblkno].data || !prec->cblk[cblkno].passes)
                             return AVERROR(ENOMEM);
-                        encode_cblk(s, &t1, prec->cblk + cblkno, tile, xx1 - xx0, yy1 - yy0,
-                                    bandpos, codsty->nreslevels - reslevelno - 1);
+
+                        job = av_fast_realloc(s->cblk_jobs, &s->cblk_jobs_allocated,
+                                              (nb_jobs + 1) * sizeof(*s->cblk_jobs));
+                        if (!job)
+                            return AVERROR(ENOMEM);
+                        s->cblk_jobs = job;
+                        job = &s->cblk_jobs[nb_jobs++];
+                        job->comp    = comp;
+                        job->band    = band;
+                        job->cblk    = prec->cblk + cblkno;
+                        job->x0      = xx0;
+                        job->y0      = yy0;
+                        job->x1      = xx1;
+                        job->y1      = yy1;
+                        job->bandpos = bandpos;
+                        job->lev     = codsty->nreslevels - reslevelno - 1;
+                        job->ret     = 0;
+
                         xx0 = xx1;
                         xx1 = FFMIN(xx1 + (1 << band->log2_cblk_width), band->coord[0][1] - band->coord[0][0] + x0);
                     }
@@ -1478,9 +1632,15 @@ static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno
                 }
             }
         }
-        av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
     }
 
+    // code-blocks are independent of each other once the DWT is done
+    s->avctx->execute2(s->avctx, encode_cblk_job, tile, NULL, nb_jobs);
+    for (i = 0; i < nb_jobs; i++)
+        if (s->cblk_jobs[i].ret < 0)
+            return s->cblk_jobs[i].ret;
+    av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
+
     av_log(s->avctx, AV_LOG_DEBUG, "rate control\n");
     if (s->compression_rate_enc)
         makelayers(s, tile);
@@ -1635,6 +1795,8 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     bytestream_put_be16(&s->buf, JPEG2000_SOC);
     if ((ret = put_siz(s)) < 0)
         return ret;
+    if (s->ht && (ret = put_cap(s)) < 0)
+        return ret;
     if ((ret = put_cod(s)) < 0)
         return ret;
     if ((ret = put_qcd(s, 0)) < 0)
@@ -1749,7 +1911,9 @@ static av_cold int j2kenc_init(AVCodecContext *avctx)
     codsty->log2_cblk_height = 4;
     codsty->transform        = s->pred ? FF_DWT53 : FF_DWT97_INT;
 
-    qntsty->nguardbits       = 1;
+    // the HT cleanup pass codes 2 * (magnitude - 1) + sign, which needs one
+    // more bit-plane than the magnitude itself
+    qntsty->nguardbits       = s->ht ? 2 : 1;
 
     if ((s->tile_width  & (s->tile_width -1)) ||
         (s->tile_height & (s->tile_height-1))) {
@@ -1784,6 +1948,12 @@ static av_cold int j2kenc_init(AVCodecContext *avctx)
     }
 
     ff_thread_once(&init_static_once, init_luts);
+    if (s->ht)
+        ff_jpeg2000_init_htenc_tables();
+
+    s->t1 = av_calloc(FFMAX(avctx->thread_count, 1), sizeof(*s->t1));
+    if (!s->t1)
+        return AVERROR(ENOMEM);
 
     init_quantization(s);
     if ((ret=init_tiles(s)) < 0)
@@ -1799,6 +1969,8 @@ static int j2kenc_destroy(AVCodecContext *avctx)
     Jpeg2000EncoderContext *s = avctx->priv_data;
 
     cleanup(s);
+    av_freep(&s->t1);
+    av_freep(&s->cblk_jobs);
     return 0;
 }
 
@@ -1824,6 +1996,7 @@ static const AVOption options[] = {
     { "pcrl",          NULL,                0,                     AV_OPT_TYPE_CONST,  { .i64 = JPEG2000_PGOD_PCRL }, 0,         0,           VE, .unit = "prog" },
     { "cprl",          NULL,                0,                     AV_OPT_TYPE_CONST,  { .i64 = JPEG2000_PGOD_CPRL }, 0,         0,           VE, .unit = "prog" },
     { "layer_rates",   "Layer Rates",       OFFSET(lr_str),        AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, VE },
+    { "ht",            "HT block coder",    OFFSET(ht),            AV_OPT_TYPE_INT,   { .i64 = 0           }, 0,         1,           VE, },
     { NULL }
 };
 
@@ -1840,7 +2013,7 @@ const FFCodec ff_jpeg2000_encoder = {
     .p.type         = AVMEDIA_TYPE_VIDEO,
     .p.id           = AV_CODEC_ID_JPEG2000,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE |
-                      AV_CODEC_CAP_FRAME_THREADS,
+                      AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS,
     .priv_data_size = sizeof(Jpeg2000EncoderContext),
     .init           = j2kenc_init,
     FF_CODEC_ENCODE_CB(encode_frame),
@@ -2394,6 +2394,7 @@ static void jpeg2000_dec_cleanup(Jpeg2000DecoderContext *s)
     memset(&s->poc  , 0, sizeof(s->poc));
     s->numXtiles = s->numYtiles = 0;
     s->ncomponents = 0;
+    s->in_tile_headers = 0;
 }
 
 static int jpeg2000_read_main_headers(Jpeg2000DecoderContext *s)
@@ -90,11 +90,31 @@ static void rct_int(void *_src0, void *_src1, void *_src2, int csize)
     }
 }
 
+static av_always_inline int32_t ht_dequant(uint32_t v, int shift)
+{
+    int32_t sign = (int32_t)v >> 31;
+    return ((int32_t)(v & INT32_MAX) ^ sign) - sign >> shift;
+}
+
+static void ht_dequant_quads_c(int32_t *dst0, int32_t *dst1, const uint32_t *src,
+                               int nb_quads, int shift)
+{
+    int i;
+
+    for (i = 0; i < nb_quads; i++) {
+        dst0[2 * i    ] = ht_dequant(src[4 * i    ], shift);
+        dst1[2 * i    ] = ht_dequant(src[4 * i + 1], shift);
+        dst0[2 * i + 1] = ht_dequant(src[4 * i + 2], shift);
+        dst1[2 * i + 1] = ht_dequant(src[4 * i + 3], shift);
+    }
+}
+
 av_cold void ff_jpeg2000dsp_init(Jpeg2000DSPContext *c)
 {
     c->mct_decode[FF_DWT97]     = ict_float;
     c->mct_decode[FF_DWT53]     = rct_int;
     c->mct_decode[FF_DWT97_INT] = ict_int;
+    c->ht_dequant_quads         = ht_dequant_quads_c;
 
 #if ARCH_RISCV
     ff_jpeg2000dsp_init_riscv(c);
@@ -28,6 +28,20 @@
 
 typedef struct Jpeg2000DSPContext {
     void (*mct_decode[FF_DWT_NB])(void *src0, void *src1, void *src2, int csize);
+    /**
+     * Reconstruct one row of quads of an HT code-block from the sign-magnitude
+     * samples of its cleanup pass.
+     *
+     * @param dst0     first output row, 2 * nb_quads samples
+     * @param dst1     second output row, 2 * nb_quads samples
+     * @param src      4 samples per quad in the order top-left, bottom-left,
+     *                 top-right, bottom-right
+     * @param nb_quads number of quads
+     * @param shift    arithmetic right shift applied after the conversion to
+     *                 two's complement
+     */
+    void (*ht_dequant_quads)(int32_t *dst0, int32_t *dst1, const uint32_t *src,
+                             int nb_quads, int shift);
 } Jpeg2000DSPContext;
 
 extern const float ff_jpeg2000_f_ict_params[4];
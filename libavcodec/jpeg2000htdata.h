@@ -0,0 +1,33 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVCODEC_JPEG2000HTDATA_H
+#define AVCODEC_JPEG2000HTDATA_H
+
+#include <stdint.h>
+
+/**
+ * CxtVLC decoding tables for the initial (table0) and the non-initial
+ * (table1) quad rows, indexed by (context << 7) | 7 bits of the codeword.
+ * Each entry packs the codeword length (bits 1-3), u_off (bit 0), rho
+ * (bits 4-7), e_k (bits 8-11) and e_1 (bits 12-15).
+ */
+extern const uint16_t ff_jpeg2000_ht_cxt_vlc_table0[1024];
+extern const uint16_t ff_jpeg2000_ht_cxt_vlc_table1[1024];
+
+#endif /* AVCODEC_JPEG2000HTDATA_H */
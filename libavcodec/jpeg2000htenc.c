@@ -0,0 +1,567 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * HT block encoder (Rec. ITU-T T.814 | ISO/IEC 15444-15), cleanup pass only.
+ *
+ * All magnitude bit-planes of a code-block are coded in a single HT cleanup
+ * pass. The segment consists of the forward growing MagSgn bit-stream
+ * followed by the MEL bit-stream and the backward growing VLC bit-stream,
+ * i.e. the mirror image of what jpeg2000htdec.c parses.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "libavutil/thread.h"
+#include "jpeg2000htdata.h"
+#include "jpeg2000htenc.h"
+
+#define HT_MAX_QUADS    2048
+#define HT_MAX_SUFFIX   4079 // largest Scup allowed by Rec. ITU-T T.814, 7.1
+
+/* See Rec. ITU-T T.800, Table 2 */
+static const uint8_t mel_e[13] = { 0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 4, 5 };
+
+/**
+ * CxtVLC encoding tables, indexed by [initial row][context][rho][u_off][eps]
+ * where eps is the set of samples whose exponent equals the exponent bound.
+ * Each entry holds the codeword in bits 0-6, its length in bits 7-9 and the
+ * e_k pattern in bits 10-13. Zero marks an unused combination.
+ */
+static uint16_t enc_cxt_vlc[2][8][16][2][16];
+
+typedef struct MelEncState {
+    uint8_t *buf;
+    int pos;
+    int max_bits;
+    int used_bits;
+    int tmp;
+    int run;
+    int k;
+} MelEncState;
+
+typedef struct VlcEncState {
+    uint8_t *buf;
+    int pos;
+    int used_bits;
+    int tmp;
+    int last_gt_8f;
+} VlcEncState;
+
+typedef struct MagSgnEncState {
+    uint8_t *buf;
+    int pos;
+    int size;
+    int max_bits;
+    int used_bits;
+    int tmp;
+} MagSgnEncState;
+
+typedef struct HTQuad {
+    uint8_t rho;     ///< significance pattern
+    uint8_t u_off;
+    uint8_t e_k;
+    uint8_t U;       ///< exponent bound
+    uint16_t cwd;    ///< CxtVLC codeword
+    uint8_t len;     ///< CxtVLC codeword length
+    uint32_t v[4];   ///< MagSgn values 2 * (mu - 1) + sign
+} HTQuad;
+
+typedef struct HTEncContext {
+    MelEncState    mel;
+    VlcEncState    vlc;
+    MagSgnEncState ms;
+    int overflow;
+    uint8_t E[4 * HT_MAX_QUADS];
+    uint8_t rho[HT_MAX_QUADS];
+    uint8_t mel_buf[HT_MAX_SUFFIX];
+    uint8_t vlc_buf[HT_MAX_SUFFIX];
+} HTEncContext;
+
+static av_cold void init_enc_cxt_vlc(int initial, const uint16_t *table)
+{
+    uint8_t cost[8][16][2][16];
+
+    memset(cost, 0xFF, sizeof(cost));
+
+    for (int idx = 0; idx < 1024; idx++) {
+        int v     = table[idx];
+        int ctx   = idx >> 7;
+        int len   = (v & 0xF) >> 1;
+        int u_off = v & 1;
+        int rho   = (v >> 4) & 0xF;
+        int e_k   = (v >> 8) & 0xF;
+        int e_1   = v >> 12;
+        int c     = len - av_popcount(e_k);
+
+        if (!len)
+            continue;
+
+        for (int eps = 0; eps < 16; eps++) {
+            /* every sample flagged in e_k must match its e_1 bit */
+            if ((eps & ~rho) || ((eps ^ e_1) & e_k) || (u_off && !eps) || (!u_off && eps))
+                continue;
+            if (c < cost[ctx][rho][u_off][eps]) {
+                cost[ctx][rho][u_off][eps] = c;
+                enc_cxt_vlc[initial][ctx][rho][u_off][eps] =
+                    (idx & ((1 << len) - 1)) | len << 7 | e_k << 10;
+            }
+        }
+    }
+}
+
+static av_cold void init_htenc_tables(void)
+{
+    init_enc_cxt_vlc(0, ff_jpeg2000_ht_cxt_vlc_table1);
+    init_enc_cxt_vlc(1, ff_jpeg2000_ht_cxt_vlc_table0);
+}
+
+av_cold void ff_jpeg2000_init_htenc_tables(void)
+{
+    static AVOnce init_static_once = AV_ONCE_INIT;
+    ff_thread_once(&init_static_once, init_htenc_tables);
+}
+
+static void mel_emit_bit(HTEncContext *h, int bit)
+{
+    MelEncState *mel = &h->mel;
+
+    mel->tmp = (mel->tmp << 1) | bit;
+    if (++mel->used_bits == mel->max_bits) {
+        if (mel->pos >= HT_MAX_SUFFIX) {
+            h->overflow = 1;
+            return;
+        }
+        mel->buf[mel->pos++] = mel->tmp;
+        mel->max_bits = mel->tmp == 0xFF ? 7 : 8;
+        mel->tmp = 0;
+        mel->used_bits = 0;
+    }
+}
+
+/**
+ * Adaptive run-length coding of one MEL symbol, mirror image of
+ * jpeg2000_decode_mel_sym().
+ */
+static void mel_encode(HTEncContext *h, int sym)
+{
+    MelEncState *mel = &h->mel;
+    int eval = mel_e[mel->k];
+
+    if (!sym) {
+        if (++mel->run >= 1 << eval) {
+            mel_emit_bit(h, 1);
+            mel->run = 0;
+            mel->k = FFMIN(12, mel->k + 1);
+        }
+    } else {
+        mel_emit_bit(h, 0);
+        while (eval > 0)
+            mel_emit_bit(h, (mel->run >> --eval) & 1);
+        mel->run = 0;
+        mel->k = FFMAX(0, mel->k - 1);
+    }
+}
+
+/**
+ * Append bits to the VLC bit-stream, least significant bit first, inserting
+ * a stuffing bit after any byte larger than 0x8F whose successor would
+ * otherwise have its 7 LSBs set.
+ */
+static void vlc_encode(HTEncContext *h, unsigned cwd, int len)
+{
+    VlcEncState *vlc = &h->vlc;
+
+    while (len > 0) {
+        int avail = 8 - vlc->last_gt_8f - vlc->used_bits;
+        int t     = FFMIN(avail, len);
+
+        vlc->tmp |= (cwd & ((1 << t) - 1)) << vlc->used_bits;
+        vlc->used_bits += t;
+        avail -= t;
+        len   -= t;
+        cwd  >>= t;
+        if (!avail) {
+            if (vlc->last_gt_8f && vlc->tmp != 0x7F) {
+                vlc->last_gt_8f = 0;
+                continue;
+            }
+            if (vlc->pos >= HT_MAX_SUFFIX) {
+                h->overflow = 1;
+                return;
+            }
+            vlc->buf[vlc->pos++] = vlc->tmp;
+            vlc->last_gt_8f = vlc->tmp > 0x8F;
+            vlc->tmp = 0;
+            vlc->used_bits = 0;
+        }
+    }
+}
+
+/**
+ * Append bits to the MagSgn bit-stream, least significant bit first; a byte
+ * following 0xFF only carries 7 bits.
+ */
+static void ms_encode(HTEncContext *h, uint32_t cwd, int len)
+{
+    MagSgnEncState *ms = &h->ms;
+
+    while (len > 0) {
+        int t = FFMIN(ms->max_bits - ms->used_bits, len);
+
+        ms->tmp |= (cwd & ((1U << t) - 1)) << ms->used_bits;
+        ms->used_bits += t;
+        cwd >>= t;
+        len  -= t;
+        if (ms->used_bits == ms->max_bits) {
+            if (ms->pos >= ms->size) {
+                h->overflow = 1;
+                return;
+            }
+            ms->buf[ms->pos++] = ms->tmp;
+            ms->max_bits = ms->tmp == 0xFF ? 7 : 8;
+            ms->tmp = 0;
+            ms->used_bits = 0;
+        }
+    }
+}
+
+/**
+ * Code the u value of a quad as prefix, suffix and extension; see
+ * decodeUPrefix, decodeUSuffix and decodeUExtension in Rec. ITU-T T.814,
+ * 7.3.6. The three parts are returned as (codeword, length) pairs.
+ */
+static void u_code(int u, int code[3][2])
+{
+    memset(code, 0, 3 * sizeof(*code));
+    if (u == 1) {
+        code[0][0] = 1; code[0][1] = 1;
+    } else if (u == 2) {
+        code[0][0] = 2; code[0][1] = 2;
+    } else if (u <= 4) {
+        code[0][0] = 4; code[0][1] = 3;
+        code[1][0] = u - 3; code[1][1] = 1;
+    } else {
+        int s = u - 5;
+        code[0][1] = 3;
+        code[1][1] = 5;
+        if (s < 28) {
+            code[1][0] = s;
+        } else {
+            code[1][0] = 28 + ((s - 28) & 3);
+            code[2][0] = (s - 28) >> 2;
+            code[2][1] = 4;
+        }
+    }
+}
+
+static void encode_u_pair(HTEncContext *h, int u1, int u2)
+{
+    int c1[3][2], c2[3][2];
+
+    u_code(u1, c1);
+    u_code(u2, c2);
+    for (int i = 0; i < 3; i++) {
+        vlc_encode(h, c1[i][0], c1[i][1]);
+        vlc_encode(h, c2[i][0], c2[i][1]);
+    }
+}
+
+static void encode_u(HTEncContext *h, int u)
+{
+    int c[3][2];
+
+    u_code(u, c);
+    for (int i = 0; i < 3; i++)
+        vlc_encode(h, c[i][0], c[i][1]);
+}
+
+/**
+ * Gather the samples of quad (qx, qy) and derive its significance pattern
+ * and exponents. Samples are ordered (x, y), (x, y + 1), (x + 1, y),
+ * (x + 1, y + 1) like in the decoder.
+ */
+static void load_quad(HTEncContext *h, HTQuad *quad, const int *data, int stride,
+                      int width, int height, int qx, int qy, int qw, int *max_e)
+{
+    int q = qy * qw + qx;
+
+    quad->rho = 0;
+    *max_e = 0;
+    for (int i = 0; i < 4; i++) {
+        int x = 2 * qx + (i >> 1);
+        int y = 2 * qy + (i & 1);
+        int val = x < width && y < height ? data[y * stride + x] : 0;
+
+        h->E[4 * q + i] = 0;
+        quad->v[i] = 0;
+        if (val) {
+            uint32_t mu = FFABS(val);
+            quad->v[i] = 2 * (mu - 1) + (val < 0);
+            h->E[4 * q + i] = av_log2(quad->v[i] | 1) + 1;
+            quad->rho |= 1 << i;
+            *max_e = FFMAX(*max_e, h->E[4 * q + i]);
+        }
+    }
+    h->rho[q] = quad->rho;
+}
+
+/**
+ * Select the exponent bound and the CxtVLC codeword for a quad whose exponent
+ * predictor is kappa.
+ */
+static void prepare_quad(HTEncContext *h, HTQuad *quad, int initial, int ctx,
+                         int kappa, int max_e, int q)
+{
+    int eps = 0;
+    unsigned entry;
+
+    quad->u_off = max_e > kappa;
+    quad->U     = FFMAX(max_e, kappa);
+    if (quad->u_off)
+        for (int i = 0; i < 4; i++)
+            eps |= (h->E[4 * q + i] == quad->U) << i;
+
+    entry = enc_cxt_vlc[initial][ctx][quad->rho][quad->u_off][eps];
+    quad->cwd = entry & 0x7F;
+    quad->len = (entry >> 7) & 7;
+    quad->e_k = entry >> 10;
+}
+
+static void encode_sig(HTEncContext *h, const HTQuad *quad, int ctx)
+{
+    if (!ctx) {
+        mel_encode(h, quad->rho != 0);
+        if (!quad->rho)
+            return;
+    }
+    vlc_encode(h, quad->cwd, quad->len);
+}
+
+static void encode_mag_sgn(HTEncContext *h, const HTQuad *quad)
+{
+    for (int i = 0; i < 4; i++)
+        if ((quad->rho >> i) & 1)
+            ms_encode(h, quad->v[i], quad->U - ((quad->e_k >> i) & 1));
+}
+
+static int initial_row_context(int rho)
+{
+    return ((rho & 1) | ((rho >> 1) & 1)) + (((rho >> 2) & 1) << 1) + (((rho >> 3) & 1) << 2);
+}
+
+static int row_context(const HTEncContext *h, int q, int qx, int qw)
+{
+    const uint8_t *rho = h->rho;
+    int above = q - qw;
+    int ctx   = ((rho[above] >> 1) & 1) + (((rho[above] >> 3) & 1) << 2);
+
+    if (qx > 0) {
+        ctx |= (rho[above - 1] >> 3) & 1;
+        ctx += (((rho[q - 1] >> 3) | (rho[q - 1] >> 2)) & 1) << 1;
+    }
+    if (qx < qw - 1)
+        ctx |= ((rho[above + 1] >> 1) & 1) << 2;
+    return ctx;
+}
+
+static int row_kappa(const HTEncContext *h, int rho, int q, int qx, int qw)
+{
+    const uint8_t *E = h->E + 4 * (q - qw);
+    int max_e;
+
+    if (av_popcount(rho) < 2)
+        return 1;
+
+    max_e = FFMAX(E[1], E[3]);
+    if (qx > 0)
+        max_e = FFMAX(max_e, E[-1]);
+    if (qx < qw - 1)
+        max_e = FFMAX(max_e, E[5]);
+    return FFMAX(1, max_e - 1);
+}
+
+int ff_jpeg2000_encode_htj2k(uint8_t *buf, int buf_size, const int *data,
+                             int stride, int width, int height)
+{
+    HTEncContext h;
+    HTQuad quad[2];
+    const int qw = (width  + 1) >> 1;
+    const int qh = (height + 1) >> 1;
+    int max_e[2];
+    int ctx = 0;
+    int Pcup, Scup, Lcup;
+
+    if (qw * qh > HT_MAX_QUADS)
+        return AVERROR(EINVAL);
+
+    h.overflow = 0;
+
+    h.mel.buf            = h.mel_buf;
+    h.mel.pos            = 0;
+    h.mel.max_bits       = 8;
+    h.mel.used_bits      = 0;
+    h.mel.tmp            = 0;
+    h.mel.run            = 0;
+    h.mel.k              = 0;
+
+    /* The first VLC byte and the low nibble of the second one are replaced
+     * by Scup once the segment is complete. */
+    h.vlc.buf        = h.vlc_buf;
+    h.vlc.buf[0]     = 0xFF;
+    h.vlc.pos        = 1;
+    h.vlc.used_bits  = 4;
+    h.vlc.tmp        = 0xF;
+    h.vlc.last_gt_8f = 1;
+
+    h.ms.buf       = buf;
+    h.ms.pos       = 0;
+    h.ms.size      = buf_size;
+    h.ms.max_bits  = 8;
+    h.ms.used_bits = 0;
+    h.ms.tmp       = 0;
+
+    /* initial quad row */
+    for (int qx = 0; qx < qw; qx += 2) {
+        int pair = qx + 1 < qw;
+        int ctx1 = ctx, ctx2;
+
+        load_quad(&h, &quad[0], data, stride, width, height, qx, 0, qw, &max_e[0]);
+        prepare_quad(&h, &quad[0], 1, ctx1, 1, max_e[0], qx);
+        encode_sig(&h, &quad[0], ctx1);
+        ctx = initial_row_context(quad[0].rho);
+
+        if (!pair) {
+            if (quad[0].u_off)
+                encode_u(&h, quad[0].U - 1);
+            encode_mag_sgn(&h, &quad[0]);
+            break;
+        }
+
+        ctx2 = ctx;
+        load_quad(&h, &quad[1], data, stride, width, height, qx + 1, 0, qw, &max_e[1]);
+        prepare_quad(&h, &quad[1], 1, ctx2, 1, max_e[1], qx + 1);
+        encode_sig(&h, &quad[1], ctx2);
+        ctx = initial_row_context(quad[1].rho);
+
+        if (quad[0].u_off && quad[1].u_off) {
+            int u1 = quad[0].U - 1, u2 = quad[1].U - 1;
+
+            if (u1 > 2 && u2 > 2) {
+                mel_encode(&h, 1);
+                encode_u_pair(&h, u1 - 2, u2 - 2);
+            } else {
+                mel_encode(&h, 0);
+                if (u1 > 2) {
+                    int c[3][2];
+                    u_code(u1, c);
+                    vlc_encode(&h, c[0][0], c[0][1]);
+                    vlc_encode(&h, u2 - 1, 1);
+                    vlc_encode(&h, c[1][0], c[1][1]);
+                    vlc_encode(&h, c[2][0], c[2][1]);
+                } else {
+                    encode_u_pair(&h, u1, u2);
+                }
+            }
+        } else if (quad[0].u_off) {
+            encode_u(&h, quad[0].U - 1);
+        } else if (quad[1].u_off) {
+            encode_u(&h, quad[1].U - 1);
+        }
+        encode_mag_sgn(&h, &quad[0]);
+        encode_mag_sgn(&h, &quad[1]);
+    }
+
+    /* non-initial quad rows */
+    for (int qy = 1; qy < qh; qy++) {
+        for (int qx = 0; qx < qw; qx += 2) {
+            int n = FFMIN(2, qw - qx);
+            int kappa[2] = { 1, 1 };
+
+            for (int j = 0; j < n; j++) {
+                int q = qy * qw + qx + j;
+
+                load_quad(&h, &quad[j], data, stride, width, height, qx + j, qy, qw, &max_e[j]);
+                ctx      = row_context(&h, q, qx + j, qw);
+                kappa[j] = row_kappa(&h, quad[j].rho, q, qx + j, qw);
+                prepare_quad(&h, &quad[j], 0, ctx, kappa[j], max_e[j], q);
+                encode_sig(&h, &quad[j], ctx);
+            }
+
+            if (n == 2 && quad[0].u_off && quad[1].u_off)
+                encode_u_pair(&h, quad[0].U - kappa[0], quad[1].U - kappa[1]);
+            else
+                for (int j = 0; j < n; j++)
+                    if (quad[j].u_off)
+                        encode_u(&h, quad[j].U - kappa[j]);
+
+            for (int j = 0; j < n; j++)
+                encode_mag_sgn(&h, &quad[j]);
+        }
+    }
+
+    /* terminate the MagSgn bit-stream, padding with 1s which the decoder
+     * assumes past the end of the segment anyway */
+    if (h.ms.used_bits) {
+        int t = h.ms.max_bits - h.ms.used_bits;
+        h.ms.tmp |= ((1 << t) - 1) << h.ms.used_bits;
+        if (h.ms.tmp != 0xFF) {
+            if (h.ms.pos >= h.ms.size)
+                return AVERROR(ENOSPC);
+            h.ms.buf[h.ms.pos++] = h.ms.tmp;
+        }
+    } else if (h.ms.max_bits == 7) {
+        h.ms.pos--;
+    }
+
+    /* terminate MEL and VLC without fusing their last bytes */
+    if (h.mel.run > 0)
+        mel_emit_bit(&h, 1);
+    if (h.mel.used_bits) {
+        if (h.mel.pos >= HT_MAX_SUFFIX)
+            return AVERROR(ENOSPC);
+        h.mel_buf[h.mel.pos++] = h.mel.tmp << (h.mel.max_bits - h.mel.used_bits);
+    }
+    if (h.vlc.used_bits) {
+        if (h.vlc.pos >= HT_MAX_SUFFIX)
+            return AVERROR(ENOSPC);
+        h.vlc_buf[h.vlc.pos++] = h.vlc.tmp;
+    }
+    if (h.overflow)
+        return AVERROR(ENOSPC);
+
+    Pcup = h.ms.pos;
+    Scup = h.mel.pos + h.vlc.pos;
+    Lcup = Pcup + Scup;
+    if (Scup > HT_MAX_SUFFIX || Lcup > buf_size)
+        return AVERROR(ENOSPC);
+
+    memcpy(buf + Pcup, h.mel_buf, h.mel.pos);
+    for (int i = 0; i < h.vlc.pos; i++)
+        buf[Lcup - 1 - i] = h.vlc_buf[i];
+
+    buf[Lcup - 1] = Scup >> 4;
+    buf[Lcup - 2] = (buf[Lcup - 2] & 0xF0) | (Scup & 0x0F);
+
+    return Lcup;
+}
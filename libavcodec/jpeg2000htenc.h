@@ -0,0 +1,50 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVCODEC_JPEG2000HTENC_H
+#define AVCODEC_JPEG2000HTENC_H
+
+#include <stdint.h>
+
+/**
+ * HT Block encoder as specified in Rec. ITU-T T.814 | ISO/IEC 15444-15
+ */
+
+/**
+ * Initialize the static CxtVLC encoding tables. Must be called once before
+ * ff_jpeg2000_encode_htj2k().
+ */
+void ff_jpeg2000_init_htenc_tables(void);
+
+/**
+ * Encode a code-block as a single HT cleanup pass covering all magnitude
+ * bit-planes.
+ *
+ * @param buf      output buffer for the HT cleanup segment
+ * @param buf_size size of buf in bytes
+ * @param data     quantization indices in two's complement
+ * @param stride   stride of data in elements
+ * @param width    code-block width, at most 1024
+ * @param height   code-block height, width * height must not exceed 4096
+ * @return length of the HT cleanup segment (Lcup) on success, a negative
+ *         error code otherwise
+ */
+int ff_jpeg2000_encode_htj2k(uint8_t *buf, int buf_size, const int *data,
+                             int stride, int width, int height);
+
+#endif /* AVCODEC_JPEG2000HTENC_H */
@@ -257,6 +257,7 @@ typedef struct MpegEncContext {
     int motion_est;                      ///< ME algorithm
     int me_penalty_compensation;
     int me_pre;                          ///< prepass for motion estimation
+    struct MPVWavefrontME *wavefront_me; ///< MB row wavefront motion estimation state, NULL if unused
     int mv_dir;
 #define MV_DIR_FORWARD   1
 #define MV_DIR_BACKWARD  2
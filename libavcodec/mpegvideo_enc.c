@@ -33,6 +33,7 @@
 
 #include "config_components.h"
 
+#include <stdatomic.h>
 #include <stdint.h>
 
 #include "libavutil/emms.h"
@@ -347,6 +348,58 @@ static av_cold int me_cmp_init(MpegEncContext *s, AVCodecContext *avctx)
     return 0;
 }
 
+typedef struct MPVWavefrontME {
+    AVMutex mutex;
+    AVCond  cond;
+    atomic_int row_progress[]; ///< number of MBs of each row with final motion vectors
+} MPVWavefrontME;
+
+/**
+ * Let the slice thread contexts estimate motion for successive MB rows in
+ * parallel while the picture is coded as a single slice by the main context.
+ * Row y only starts a MB once row y - 1 is past its top right neighbour, so
+ * the predictors and thus the motion vectors match single threaded ME.
+ */
+static av_cold int init_wavefront_me(MpegEncContext *s)
+{
+    AVCodecContext *const avctx = s->avctx;
+    MPVWavefrontME *wf;
+
+    /* The execute2() thread index selects the context, last_pred reads
+     * vectors from rows below, intra-only formats have no ME. */
+    if (s->slice_context_count < 2 || avctx->slices ||
+        s->slice_context_count != avctx->thread_count ||
+        avctx->last_predictor_count ||
+        s->out_format == FMT_MJPEG || s->out_format == FMT_SPEEDHQ) {
+        av_log(avctx, AV_LOG_WARNING, "wavefront_me requires slice threading "
+               "without slices or last_pred, ignoring it\n");
+        return 0;
+    }
+
+    wf = av_mallocz(sizeof(*wf) + s->mb_height * sizeof(*wf->row_progress));
+    if (!wf)
+        return AVERROR(ENOMEM);
+    if (ff_mutex_init(&wf->mutex, NULL)) {
+        av_free(wf);
+        return AVERROR(ENOMEM);
+    }
+    if (ff_cond_init(&wf->cond, NULL)) {
+        ff_mutex_destroy(&wf->mutex);
+        av_free(wf);
+        return AVERROR(ENOMEM);
+    }
+    s->wavefront_me = wf;
+
+    /* All contexts span the whole picture: the duplicates only estimate
+     * motion for the rows handed to them, the main context codes them all. */
+    for (int i = 0; i < s->slice_context_count; i++) {
+        s->thread_context[i]->start_mb_y = 0;
+        s->thread_context[i]->end_mb_y   = s->mb_height;
+    }
+
+    return 0;
+}
+
 /* init video encoder */
 av_cold int ff_mpv_encode_init(AVCodecContext *avctx)
 {
@@ -944,7 +997,13 @@ av_cold int ff_mpv_encode_init(AVCodecContext *avctx)
     if ((CONFIG_H263P_ENCODER || CONFIG_RV20_ENCODER) && s->modified_quant)
         s->chroma_qscale_table = ff_h263_chroma_qscale_table;
 
-    if (s->slice_context_count > 1) {
+    if (s->mpv_flags & FF_MPV_FLAG_WAVEFRONT_ME) {
+        ret = init_wavefront_me(s);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (s->slice_context_count > 1 && !s->wavefront_me) {
         s->rtp_mode = 1;
 
         if (avctx->codec_id == AV_CODEC_ID_H263P)
@@ -1032,6 +1091,12 @@ av_cold int ff_mpv_encode_end(AVCodecContext *avctx)
 
     ff_rate_control_uninit(&s->rc_context);
 
+    if (s->wavefront_me) {
+        ff_cond_destroy(&s->wavefront_me->cond);
+        ff_mutex_destroy(&s->wavefront_me->mutex);
+        av_freep(&s->wavefront_me);
+    }
+
     ff_mpv_common_end(s);
     ff_refstruct_pool_uninit(&s->picture_pool);
 
@@ -1377,31 +1442,125 @@ static int encode_frame(AVCodecContext *c, const AVFrame *frame, AVPacket *pkt)
     return size;
 }
 
+typedef struct BCountContext {
+    int p_lambda, b_lambda, lambda2;
+    int64_t rd[MAX_B_FRAMES + 1];
+} BCountContext;
+
+static int encode_frame_as(AVCodecContext *c, AVFrame *dst, const AVFrame *src,
+                           enum AVPictureType pict_type, int quality, AVPacket *pkt)
+{
+    int ret = av_frame_ref(dst, src);
+    if (ret < 0)
+        return ret;
+
+    dst->pict_type = pict_type;
+    dst->quality   = quality;
+
+    ret = encode_frame(c, dst, pkt);
+    av_frame_unref(dst);
+    return ret;
+}
+
+/**
+ * Encode the downscaled lookahead pictures with j B-frames between the
+ * P-frames and store the resulting rate-distortion cost in b->rd[j].
+ * The candidates are independent of each other and run as execute2() jobs.
+ */
+static int encode_b_count_candidate(AVCodecContext *avctx, void *arg, int j, int threadnr)
+{
+    MpegEncContext *const s = avctx->priv_data;
+    BCountContext *const b  = arg;
+    AVCodecContext *c = avcodec_alloc_context3(NULL);
+    AVFrame *frame    = av_frame_alloc();
+    AVPacket *pkt     = av_packet_alloc();
+    int64_t rd = 0;
+    int i, out_size, ret;
+
+    if (!c || !frame || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    c->width        = s->width  >> s->brd_scale;
+    c->height       = s->height >> s->brd_scale;
+    c->flags        = AV_CODEC_FLAG_QSCALE | AV_CODEC_FLAG_PSNR;
+    c->flags       |= s->avctx->flags & AV_CODEC_FLAG_QPEL;
+    c->mb_decision  = s->avctx->mb_decision;
+    c->me_cmp       = s->avctx->me_cmp;
+    c->mb_cmp       = s->avctx->mb_cmp;
+    c->me_sub_cmp   = s->avctx->me_sub_cmp;
+    c->pix_fmt      = AV_PIX_FMT_YUV420P;
+    c->time_base    = s->avctx->time_base;
+    c->max_b_frames = s->max_b_frames;
+
+    ret = avcodec_open2(c, s->avctx->codec, NULL);
+    if (ret < 0)
+        goto fail;
+
+    out_size = encode_frame_as(c, frame, s->tmp_frames[0],
+                               AV_PICTURE_TYPE_I, 1 * FF_QP2LAMBDA, pkt);
+    if (out_size < 0) {
+        ret = out_size;
+        goto fail;
+    }
+
+    //rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
+
+    for (i = 0; i < s->max_b_frames + 1; i++) {
+        int is_p = i % (j + 1) == j || i == s->max_b_frames;
+
+        out_size = encode_frame_as(c, frame, s->tmp_frames[i + 1],
+                                   is_p ? AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_B,
+                                   is_p ? b->p_lambda : b->b_lambda, pkt);
+        if (out_size < 0) {
+            ret = out_size;
+            goto fail;
+        }
+
+        rd += (out_size * (uint64_t)b->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+    }
+
+    /* get the delayed frames */
+    out_size = encode_frame(c, NULL, pkt);
+    if (out_size < 0) {
+        ret = out_size;
+        goto fail;
+    }
+    rd += (out_size * (uint64_t)b->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+
+    rd += c->error[0] + c->error[1] + c->error[2];
+
+    b->rd[j] = rd;
+
+fail:
+    avcodec_free_context(&c);
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    return ret;
+}
+
 static int estimate_best_b_count(MpegEncContext *s)
 {
-    AVPacket *pkt;
+    BCountContext b;
     const int scale = s->brd_scale;
     int width  = s->width  >> scale;
     int height = s->height >> scale;
-    int i, j, out_size, p_lambda, b_lambda, lambda2;
+    int i, j, nb_candidates;
     int64_t best_rd  = INT64_MAX;
     int best_b_count = -1;
-    int ret = 0;
+    int ret[MAX_B_FRAMES + 1];
 
     av_assert0(scale >= 0 && scale <= 3);
 
-    pkt = av_packet_alloc();
-    if (!pkt)
-        return AVERROR(ENOMEM);
-
     //emms_c();
-    p_lambda = s->last_lambda_for[AV_PICTURE_TYPE_P];
+    b.p_lambda = s->last_lambda_for[AV_PICTURE_TYPE_P];
     //p_lambda * FFABS(s->avctx->b_quant_factor) + s->avctx->b_quant_offset;
-    b_lambda = s->last_lambda_for[AV_PICTURE_TYPE_B];
-    if (!b_lambda) // FIXME we should do this somewhere else
-        b_lambda = p_lambda;
-    lambda2  = (b_lambda * b_lambda + (1 << FF_LAMBDA_SHIFT) / 2) >>
-               FF_LAMBDA_SHIFT;
+    b.b_lambda = s->last_lambda_for[AV_PICTURE_TYPE_B];
+    if (!b.b_lambda) // FIXME we should do this somewhere else
+        b.b_lambda = b.p_lambda;
+    b.lambda2  = (b.b_lambda * b.b_lambda + (1 << FF_LAMBDA_SHIFT) / 2) >>
+                 FF_LAMBDA_SHIFT;
 
     for (i = 0; i < s->max_b_frames + 2; i++) {
         const MPVPicture *pre_input_ptr = i ? s->input_picture[i - 1] :
@@ -1435,89 +1594,25 @@ static int estimate_best_b_count(MpegEncContext *s)
         }
     }
 
-    for (j = 0; j < s->max_b_frames + 1; j++) {
-        AVCodecContext *c;
-        int64_t rd = 0;
-
-        if (!s->input_picture[j])
+    for (nb_candidates = 0; nb_candidates < s->max_b_frames + 1; nb_candidates++)
+        if (!s->input_picture[nb_candidates])
             break;
-
-        c = avcodec_alloc_context3(NULL);
-        if (!c) {
-            ret = AVERROR(ENOMEM);
-            goto fail;
-        }
-
-        c->width        = width;
-        c->height       = height;
-        c->flags        = AV_CODEC_FLAG_QSCALE | AV_CODEC_FLAG_PSNR;
-        c->flags       |= s->avctx->flags & AV_CODEC_FLAG_QPEL;
-        c->mb_decision  = s->avctx->mb_decision;
-        c->me_cmp       = s->avctx->me_cmp;
-        c->mb_cmp       = s->avctx->mb_cmp;
-        c->me_sub_cmp   = s->avctx->me_sub_cmp;
-        c->pix_fmt      = AV_PIX_FMT_YUV420P;
-        c->time_base    = s->avctx->time_base;
-        c->max_b_frames = s->max_b_frames;
-
-        ret = avcodec_open2(c, s->avctx->codec, NULL);
-        if (ret < 0)
-            goto fail;
-
-
-        s->tmp_frames[0]->pict_type = AV_PICTURE_TYPE_I;
-        s->tmp_frames[0]->quality   = 1 * FF_QP2LAMBDA;
-
-        out_size = encode_frame(c, s->tmp_frames[0], pkt);
-        if (out_size < 0) {
-            ret = out_size;
-            goto fail;
-        }
-
-        //rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
-
-        for (i = 0; i < s->max_b_frames + 1; i++) {
-            int is_p = i % (j + 1) == j || i == s->max_b_frames;
-
-            s->tmp_frames[i + 1]->pict_type = is_p ?
-                                     AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_B;
-            s->tmp_frames[i + 1]->quality   = is_p ? p_lambda : b_lambda;
-
-            out_size = encode_frame(c, s->tmp_frames[i + 1], pkt);
-            if (out_size < 0) {
-                ret = out_size;
-                goto fail;
-            }
-
-            rd += (out_size * (uint64_t)lambda2) >> (FF_LAMBDA_SHIFT - 3);
-        }
-
-        /* get the delayed frames */
-        out_size = encode_frame(c, NULL, pkt);
-        if (out_size < 0) {
-            ret = out_size;
-            goto fail;
-        }
-        rd += (out_size * (uint64_t)lambda2) >> (FF_LAMBDA_SHIFT - 3);
-
-        rd += c->error[0] + c->error[1] + c->error[2];
-
-        if (rd < best_rd) {
-            best_rd = rd;
+    if (!nb_candidates)
+        return best_b_count;
+
+    /* Every candidate B-frame count is evaluated by its own sub-encoder,
+     * so they can run concurrently on the slice threads. */
+    s->avctx->execute2(s->avctx, encode_b_count_candidate, &b, ret, nb_candidates);
+
+    for (j = 0; j < nb_candidates; j++) {
+        if (ret[j] < 0)
+            return ret[j];
+        if (b.rd[j] < best_rd) {
+            best_rd = b.rd[j];
             best_b_count = j;
         }
-
-fail:
-        avcodec_free_context(&c);
-        av_packet_unref(pkt);
-        if (ret < 0) {
-            best_b_count = ret;
-            break;
-        }
     }
 
-    av_packet_free(&pkt);
-
     return best_b_count;
 }
 
@@ -1795,7 +1890,7 @@ int ff_mpv_encode_picture(AVCodecContext *avctx, AVPacket *pkt,
 {
     MpegEncContext *s = avctx->priv_data;
     int stuffing_count, ret;
-    int context_count = s->slice_context_count;
+    int context_count = s->wavefront_me ? 1 : s->slice_context_count;
 
     ff_mpv_unref_picture(&s->cur_pic);
 
@@ -2715,6 +2810,20 @@ static int pre_estimate_motion_thread(AVCodecContext *c, void *arg){
     return 0;
 }
 
+static void estimate_motion_mb(MpegEncContext *s)
+{
+    s->block_index[0]+=2;
+    s->block_index[1]+=2;
+    s->block_index[2]+=2;
+    s->block_index[3]+=2;
+
+    /* compute motion vector & mb_type and store in context */
+    if(s->pict_type==AV_PICTURE_TYPE_B)
+        ff_estimate_b_frame_motion(s, s->mb_x, s->mb_y);
+    else
+        ff_estimate_p_frame_motion(s, s->mb_x, s->mb_y);
+}
+
 static int estimate_motion_thread(AVCodecContext *c, void *arg){
     MpegEncContext *s= *(void**)arg;
 
@@ -2723,43 +2832,84 @@ static int estimate_motion_thread(AVCodecContext *c, void *arg){
     for(s->mb_y= s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x=0; //for block init below
         ff_init_block_index(s);
-        for(s->mb_x=0; s->mb_x < s->mb_width; s->mb_x++) {
-            s->block_index[0]+=2;
-            s->block_index[1]+=2;
-            s->block_index[2]+=2;
-            s->block_index[3]+=2;
-
-            /* compute motion vector & mb_type and store in context */
-            if(s->pict_type==AV_PICTURE_TYPE_B)
-                ff_estimate_b_frame_motion(s, s->mb_x, s->mb_y);
-            else
-                ff_estimate_p_frame_motion(s, s->mb_x, s->mb_y);
-        }
+        for(s->mb_x=0; s->mb_x < s->mb_width; s->mb_x++)
+            estimate_motion_mb(s);
         s->first_slice_line=0;
     }
     return 0;
 }
 
+static void wavefront_me_wait(MPVWavefrontME *wf, int mb_y, int progress)
+{
+    if (atomic_load_explicit(&wf->row_progress[mb_y], memory_order_acquire) >= progress)
+        return;
+
+    ff_mutex_lock(&wf->mutex);
+    while (atomic_load_explicit(&wf->row_progress[mb_y], memory_order_relaxed) < progress)
+        ff_cond_wait(&wf->cond, &wf->mutex);
+    ff_mutex_unlock(&wf->mutex);
+}
+
+static void wavefront_me_report(MPVWavefrontME *wf, int mb_y, int progress)
+{
+    atomic_store_explicit(&wf->row_progress[mb_y], progress, memory_order_release);
+
+    ff_mutex_lock(&wf->mutex);
+    ff_cond_broadcast(&wf->cond);
+    ff_mutex_unlock(&wf->mutex);
+}
+
+static int estimate_motion_row(AVCodecContext *avctx, void *arg, int mb_y, int threadnr)
+{
+    MpegEncContext *const m  = avctx->priv_data;
+    MpegEncContext *const s  = m->thread_context[threadnr];
+    MPVWavefrontME *const wf = m->wavefront_me;
+
+    s->me.dia_size = avctx->dia_size;
+    s->first_slice_line = !mb_y;
+    s->mb_y = mb_y;
+    s->mb_x = 0;
+    ff_init_block_index(s);
+    for (s->mb_x = 0; s->mb_x < s->mb_width; s->mb_x++) {
+        if (mb_y)
+            wavefront_me_wait(wf, mb_y - 1, FFMIN(s->mb_x + 2, s->mb_width));
+        estimate_motion_mb(s);
+        wavefront_me_report(wf, mb_y, s->mb_x + 1);
+    }
+    return 0;
+}
+
+static void mb_var_row(MpegEncContext *s, int mb_y)
+{
+    for (int mb_x = 0; mb_x < s->mb_width; mb_x++) {
+        int xx = mb_x * 16;
+        int yy = mb_y * 16;
+        const uint8_t *pix = s->new_pic->data[0] + (yy * s->linesize) + xx;
+        int varc;
+        int sum = s->mpvencdsp.pix_sum(pix, s->linesize);
+
+        varc = (s->mpvencdsp.pix_norm1(pix, s->linesize) -
+                (((unsigned) sum * sum) >> 8) + 500 + 128) >> 8;
+
+        s->mb_var [s->mb_stride * mb_y + mb_x] = varc;
+        s->mb_mean[s->mb_stride * mb_y + mb_x] = (sum+128)>>8;
+        s->me.mb_var_sum_temp    += varc;
+    }
+}
+
 static int mb_var_thread(AVCodecContext *c, void *arg){
     MpegEncContext *s= *(void**)arg;
-    int mb_x, mb_y;
 
-    for(mb_y=s->start_mb_y; mb_y < s->end_mb_y; mb_y++) {
-        for(mb_x=0; mb_x < s->mb_width; mb_x++) {
-            int xx = mb_x * 16;
-            int yy = mb_y * 16;
-            const uint8_t *pix = s->new_pic->data[0] + (yy * s->linesize) + xx;
-            int varc;
-            int sum = s->mpvencdsp.pix_sum(pix, s->linesize);
-
-            varc = (s->mpvencdsp.pix_norm1(pix, s->linesize) -
-                    (((unsigned) sum * sum) >> 8) + 500 + 128) >> 8;
-
-            s->mb_var [s->mb_stride * mb_y + mb_x] = varc;
-            s->mb_mean[s->mb_stride * mb_y + mb_x] = (sum+128)>>8;
-            s->me.mb_var_sum_temp    += varc;
-        }
-    }
+    for (int mb_y = s->start_mb_y; mb_y < s->end_mb_y; mb_y++)
+        mb_var_row(s, mb_y);
+    return 0;
+}
+
+static int mb_var_row_thread(AVCodecContext *avctx, void *arg, int mb_y, int threadnr)
+{
+    MpegEncContext *const m = avctx->priv_data;
+
+    mb_var_row(m->thread_context[threadnr], mb_y);
     return 0;
 }
 
@@ -2829,7 +2979,7 @@ static void update_mb_info(MpegEncContext *s, int startcode)
 int ff_mpv_reallocate_putbitbuffer(MpegEncContext *s, size_t threshold, size_t size_increase)
 {
     if (put_bytes_left(&s->pb, 0) < threshold
-        && s->slice_context_count == 1
+        && (s->slice_context_count == 1 || s->wavefront_me)
         && s->pb.buf == s->avctx->internal->byte_buffer) {
         int lastgob_pos = s->ptr_lastgob - s->pb.buf;
 
@@ -3587,6 +3737,9 @@ static int encode_picture(MpegEncContext *s, const AVPacket *pkt)
     int i, ret;
     int bits;
     int context_count = s->slice_context_count;
+    /* with wavefront ME all contexts estimate motion, but only the main one
+     * codes the picture */
+    int enc_count = s->wavefront_me ? 1 : context_count;
 
     /* Reset the average MB variance */
     s->me.mb_var_sum_temp    =
@@ -3642,6 +3795,8 @@ static int encode_picture(MpegEncContext *s, const AVPacket *pkt)
                 return ret;
         }
         slice->me.temp = slice->me.scratchpad = slice->sc.scratchpad_buf;
+        if (i >= enc_count)
+            continue;
 
         h     = s->mb_height;
         start = pkt->data + (size_t)(((int64_t) pkt->size) * slice->start_mb_y / h);
@@ -3657,11 +3812,16 @@ static int encode_picture(MpegEncContext *s, const AVPacket *pkt)
         if (s->pict_type != AV_PICTURE_TYPE_B) {
             if ((s->me_pre && s->last_non_b_pict_type == AV_PICTURE_TYPE_I) ||
                 s->me_pre == 2) {
-                s->avctx->execute(s->avctx, pre_estimate_motion_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
+                s->avctx->execute(s->avctx, pre_estimate_motion_thread, &s->thread_context[0], NULL, enc_count, sizeof(void*));
             }
         }
 
-        s->avctx->execute(s->avctx, estimate_motion_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
+        if (s->wavefront_me) {
+            for (i = 0; i < s->mb_height; i++)
+                atomic_init(&s->wavefront_me->row_progress[i], 0);
+            s->avctx->execute2(s->avctx, estimate_motion_row, NULL, NULL, s->mb_height);
+        } else
+            s->avctx->execute(s->avctx, estimate_motion_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
     }else /* if(s->pict_type == AV_PICTURE_TYPE_I) */{
         /* I-Frame */
         for(i=0; i<s->mb_stride*s->mb_height; i++)
@@ -3669,7 +3829,10 @@ static int encode_picture(MpegEncContext *s, const AVPacket *pkt)
 
         if(!s->fixed_qscale){
             /* finding spatial complexity for I-frame rate control */
-            s->avctx->execute(s->avctx, mb_var_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
+            if (s->wavefront_me)
+                s->avctx->execute2(s->avctx, mb_var_row_thread, NULL, NULL, s->mb_height);
+            else
+                s->avctx->execute(s->avctx, mb_var_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
         }
     }
     for(i=1; i<context_count; i++){
@@ -3858,11 +4021,11 @@ static int encode_picture(MpegEncContext *s, const AVPacket *pkt)
     bits= put_bits_count(&s->pb);
     s->header_bits= bits - s->last_bits;
 
-    for(i=1; i<context_count; i++){
+    for(i=1; i<enc_count; i++){
         update_duplicate_context_after_me(s->thread_context[i], s);
     }
-    s->avctx->execute(s->avctx, encode_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
-    for(i=1; i<context_count; i++){
+    s->avctx->execute(s->avctx, encode_thread, &s->thread_context[0], NULL, enc_count, sizeof(void*));
+    for(i=1; i<enc_count; i++){
         if (s->pb.buf_end == s->thread_context[i]->pb.buf)
             set_put_bits_buffer_size(&s->pb, FFMIN(s->thread_context[i]->pb.buf_end - s->pb.buf, INT_MAX/8-BUF_BITS));
         merge_context_after_encode(s, s->thread_context[i]);
@@ -68,14 +68,12 @@ typedef struct DeNoiseChannel {
     double      band_noise[NB_PROFILE_BANDS];
     double      noise_band_auto_var[NB_PROFILE_BANDS];
     double      noise_band_sample[NB_PROFILE_BANDS];
-    double     *amt;
     double     *band_amt;
     double     *band_excit;
     double     *gain;
     double     *smoothed_gain;
     double     *prior;
     double     *prior_band_excit;
-    double     *clean_data;
     double     *noisy_data;
     double     *out_samples;
     double     *spread_function;
@@ -136,6 +134,7 @@ typedef struct AudioFFTDeNoiseContext {
     int     window_length;
     int     sample_advance;
     int     number_of_bands;
+    int     nb_slices;
 
     int     band_centre[NB_PROFILE_BANDS];
 
@@ -146,6 +145,9 @@ typedef struct AudioFFTDeNoiseContext {
 
     DeNoiseChannel *dnch;
 
+    uint8_t *fft_in;            ///< FFT input of all channels
+    uint8_t *fft_out;           ///< FFT output of all channels
+
     AVFrame *winframe;
 
     double  window_weight;
@@ -350,25 +352,20 @@ static double floor_offset(const double *S, int size, double mean)
     return offset / mean;
 }
 
-static void process_frame(AVFilterContext *ctx,
-                          AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch,
-                          double *prior, double *prior_band_excit, int track_noise)
+static void compute_gains(AVFilterContext *ctx, AudioFFTDeNoiseContext *s,
+                          DeNoiseChannel *dnch, int start, int end)
 {
-    AVFilterLink *outlink = ctx->outputs[0];
-    FilterLink      *outl = ff_filter_link(outlink);
+    FilterLink *outl = ff_filter_link(ctx->outputs[0]);
     const double *abs_var = dnch->abs_var;
     const double ratio = outl->frame_count_out ? s->ratio : 1.0;
     const double rratio = 1. - ratio;
-    const int *bin2band = s->bin2band;
     double *noisy_data = dnch->noisy_data;
-    double *band_excit = dnch->band_excit;
-    double *band_amt = dnch->band_amt;
-    double *smoothed_gain = dnch->smoothed_gain;
     AVComplexDouble *fft_data_dbl = dnch->fft_out;
     AVComplexFloat *fft_data_flt = dnch->fft_out;
+    double *prior = dnch->prior;
     double *gain = dnch->gain;
 
-    for (int i = 0; i < s->bin_count; i++) {
+    for (int i = start; i < end; i++) {
         double sqr_new_gain, new_gain, power, mag, mag_abs_var, new_mag_abs_var;
 
         switch (s->format) {
@@ -388,9 +385,19 @@ static void process_frame(AVFilterContext *ctx,
         new_gain = new_mag_abs_var / (1.0 + new_mag_abs_var);
         sqr_new_gain = new_gain * new_gain;
         prior[i] = mag_abs_var * sqr_new_gain;
-        dnch->clean_data[i] = power * sqr_new_gain;
         gain[i] = new_gain;
     }
+}
+
+static void update_bands(AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch,
+                         int track_noise)
+{
+    const int *bin2band = s->bin2band;
+    const double *noisy_data = dnch->noisy_data;
+    const double *gain = dnch->gain;
+    double *prior_band_excit = dnch->prior_band_excit;
+    double *band_excit = dnch->band_excit;
+    double *band_amt = dnch->band_amt;
 
     if (track_noise) {
         double flatness, num, den;
@@ -412,8 +419,11 @@ static void process_frame(AVFilterContext *ctx,
         band_amt[i] = 0.0;
     }
 
-    for (int i = 0; i < s->bin_count; i++)
-        band_excit[bin2band[i]] += dnch->clean_data[i];
+    for (int i = 0; i < s->bin_count; i++) {
+        const double power = noisy_data[i] * noisy_data[i];
+
+        band_excit[bin2band[i]] += power * (gain[i] * gain[i]);
+    }
 
     for (int i = 0; i < s->number_of_bands; i++) {
         band_excit[i] = fmax(band_excit[i],
@@ -427,27 +437,44 @@ static void process_frame(AVFilterContext *ctx,
             band_amt[j] += dnch->spread_function[i++] * band_excit[k];
         }
     }
+}
+
+static void limit_gains(AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch,
+                        int start, int end)
+{
+    const int *bin2band = s->bin2band;
+    const double *abs_var = dnch->abs_var;
+    const double *band_amt = dnch->band_amt;
+    double *gain = dnch->gain;
 
-    for (int i = 0; i < s->bin_count; i++)
-        dnch->amt[i] = band_amt[bin2band[i]];
+    for (int i = start; i < end; i++) {
+        const double amt = band_amt[bin2band[i]];
 
-    for (int i = 0; i < s->bin_count; i++) {
-        if (dnch->amt[i] > abs_var[i]) {
+        if (amt > abs_var[i]) {
             gain[i] = 1.0;
-        } else if (dnch->amt[i] > dnch->min_abs_var[i]) {
-            const double limit = sqrt(abs_var[i] / dnch->amt[i]);
+        } else if (amt > dnch->min_abs_var[i]) {
+            const double limit = sqrt(abs_var[i] / amt);
 
             gain[i] = limit_gain(gain[i], limit);
         } else {
             gain[i] = limit_gain(gain[i], dnch->max_gain);
         }
     }
+}
 
-    memcpy(smoothed_gain, gain, s->bin_count * sizeof(*smoothed_gain));
+static void apply_gains(AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch,
+                        int start, int end)
+{
+    AVComplexDouble *fft_data_dbl = dnch->fft_out;
+    AVComplexFloat *fft_data_flt = dnch->fft_out;
+    double *smoothed_gain = dnch->smoothed_gain;
+    const double *gain = dnch->gain;
+
+    memcpy(smoothed_gain + start, gain + start, (end - start) * sizeof(*smoothed_gain));
     if (s->gain_smooth > 0) {
         const int r = s->gain_smooth;
 
-        for (int i = r; i < s->bin_count - r; i++) {
+        for (int i = FFMAX(start, r); i < FFMIN(end, s->bin_count - r); i++) {
             const double gc = gain[i];
             double num = 0., den = 0.;
 
@@ -465,7 +492,7 @@ static void process_frame(AVFilterContext *ctx,
 
     switch (s->format) {
     case AV_SAMPLE_FMT_FLTP:
-        for (int i = 0; i < s->bin_count; i++) {
+        for (int i = start; i < end; i++) {
             const float new_gain = smoothed_gain[i];
 
             fft_data_flt[i].re *= new_gain;
@@ -473,7 +500,7 @@ static void process_frame(AVFilterContext *ctx,
         }
         break;
     case AV_SAMPLE_FMT_DBLP:
-        for (int i = 0; i < s->bin_count; i++) {
+        for (int i = start; i < end; i++) {
             const double new_gain = smoothed_gain[i];
 
             fft_data_dbl[i].re *= new_gain;
@@ -483,6 +510,16 @@ static void process_frame(AVFilterContext *ctx,
     }
 }
 
+static void process_frame(AVFilterContext *ctx,
+                          AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch,
+                          int track_noise)
+{
+    compute_gains(ctx, s, dnch, 0, s->bin_count);
+    update_bands(s, dnch, track_noise);
+    limit_gains(s, dnch, 0, s->bin_count);
+    apply_gains(s, dnch, 0, s->bin_count);
+}
+
 static double freq2bark(double x)
 {
     double d = x / 7500.0;
@@ -634,6 +671,7 @@ static int config_input(AVFilterLink *inlink)
     AudioFFTDeNoiseContext *s = ctx->priv;
     double wscale, sar, sum, sdiv;
     int i, j, k, m, n, ret, tx_type;
+    size_t fft_in_dist, fft_out_dist;
     double dscale = 1.;
     float fscale = 1.f;
     void *scale;
@@ -718,6 +756,14 @@ static int config_input(AVFilterLink *inlink)
     if (!s->band_alpha || !s->band_beta)
         return AVERROR(ENOMEM);
 
+    /* the FFT buffers of all channels are allocated in one block */
+    fft_in_dist  = FFALIGN(s->fft_length2 * s->sample_size, 64);
+    fft_out_dist = FFALIGN((s->fft_length2 + 1) * s->complex_sample_size, 64);
+    s->fft_in  = av_calloc(inlink->ch_layout.nb_channels, fft_in_dist);
+    s->fft_out = av_calloc(inlink->ch_layout.nb_channels, fft_out_dist);
+    if (!s->fft_in || !s->fft_out)
+        return AVERROR(ENOMEM);
+
     for (int ch = 0; ch < inlink->ch_layout.nb_channels; ch++) {
         DeNoiseChannel *dnch = &s->dnch[ch];
 
@@ -743,21 +789,19 @@ static int config_input(AVFilterLink *inlink)
 
         reduce_mean(dnch->band_noise);
 
-        dnch->amt = av_calloc(s->bin_count, sizeof(*dnch->amt));
         dnch->band_amt = av_calloc(s->number_of_bands, sizeof(*dnch->band_amt));
         dnch->band_excit = av_calloc(s->number_of_bands, sizeof(*dnch->band_excit));
         dnch->gain = av_calloc(s->bin_count, sizeof(*dnch->gain));
         dnch->smoothed_gain = av_calloc(s->bin_count, sizeof(*dnch->smoothed_gain));
         dnch->prior = av_calloc(s->bin_count, sizeof(*dnch->prior));
         dnch->prior_band_excit = av_calloc(s->number_of_bands, sizeof(*dnch->prior_band_excit));
-        dnch->clean_data = av_calloc(s->bin_count, sizeof(*dnch->clean_data));
         dnch->noisy_data = av_calloc(s->bin_count, sizeof(*dnch->noisy_data));
         dnch->out_samples = av_calloc(s->buffer_length, sizeof(*dnch->out_samples));
         dnch->abs_var = av_calloc(s->bin_count, sizeof(*dnch->abs_var));
         dnch->rel_var = av_calloc(s->bin_count, sizeof(*dnch->rel_var));
         dnch->min_abs_var = av_calloc(s->bin_count, sizeof(*dnch->min_abs_var));
-        dnch->fft_in = av_calloc(s->fft_length2, s->sample_size);
-        dnch->fft_out = av_calloc(s->fft_length2 + 1, s->complex_sample_size);
+        dnch->fft_in  = s->fft_in  + ch * fft_in_dist;
+        dnch->fft_out = s->fft_out + ch * fft_out_dist;
         ret = av_tx_init(&dnch->fft, &dnch->tx_fn, tx_type, 0, s->fft_length2, scale, 0);
         if (ret < 0)
             return ret;
@@ -767,18 +811,14 @@ static int config_input(AVFilterLink *inlink)
         dnch->spread_function = av_calloc(s->number_of_bands * s->number_of_bands,
                                           sizeof(*dnch->spread_function));
 
-        if (!dnch->amt ||
-            !dnch->band_amt ||
+        if (!dnch->band_amt ||
             !dnch->band_excit ||
             !dnch->gain ||
             !dnch->smoothed_gain ||
             !dnch->prior ||
             !dnch->prior_band_excit ||
-            !dnch->clean_data ||
             !dnch->noisy_data ||
             !dnch->out_samples ||
-            !dnch->fft_in ||
-            !dnch->fft_out ||
             !dnch->abs_var ||
             !dnch->rel_var ||
             !dnch->min_abs_var ||
@@ -1046,12 +1086,9 @@ static void set_noise_profile(AudioFFTDeNoiseContext *s,
     memcpy(dnch->band_noise, new_band_noise, sizeof(new_band_noise));
 }
 
-static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static void forward_transform(AudioFFTDeNoiseContext *s, AVFrame *in,
+                              int start, int end)
 {
-    AudioFFTDeNoiseContext *s = ctx->priv;
-    AVFrame *in = arg;
-    const int start = (in->ch_layout.nb_channels * jobnr) / nb_jobs;
-    const int end = (in->ch_layout.nb_channels * (jobnr+1)) / nb_jobs;
     const int window_length = s->window_length;
     const double *window = s->window;
 
@@ -1059,7 +1096,6 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
         DeNoiseChannel *dnch = &s->dnch[ch];
         const double *src_dbl = (const double *)in->extended_data[ch];
         const float *src_flt = (const float *)in->extended_data[ch];
-        double *dst = dnch->out_samples;
         double *fft_in_dbl = dnch->fft_in;
         float *fft_in_flt = dnch->fft_in;
 
@@ -1081,11 +1117,18 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
         }
 
         dnch->tx_fn(dnch->fft, dnch->fft_out, dnch->fft_in, s->sample_size);
+    }
+}
+
+static void inverse_transform(AudioFFTDeNoiseContext *s, int start, int end)
+{
+    const int window_length = s->window_length;
 
-        process_frame(ctx, s, dnch,
-                      dnch->prior,
-                      dnch->prior_band_excit,
-                      s->track_noise);
+    for (int ch = start; ch < end; ch++) {
+        DeNoiseChannel *dnch = &s->dnch[ch];
+        double *dst = dnch->out_samples;
+        const double *fft_in_dbl = dnch->fft_in;
+        const float *fft_in_flt = dnch->fft_in;
 
         dnch->itx_fn(dnch->ifft, dnch->fft_in, dnch->fft_out, s->complex_sample_size);
 
@@ -1100,10 +1143,115 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
             break;
         }
     }
+}
+
+static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFFTDeNoiseContext *s = ctx->priv;
+    AVFrame *in = arg;
+    const int start = (in->ch_layout.nb_channels * jobnr) / nb_jobs;
+    const int end = (in->ch_layout.nb_channels * (jobnr+1)) / nb_jobs;
+
+    forward_transform(s, in, start, end);
+
+    for (int ch = start; ch < end; ch++)
+        process_frame(ctx, s, &s->dnch[ch], s->track_noise);
+
+    inverse_transform(s, start, end);
+
+    return 0;
+}
+
+/*
+ * With more threads than channels, the bins of each channel are split in
+ * nb_slices slices. Only the band excitation of each channel depends on
+ * all of its bins, so a frame is done in stages with one job per slice,
+ * separated by the per channel work.
+ */
+static void get_slice(AudioFFTDeNoiseContext *s, int jobnr,
+                      int *ch, int *start, int *end)
+{
+    const int nb_slices = s->nb_slices;
+    const int slice = jobnr % nb_slices;
+
+    *ch    = jobnr / nb_slices;
+    *start = (s->bin_count * slice) / nb_slices;
+    *end   = (s->bin_count * (slice + 1)) / nb_slices;
+}
+
+static int forward_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    forward_transform(ctx->priv, arg, jobnr, jobnr + 1);
+
+    return 0;
+}
+
+static int gain_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFFTDeNoiseContext *s = ctx->priv;
+    int ch, start, end;
+
+    get_slice(s, jobnr, &ch, &start, &end);
+    compute_gains(ctx, s, &s->dnch[ch], start, end);
+
+    return 0;
+}
+
+static int band_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFFTDeNoiseContext *s = ctx->priv;
+
+    update_bands(s, &s->dnch[jobnr], s->track_noise);
+
+    return 0;
+}
+
+static int limit_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFFTDeNoiseContext *s = ctx->priv;
+    int ch, start, end;
+
+    get_slice(s, jobnr, &ch, &start, &end);
+    limit_gains(s, &s->dnch[ch], start, end);
+    /* smoothing reads the limited gains of the neighbouring slices */
+    if (s->gain_smooth <= 0)
+        apply_gains(s, &s->dnch[ch], start, end);
+
+    return 0;
+}
+
+static int smooth_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFFTDeNoiseContext *s = ctx->priv;
+    int ch, start, end;
+
+    get_slice(s, jobnr, &ch, &start, &end);
+    apply_gains(s, &s->dnch[ch], start, end);
+
+    return 0;
+}
+
+static int inverse_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    inverse_transform(ctx->priv, jobnr, jobnr + 1);
 
     return 0;
 }
 
+static void filter_slices(AVFilterContext *ctx, AVFrame *in)
+{
+    AudioFFTDeNoiseContext *s = ctx->priv;
+    const int nb_jobs = s->channels * s->nb_slices;
+
+    ff_filter_execute(ctx, forward_channel, in, NULL, s->channels);
+    ff_filter_execute(ctx, gain_slice, NULL, NULL, nb_jobs);
+    ff_filter_execute(ctx, band_channel, NULL, NULL, s->channels);
+    ff_filter_execute(ctx, limit_slice, NULL, NULL, nb_jobs);
+    if (s->gain_smooth > 0)
+        ff_filter_execute(ctx, smooth_slice, NULL, NULL, nb_jobs);
+    ff_filter_execute(ctx, inverse_channel, NULL, NULL, s->channels);
+}
+
 static int output_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -1111,6 +1259,7 @@ static int output_frame(AVFilterLink *inlink, AVFrame *in)
     AudioFFTDeNoiseContext *s = ctx->priv;
     const int output_mode = ctx->is_disabled ? IN_MODE : s->output_mode;
     const int offset = s->window_length - s->sample_advance;
+    int nb_threads;
     AVFrame *out;
 
     for (int ch = 0; ch < s->channels; ch++) {
@@ -1190,8 +1339,13 @@ static int output_frame(AVFilterLink *inlink, AVFrame *in)
         s->sample_noise_mode = SAMPLE_NONE;
     }
 
-    ff_filter_execute(ctx, filter_channel, s->winframe, NULL,
-                      FFMIN(outlink->ch_layout.nb_channels, ff_filter_get_nb_threads(ctx)));
+    nb_threads = ff_filter_get_nb_threads(ctx);
+    s->nb_slices = FFMAX(FFMIN(nb_threads / s->channels, s->bin_count / 128), 1);
+    if (s->nb_slices > 1)
+        filter_slices(ctx, s->winframe);
+    else
+        ff_filter_execute(ctx, filter_channel, s->winframe, NULL,
+                          FFMIN(outlink->ch_layout.nb_channels, nb_threads));
 
     if (av_frame_is_writable(in)) {
         out = in;
@@ -1306,27 +1460,25 @@ static av_cold void uninit(AVFilterContext *ctx)
     if (s->dnch) {
         for (int ch = 0; ch < s->channels; ch++) {
             DeNoiseChannel *dnch = &s->dnch[ch];
-            av_freep(&dnch->amt);
             av_freep(&dnch->band_amt);
             av_freep(&dnch->band_excit);
             av_freep(&dnch->gain);
             av_freep(&dnch->smoothed_gain);
             av_freep(&dnch->prior);
             av_freep(&dnch->prior_band_excit);
-            av_freep(&dnch->clean_data);
             av_freep(&dnch->noisy_data);
             av_freep(&dnch->out_samples);
             av_freep(&dnch->spread_function);
             av_freep(&dnch->abs_var);
             av_freep(&dnch->rel_var);
             av_freep(&dnch->min_abs_var);
-            av_freep(&dnch->fft_in);
-            av_freep(&dnch->fft_out);
             av_tx_uninit(&dnch->fft);
             av_tx_uninit(&dnch->ifft);
         }
         av_freep(&s->dnch);
     }
+    av_freep(&s->fft_in);
+    av_freep(&s->fft_out);
 }
 
 static int process_command(AVFilterContext *ctx, const char *cmd, const char *args,
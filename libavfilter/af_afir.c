@@ -27,6 +27,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/cpu.h"
+#include "libavutil/executor.h"
 #include "libavutil/mem.h"
 #include "libavutil/tx.h"
 #include "libavutil/avstring.h"
@@ -36,6 +37,7 @@
 #include "libavutil/log.h"
 #include "libavutil/opt.h"
 #include "libavutil/rational.h"
+#include "libavutil/thread.h"
 
 #include "audio.h"
 #include "avfilter.h"
@@ -45,6 +47,16 @@
 
 #define MAX_IR_STREAMS 32
 
+/* The computation of one block of a segment for one channel. */
+typedef struct AudioFIRTask {
+    AVTask task;
+    struct AudioFIRSegment *seg;
+    int ch;
+    int launched;               ///< handed to the executor and not joined yet
+    int done;                   ///< finished, protected by task_lock
+    int64_t deadline;           ///< sample at which the output is needed
+} AudioFIRTask;
+
 typedef struct AudioFIRSegment {
     int nb_partitions;
     int part_size;
@@ -53,6 +65,9 @@ typedef struct AudioFIRSegment {
     int coeff_size;
     int input_size;
     int input_offset;
+    int lead;                   ///< samples between the end of the input of a
+                                ///< block and the time its output is needed,
+                                ///< 0 if blocks are computed in place
 
     int *output_offset;
     int *part_index;
@@ -69,6 +84,8 @@ typedef struct AudioFIRSegment {
 
     AVTXContext **ctx, **tx, **itx;
     av_tx_fn ctx_fn, tx_fn, itx_fn;
+
+    AudioFIRTask *tasks;
 } AudioFIRSegment;
 
 typedef struct AudioFIRContext {
@@ -95,6 +112,7 @@ typedef struct AudioFIRContext {
     int selir;
     int precision;
     int format;
+    int async;
 
     int eof_coeffs[MAX_IR_STREAMS];
     int have_coeffs[MAX_IR_STREAMS];
@@ -117,11 +135,25 @@ typedef struct AudioFIRContext {
     int min_part_size;
     int max_part_size;
     int64_t pts;
+    int64_t sample_pos;
+
+    AVExecutor *executor;
+    AVMutex task_lock;
+    AVCond task_cond;
 
     AudioFIRDSPContext afirdsp;
     AVFloatDSPContext *fdsp;
 } AudioFIRContext;
 
+static void fir_join(AudioFIRContext *s, AudioFIRTask *task)
+{
+    ff_mutex_lock(&s->task_lock);
+    while (!task->done)
+        ff_cond_wait(&s->task_cond, &s->task_lock);
+    ff_mutex_unlock(&s->task_lock);
+    task->launched = 0;
+}
+
 #define DEPTH 32
 #include "afir_template.c"
 
@@ -129,6 +161,39 @@ typedef struct AudioFIRContext {
 #define DEPTH 64
 #include "afir_template.c"
 
+static int fir_task_priority_higher(const AVTask *a, const AVTask *b)
+{
+    return ((const AudioFIRTask *)a)->deadline < ((const AudioFIRTask *)b)->deadline;
+}
+
+static int fir_task_ready(const AVTask *t, void *user_data)
+{
+    return 1;
+}
+
+static int fir_task_run(AVTask *t, void *local_context, void *user_data)
+{
+    AVFilterContext *ctx = user_data;
+    AudioFIRContext *s = ctx->priv;
+    AudioFIRTask *task = (AudioFIRTask *)t;
+
+    switch (s->format) {
+    case AV_SAMPLE_FMT_FLTP:
+        fir_block_float(s, task->seg, task->ch);
+        break;
+    case AV_SAMPLE_FMT_DBLP:
+        fir_block_double(s, task->seg, task->ch);
+        break;
+    }
+
+    ff_mutex_lock(&s->task_lock);
+    task->done = 1;
+    ff_cond_broadcast(&s->task_cond);
+    ff_mutex_unlock(&s->task_lock);
+
+    return 0;
+}
+
 static int fir_channel(AVFilterContext *ctx, AVFrame *out, int ch)
 {
     AudioFIRContext *s = ctx->priv;
@@ -182,6 +247,7 @@ static int fir_frame(AudioFIRContext *s, AVFrame *in, AVFilterLink *outlink)
     ff_filter_execute(ctx, fir_channels, out, NULL,
                       FFMIN(outlink->ch_layout.nb_channels, ff_filter_get_nb_threads(ctx)));
     s->prev_is_disabled = ctx->is_disabled;
+    s->sample_pos += in->nb_samples;
 
     av_frame_free(&in);
     s->in = NULL;
@@ -212,11 +278,31 @@ static int init_segment(AVFilterContext *ctx, AudioFIRSegment *seg, int selir,
     seg->input_size    = offset + s->min_part_size;
     seg->input_offset  = offset;
 
+    /* A block can start once its part_size input samples are complete and
+     * the previous block of the same channel has been joined, and must be
+     * done offset - part_size + min_part_size samples later. Segments
+     * without that much slack are computed in place. */
+    if (s->executor)
+        seg->lead = FFMIN(part_size - s->min_part_size,
+                          offset - part_size + s->min_part_size);
+    if (seg->lead < s->min_part_size)
+        seg->lead = 0;
+
     seg->part_index    = av_calloc(ctx->inputs[0]->ch_layout.nb_channels, sizeof(*seg->part_index));
     seg->output_offset = av_calloc(ctx->inputs[0]->ch_layout.nb_channels, sizeof(*seg->output_offset));
     if (!seg->part_index || !seg->output_offset)
         return AVERROR(ENOMEM);
 
+    if (seg->lead) {
+        seg->tasks = av_calloc(ctx->inputs[0]->ch_layout.nb_channels, sizeof(*seg->tasks));
+        if (!seg->tasks)
+            return AVERROR(ENOMEM);
+        for (int ch = 0; ch < ctx->inputs[0]->ch_layout.nb_channels; ch++) {
+            seg->tasks[ch].seg = seg;
+            seg->tasks[ch].ch  = ch;
+        }
+    }
+
     switch (s->format) {
     case AV_SAMPLE_FMT_FLTP:
         cscale.f = 1.f;
@@ -289,6 +375,7 @@ static void uninit_segment(AVFilterContext *ctx, AudioFIRSegment *seg)
 
     av_freep(&seg->output_offset);
     av_freep(&seg->part_index);
+    av_freep(&seg->tasks);
 
     av_frame_free(&seg->tempin);
     av_frame_free(&seg->tempout);
@@ -328,7 +415,7 @@ static int convert_coeffs(AVFilterContext *ctx, int selir)
         max_part_size = 1 << av_log2(s->maxp);
 
         for (int i = 0; left > 0; i++) {
-            int step = (part_size == max_part_size) ? INT_MAX : 1 + (i == 0);
+            int step = (part_size == max_part_size) ? INT_MAX : 1 + (i == 0 || s->async);
             int nb_partitions = FFMIN(step, (left + part_size - 1) / part_size);
 
             s->nb_segments[selir] = i + 1;
@@ -638,6 +725,13 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     AudioFIRContext *s = ctx->priv;
 
+    /* wait for the blocks being computed before freeing the segments */
+    if (s->executor) {
+        av_executor_free(&s->executor);
+        ff_cond_destroy(&s->task_cond);
+        ff_mutex_destroy(&s->task_lock);
+    }
+
     av_freep(&s->fdsp);
     av_freep(&s->ch_gain);
     av_freep(&s->loading);
@@ -697,6 +791,30 @@ static av_cold int init(AVFilterContext *ctx)
     s->min_part_size = 1 << av_log2(s->minp);
     s->max_part_size = 1 << av_log2(s->maxp);
 
+    if (s->async) {
+        AVTaskCallbacks callbacks = {
+            .user_data       = ctx,
+            .priority_higher = fir_task_priority_higher,
+            .ready           = fir_task_ready,
+            .run             = fir_task_run,
+        };
+
+        ret = ff_mutex_init(&s->task_lock, NULL);
+        if (ret)
+            return AVERROR(ret);
+        ret = ff_cond_init(&s->task_cond, NULL);
+        if (ret) {
+            ff_mutex_destroy(&s->task_lock);
+            return AVERROR(ret);
+        }
+        s->executor = av_executor_alloc(&callbacks, s->async);
+        if (!s->executor) {
+            ff_cond_destroy(&s->task_cond);
+            ff_mutex_destroy(&s->task_lock);
+            return AVERROR(ENOMEM);
+        }
+    }
+
     return 0;
 }
 
@@ -764,6 +882,7 @@ static const AVOption afir_options[] = {
     { "irload", "set IR loading type", OFFSET(ir_load), AV_OPT_TYPE_INT, {.i64=0}, 0, 1, AF, .unit = "irload" },
     {  "init",   "load all IRs on init", 0, AV_OPT_TYPE_CONST, {.i64=0}, 0, 0, AF, .unit = "irload" },
     {  "access", "load IR on access",    0, AV_OPT_TYPE_CONST, {.i64=1}, 0, 0, AF, .unit = "irload" },
+    { "async",  "set number of threads computing large partitions ahead", OFFSET(async), AV_OPT_TYPE_INT, {.i64=0}, 0, 64, AF },
     { NULL }
 };
 
@@ -116,6 +116,15 @@ typedef struct RNNState {
     RNNModel *model;
 } RNNState;
 
+typedef struct DenoiseFrame {
+    AVComplexFloat X[FREQ_SIZE];
+    AVComplexFloat P[FREQ_SIZE];
+    float Ex[NB_BANDS], Ep[NB_BANDS];
+    DECLARE_ALIGNED(32, float, Exp)[FFALIGN(NB_BANDS, 4)];
+    float features[NB_FEATURES];
+    int silence;
+} DenoiseFrame;
+
 typedef struct DenoiseState {
     float analysis_mem[FRAME_SIZE];
     float cepstral_mem[CEPS_MEM][NB_BANDS];
@@ -131,6 +140,7 @@ typedef struct DenoiseState {
     RNNState rnn[2];
     AVTXContext *tx, *txi;
     av_tx_fn tx_fn, txi_fn;
+    DenoiseFrame frame[2];
 } DenoiseState;
 
 typedef struct AudioRNNContext {
@@ -138,10 +148,15 @@ typedef struct AudioRNNContext {
 
     char *model_name;
     float mix;
+    int pipeline;
 
     int channels;
     DenoiseState *st;
 
+    AVFrame *pending;
+    int pending_disabled;
+    int slot;
+
     DECLARE_ALIGNED(32, float, window)[WINDOW_SIZE];
     DECLARE_ALIGNED(32, float, dct_table)[FFALIGN(NB_BANDS, 4)][FFALIGN(NB_BANDS, 4)];
 
@@ -1023,7 +1038,7 @@ static int compute_frame_features(AudioRNNContext *s, DenoiseState *st, AVComple
     float E = 0;
     float *ceps_0, *ceps_1, *ceps_2;
     float spec_variability = 0;
-    LOCAL_ALIGNED_32(float, Ly, [NB_BANDS]);
+    LOCAL_ALIGNED_32(float, Ly, [FFALIGN(NB_BANDS, 4)]);
     LOCAL_ALIGNED_32(float, p, [WINDOW_SIZE]);
     float pitch_buf[PITCH_BUF_SIZE>>1];
     int pitch_index;
@@ -1032,6 +1047,9 @@ static int compute_frame_features(AudioRNNContext *s, DenoiseState *st, AVComple
     float tmp[NB_BANDS];
     float follow, logMax;
 
+    /* dct() reads its input up to a multiple of 4 */
+    RNN_CLEAR(Ly + NB_BANDS, FFALIGN(NB_BANDS, 4) - NB_BANDS);
+
     frame_analysis(s, st, X, Ex, in);
     RNN_MOVE(st->pitch_buf, &st->pitch_buf[FRAME_SIZE], PITCH_BUF_SIZE-FRAME_SIZE);
     RNN_COPY(&st->pitch_buf[PITCH_BUF_SIZE-FRAME_SIZE], in, FRAME_SIZE);
@@ -1335,6 +1353,12 @@ static void compute_rnn(AudioRNNContext *s, RNNState *rnn, float *gains, float *
     LOCAL_ALIGNED_32(float, noise_input,   [MAX_NEURONS * 3]);
     LOCAL_ALIGNED_32(float, denoise_input, [MAX_NEURONS * 3]);
 
+    /* The GRU layers read their input up to a multiple of 4. The weights
+     * past the end are zero, but stack garbage could still be NaN. */
+    RNN_CLEAR(dense_out,     MAX_NEURONS);
+    RNN_CLEAR(noise_input,   MAX_NEURONS * 3);
+    RNN_CLEAR(denoise_input, MAX_NEURONS * 3);
+
     compute_dense(rnn->model->input_dense, dense_out, input);
     compute_gru(s, rnn->model->vad_gru, rnn->vad_gru_state, dense_out);
     compute_dense(rnn->model->vad_output, vad, rnn->vad_gru_state);
@@ -1357,29 +1381,29 @@ static void compute_rnn(AudioRNNContext *s, RNNState *rnn, float *gains, float *
     compute_dense(rnn->model->denoise_output, gains, rnn->denoise_gru_state);
 }
 
-static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, const float *in,
-                             int disabled)
+static void analyse_frame(AudioRNNContext *s, DenoiseState *st, DenoiseFrame *f,
+                          const float *in)
 {
-    AVComplexFloat X[FREQ_SIZE];
-    AVComplexFloat P[WINDOW_SIZE];
     float x[FRAME_SIZE];
-    float Ex[NB_BANDS], Ep[NB_BANDS];
-    LOCAL_ALIGNED_32(float, Exp, [NB_BANDS]);
-    float features[NB_FEATURES];
-    float g[NB_BANDS];
-    float gf[FREQ_SIZE];
-    float vad_prob = 0;
-    float *history = st->history;
     static const float a_hp[2] = {-1.99599, 0.99600};
     static const float b_hp[2] = {-2, 1};
-    int silence;
 
     biquad(x, st->mem_hp_x, in, b_hp, a_hp, FRAME_SIZE);
-    silence = compute_frame_features(s, st, X, P, Ex, Ep, Exp, features, x);
+    f->silence = compute_frame_features(s, st, f->X, f->P, f->Ex, f->Ep, f->Exp, f->features, x);
+}
+
+static float denoise_frame(AudioRNNContext *s, DenoiseState *st, DenoiseFrame *f,
+                           float *out, const float *in, int disabled)
+{
+    AVComplexFloat *X = f->X;
+    float g[NB_BANDS];
+    float gf[FREQ_SIZE];
+    float vad_prob = 0;
+    float *history = st->history;
 
-    if (!silence && !disabled) {
-        compute_rnn(s, &st->rnn[0], g, &vad_prob, features);
-        pitch_filter(X, P, Ex, Ep, Exp, g);
+    if (!f->silence && !disabled) {
+        compute_rnn(s, &st->rnn[0], g, &vad_prob, f->features);
+        pitch_filter(X, f->P, f->Ex, f->Ep, f->Exp, g);
         for (int i = 0; i < NB_BANDS; i++) {
             float alpha = .6f;
 
@@ -1401,8 +1425,19 @@ static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, c
     return vad_prob;
 }
 
+static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, const float *in,
+                             int disabled)
+{
+    DenoiseFrame *f = &st->frame[0];
+
+    analyse_frame(s, st, f, in);
+    return denoise_frame(s, st, f, out, in, disabled);
+}
+
 typedef struct ThreadData {
     AVFrame *in, *out;
+    AVFrame *next;
+    int disabled;
 } ThreadData;
 
 static int rnnoise_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
@@ -1418,7 +1453,40 @@ static int rnnoise_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
         rnnoise_channel(s, &s->st[ch],
                         (float *)out->extended_data[ch],
                         (const float *)in->extended_data[ch],
-                        ctx->is_disabled);
+                        td->disabled);
+    }
+
+    return 0;
+}
+
+/**
+ * Pipelined mode: each channel has two tasks, denoising the pending frame
+ * with the features computed on the previous call, and computing the
+ * features of the next frame. The two only share read-only state, so
+ * even mono input keeps two threads busy.
+ */
+static int rnnoise_pipeline(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioRNNContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int nb_tasks = 2 * s->channels;
+    const int start = (nb_tasks * jobnr) / nb_jobs;
+    const int end = (nb_tasks * (jobnr+1)) / nb_jobs;
+
+    for (int n = start; n < end; n++) {
+        const int ch = n >> 1;
+        DenoiseState *st = &s->st[ch];
+
+        if (n & 1) {
+            if (td->next)
+                analyse_frame(s, st, &st->frame[!s->slot],
+                              (const float *)td->next->extended_data[ch]);
+        } else if (td->in) {
+            denoise_frame(s, st, &st->frame[s->slot],
+                          (float *)td->out->extended_data[ch],
+                          (const float *)td->in->extended_data[ch],
+                          td->disabled);
+        }
     }
 
     return 0;
@@ -1438,7 +1506,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     }
     av_frame_copy_props(out, in);
 
-    td.in = in; td.out = out;
+    td.in = in; td.out = out; td.next = NULL;
+    td.disabled = ctx->is_disabled;
     ff_filter_execute(ctx, rnnoise_channels, &td, NULL,
                       FFMIN(outlink->ch_layout.nb_channels, ff_filter_get_nb_threads(ctx)));
 
@@ -1446,12 +1515,47 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     return ff_filter_frame(outlink, out);
 }
 
+/**
+ * Denoise the pending frame while analysing next, then make next pending.
+ * next is NULL when flushing at EOF.
+ */
+static int pipeline_frame(AVFilterContext *ctx, AVFrame *next)
+{
+    AudioRNNContext *s = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
+    AVFrame *out = NULL;
+    ThreadData td;
+
+    if (s->pending) {
+        out = ff_get_audio_buffer(outlink, FRAME_SIZE);
+        if (!out) {
+            av_frame_free(&next);
+            return AVERROR(ENOMEM);
+        }
+        av_frame_copy_props(out, s->pending);
+    }
+
+    td.in = s->pending; td.out = out; td.next = next;
+    td.disabled = s->pending_disabled;
+    ff_filter_execute(ctx, rnnoise_pipeline, &td, NULL,
+                      FFMIN(2 * s->channels, ff_filter_get_nb_threads(ctx)));
+
+    av_frame_free(&s->pending);
+    s->pending = next;
+    s->pending_disabled = ctx->is_disabled;
+    s->slot = !s->slot;
+
+    return out ? ff_filter_frame(outlink, out) : 0;
+}
+
 static int activate(AVFilterContext *ctx)
 {
+    AudioRNNContext *s = ctx->priv;
     AVFilterLink *inlink = ctx->inputs[0];
     AVFilterLink *outlink = ctx->outputs[0];
     AVFrame *in = NULL;
-    int ret;
+    int64_t pts;
+    int ret, status;
 
     FF_FILTER_FORWARD_STATUS_BACK(outlink, inlink);
 
@@ -1459,8 +1563,21 @@ static int activate(AVFilterContext *ctx)
     if (ret < 0)
         return ret;
 
-    if (ret > 0)
+    if (ret > 0) {
+        if (s->pipeline) {
+            ret = pipeline_frame(ctx, in);
+            if (ret >= 0 && ff_inlink_queued_samples(inlink) >= FRAME_SIZE)
+                ff_filter_set_ready(ctx, 10);
+            return ret;
+        }
         return filter_frame(inlink, in);
+    }
+
+    if (s->pending && ff_inlink_acknowledge_status(inlink, &status, &pts)) {
+        ret = pipeline_frame(ctx, NULL);
+        ff_outlink_set_status(outlink, status, pts);
+        return ret;
+    }
 
     FF_FILTER_FORWARD_STATUS(inlink, outlink);
     FF_FILTER_FORWARD_WANTED(outlink, inlink);
@@ -1568,6 +1685,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     AudioRNNContext *s = ctx->priv;
 
     av_freep(&s->fdsp);
+    av_frame_free(&s->pending);
     free_model(ctx, 0);
     for (int ch = 0; ch < s->channels && s->st; ch++) {
         av_tx_uninit(&s->st[ch].tx);
@@ -1586,11 +1704,13 @@ static const AVFilterPad inputs[] = {
 
 #define OFFSET(x) offsetof(AudioRNNContext, x)
 #define AF AV_OPT_FLAG_AUDIO_PARAM|AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_RUNTIME_PARAM
+#define A  AV_OPT_FLAG_AUDIO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
 
 static const AVOption arnndn_options[] = {
     { "model", "set model name", OFFSET(model_name), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, AF },
     { "m",     "set model name", OFFSET(model_name), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, AF },
     { "mix",   "set output vs input mix", OFFSET(mix), AV_OPT_TYPE_FLOAT, {.dbl=1.0},-1, 1, AF },
+    { "pipeline", "analyse the next frame while denoising the current one", OFFSET(pipeline), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, A },
     { NULL }
 };
 
@@ -33,6 +33,7 @@ enum FrameType {
     INNER_FRAME,
     FINAL_FRAME,
     LINEAR_MODE,
+    ANALYSIS_MODE,
     FRAME_NB
 };
 
@@ -62,6 +63,7 @@ typedef struct LoudNormContext {
     double measured_thresh;
     double offset;
     int linear;
+    int analysis;
     int dual_mono;
     enum PrintFormat print_format;
 
@@ -116,6 +118,7 @@ static const AVOption loudnorm_options[] = {
     { "measured_thresh",  "measured threshold of input file",  OFFSET(measured_thresh),  AV_OPT_TYPE_DOUBLE,  {.dbl = -70.},   -99.,        0.,  FLAGS },
     { "offset",           "set offset gain",                   OFFSET(offset),           AV_OPT_TYPE_DOUBLE,  {.dbl =  0.},    -99.,       99.,  FLAGS },
     { "linear",           "normalize linearly if possible",    OFFSET(linear),           AV_OPT_TYPE_BOOL,    {.i64 =  1},        0,         1,  FLAGS },
+    { "analysis",         "only measure the input",            OFFSET(analysis),         AV_OPT_TYPE_BOOL,    {.i64 =  0},        0,         1,  FLAGS },
     { "dual_mono",        "treat mono input as dual-mono",     OFFSET(dual_mono),        AV_OPT_TYPE_BOOL,    {.i64 =  0},        0,         1,  FLAGS },
     { "print_format",     "set print format for stats",        OFFSET(print_format),     AV_OPT_TYPE_INT,     {.i64 =  NONE},  NONE,  PF_NB -1,  FLAGS, .unit = "print_format" },
     {     "none",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  NONE},     0,         0,  FLAGS, .unit = "print_format" },
@@ -422,6 +425,12 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     double gain, gain_next, env_global, env_shortterm,
     global, shortterm, lra, relative_threshold;
 
+    if (s->frame_type == ANALYSIS_MODE) {
+        ff_ebur128_add_frames_double(s->r128_in, (const double *)in->data[0],
+                                     in->nb_samples);
+        return ff_filter_frame(outlink, in);
+    }
+
     if (av_frame_is_writable(in)) {
         out = in;
     } else {
@@ -686,7 +695,7 @@ static int activate(AVFilterContext *ctx)
 
     FF_FILTER_FORWARD_STATUS_BACK(outlink, inlink);
 
-    if (s->frame_type != LINEAR_MODE) {
+    if (s->frame_type != LINEAR_MODE && s->frame_type != ANALYSIS_MODE) {
         int nb_samples;
 
         if (s->frame_type == FIRST_FRAME) {
@@ -710,7 +719,7 @@ static int activate(AVFilterContext *ctx)
                 s->pts[i] = in->pts + i * nb_samples;
         } else if (s->frame_type == LINEAR_MODE) {
             s->pts[0] = in->pts;
-        } else {
+        } else if (s->frame_type == INNER_FRAME) {
             s->pts[FF_ARRAY_ELEMS(s->pts) - 1] = in->pts;
         }
         ret = filter_frame(inlink, in);
@@ -759,14 +768,19 @@ static int config_input(AVFilterLink *inlink)
     if (!s->r128_in)
         return AVERROR(ENOMEM);
 
+    if (inlink->ch_layout.nb_channels == 1 && s->dual_mono)
+        ff_ebur128_set_channel(s->r128_in, 0, FF_EBUR128_DUAL_MONO);
+
+    s->channels = inlink->ch_layout.nb_channels;
+    if (s->frame_type == ANALYSIS_MODE)
+        return 0;
+
     s->r128_out = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
     if (!s->r128_out)
         return AVERROR(ENOMEM);
 
-    if (inlink->ch_layout.nb_channels == 1 && s->dual_mono) {
-        ff_ebur128_set_channel(s->r128_in,  0, FF_EBUR128_DUAL_MONO);
+    if (inlink->ch_layout.nb_channels == 1 && s->dual_mono)
         ff_ebur128_set_channel(s->r128_out, 0, FF_EBUR128_DUAL_MONO);
-    }
 
     s->buf_size = frame_size(inlink->sample_rate, 3000) * inlink->ch_layout.nb_channels;
     s->buf = av_malloc_array(s->buf_size, sizeof(*s->buf));
@@ -787,7 +801,6 @@ static int config_input(AVFilterLink *inlink)
     s->buf_index =
     s->prev_buf_index =
     s->limiter_buf_index = 0;
-    s->channels = inlink->ch_layout.nb_channels;
     s->index = 1;
     s->limiter_state = OUT;
     s->offset = pow(10., s->offset / 20.);
@@ -803,7 +816,9 @@ static av_cold int init(AVFilterContext *ctx)
     LoudNormContext *s = ctx->priv;
     s->frame_type = FIRST_FRAME;
 
-    if (s->linear) {
+    if (s->analysis) {
+        s->frame_type = ANALYSIS_MODE;
+    } else if (s->linear) {
         double offset, offset_tp;
         offset    = s->target_i - s->measured_i;
         offset_tp = s->measured_tp + offset;
@@ -825,7 +840,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     double i_in, i_out, lra_in, lra_out, thresh_in, thresh_out, tp_in, tp_out;
     int c;
 
-    if (!s->r128_in || !s->r128_out)
+    if (!s->r128_in || (!s->r128_out && s->frame_type != ANALYSIS_MODE))
         goto end;
 
     ff_ebur128_loudness_range(s->r128_in, &lra_in);
@@ -838,6 +853,43 @@ static av_cold void uninit(AVFilterContext *ctx)
             tp_in = tmp;
     }
 
+    if (s->frame_type == ANALYSIS_MODE) {
+        switch (s->print_format) {
+        case NONE:
+            break;
+
+        case JSON:
+            av_log(ctx, AV_LOG_INFO,
+                "\n{\n"
+                "\t\"input_i\" : \"%.2f\",\n"
+                "\t\"input_tp\" : \"%.2f\",\n"
+                "\t\"input_lra\" : \"%.2f\",\n"
+                "\t\"input_thresh\" : \"%.2f\"\n"
+                "}\n",
+                i_in,
+                20. * log10(tp_in),
+                lra_in,
+                thresh_in
+            );
+            break;
+
+        case SUMMARY:
+            av_log(ctx, AV_LOG_INFO,
+                "\n"
+                "Input Integrated:   %+6.1f LUFS\n"
+                "Input True Peak:    %+6.1f dBTP\n"
+                "Input LRA:          %6.1f LU\n"
+                "Input Threshold:    %+6.1f LUFS\n",
+                i_in,
+                20. * log10(tp_in),
+                lra_in,
+                thresh_in
+            );
+            break;
+        }
+        goto end;
+    }
+
     ff_ebur128_loudness_range(s->r128_out, &lra_out);
     ff_ebur128_loudness_global(s->r128_out, &i_out);
     ff_ebur128_relative_threshold(s->r128_out, &thresh_out);
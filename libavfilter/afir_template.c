@@ -134,11 +134,71 @@ static void fn(fir_fadd)(AudioFIRContext *s, ftype *dst, const ftype *src, int n
     }
 }
 
+/* Transform the input block in tempin and compute the output block of a
+ * segment in sumout. */
+static void fn(fir_block)(AudioFIRContext *s, AudioFIRSegment *seg, int ch)
+{
+    ftype *sumin = (ftype *)seg->sumin->extended_data[ch];
+    ftype *sumout = (ftype *)seg->sumout->extended_data[ch];
+    ftype *tempin = (ftype *)seg->tempin->extended_data[ch];
+    ftype *blockout = (ftype *)seg->blockout->extended_data[ch] + seg->part_index[ch] * seg->block_size;
+    const int nb_partitions = seg->nb_partitions;
+    const int part_size = seg->part_size;
+    int j;
+
+    memset(sumin, 0, sizeof(*sumin) * seg->fft_length);
+
+    seg->tx_fn(seg->tx[ch], blockout, tempin, sizeof(ftype));
+
+    j = seg->part_index[ch];
+    for (int i = 0; i < nb_partitions; i++) {
+        const int input_partition = j;
+        const int coeff_partition = i;
+        const int coffset = coeff_partition * seg->coeff_size;
+        const ftype *blockout = (const ftype *)seg->blockout->extended_data[ch] + input_partition * seg->block_size;
+        const ctype *coeff = ((const ctype *)seg->coeff->extended_data[ch]) + coffset;
+
+        if (j == 0)
+            j = nb_partitions;
+        j--;
+
+#if DEPTH == 32
+        s->afirdsp.fcmul_add(sumin, blockout, (const ftype *)coeff, part_size);
+#else
+        s->afirdsp.dcmul_add(sumin, blockout, (const ftype *)coeff, part_size);
+#endif
+    }
+
+    seg->itx_fn(seg->itx[ch], sumout, sumin, sizeof(ctype));
+}
+
+static void fn(fir_block_input)(AudioFIRSegment *seg, int ch, const ftype *src)
+{
+    ftype *tempin = (ftype *)seg->tempin->extended_data[ch];
+
+    memset(tempin + seg->part_size, 0, sizeof(*tempin) * (seg->block_size - seg->part_size));
+    memcpy(tempin, src, sizeof(*src) * seg->part_size);
+}
+
+/* Hand the computation of the next block of a segment to the executor. */
+static void fn(fir_launch)(AudioFIRContext *s, AudioFIRSegment *seg, int ch,
+                           const ftype *src, int64_t deadline)
+{
+    AudioFIRTask *task = &seg->tasks[ch];
+
+    fn(fir_block_input)(seg, ch, src);
+
+    task->deadline = deadline;
+    task->done     = 0;
+    task->launched = 1;
+    av_executor_execute(s->executor, &task->task);
+}
+
 static int fn(fir_quantum)(AVFilterContext *ctx, AVFrame *out, int ch, int ioffset, int offset, int selir)
 {
     AudioFIRContext *s = ctx->priv;
     const ftype *in = (const ftype *)s->in->extended_data[ch] + ioffset;
-    ftype *blockout, *ptr = (ftype *)out->extended_data[ch] + offset;
+    ftype *ptr = (ftype *)out->extended_data[ch] + offset;
     const int min_part_size = s->min_part_size;
     const int nb_samples = FFMIN(min_part_size, out->nb_samples - offset);
     const int nb_segments = s->nb_segments[selir];
@@ -149,17 +209,13 @@ static int fn(fir_quantum)(AVFilterContext *ctx, AVFrame *out, int ch, int ioffs
         AudioFIRSegment *seg = &s->seg[selir][segment];
         ftype *src = (ftype *)seg->input->extended_data[ch];
         ftype *dst = (ftype *)seg->output->extended_data[ch];
-        ftype *sumin = (ftype *)seg->sumin->extended_data[ch];
         ftype *sumout = (ftype *)seg->sumout->extended_data[ch];
-        ftype *tempin = (ftype *)seg->tempin->extended_data[ch];
         ftype *buf = (ftype *)seg->buffer->extended_data[ch];
         int *output_offset = &seg->output_offset[ch];
         const int nb_partitions = seg->nb_partitions;
         const int input_offset = seg->input_offset;
         const int part_size = seg->part_size;
-        int j;
 
-        seg->part_index[ch] = seg->part_index[ch] % nb_partitions;
         if (dry_gain == 1.f) {
             memcpy(src + input_offset, in, nb_samples * sizeof(*src));
         } else if (min_part_size >= 8) {
@@ -178,6 +234,12 @@ static int fn(fir_quantum)(AVFilterContext *ctx, AVFrame *out, int ch, int ioffs
         if (output_offset[0] >= part_size) {
             output_offset[0] = 0;
         } else {
+            /* the input of the next block is complete, its output is
+             * needed seg->lead samples from now */
+            if (output_offset[0] == part_size - seg->lead)
+                fn(fir_launch)(s, seg, ch, src + seg->lead,
+                               s->sample_pos + ioffset + seg->lead);
+
             memmove(src, src + min_part_size, (seg->input_size - min_part_size) * sizeof(*src));
 
             dst += output_offset[0];
@@ -185,34 +247,15 @@ static int fn(fir_quantum)(AVFilterContext *ctx, AVFrame *out, int ch, int ioffs
             continue;
         }
 
-        memset(sumin, 0, sizeof(*sumin) * seg->fft_length);
-
-        blockout = (ftype *)seg->blockout->extended_data[ch] + seg->part_index[ch] * seg->block_size;
-        memset(tempin + part_size, 0, sizeof(*tempin) * (seg->block_size - part_size));
-        memcpy(tempin, src, sizeof(*src) * part_size);
-        seg->tx_fn(seg->tx[ch], blockout, tempin, sizeof(ftype));
-
-        j = seg->part_index[ch];
-        for (int i = 0; i < nb_partitions; i++) {
-            const int input_partition = j;
-            const int coeff_partition = i;
-            const int coffset = coeff_partition * seg->coeff_size;
-            const ftype *blockout = (const ftype *)seg->blockout->extended_data[ch] + input_partition * seg->block_size;
-            const ctype *coeff = ((const ctype *)seg->coeff->extended_data[ch]) + coffset;
-
-            if (j == 0)
-                j = nb_partitions;
-            j--;
-
-#if DEPTH == 32
-            s->afirdsp.fcmul_add(sumin, blockout, (const ftype *)coeff, part_size);
-#else
-            s->afirdsp.dcmul_add(sumin, blockout, (const ftype *)coeff, part_size);
-#endif
+        if (seg->lead) {
+            if (!seg->tasks[ch].launched)
+                fn(fir_launch)(s, seg, ch, src, s->sample_pos + ioffset);
+            fir_join(s, &seg->tasks[ch]);
+        } else {
+            fn(fir_block_input)(seg, ch, src);
+            fn(fir_block)(s, seg, ch);
         }
 
-        seg->itx_fn(seg->itx[ch], sumout, sumin, sizeof(ctype));
-
         fn(fir_fadd)(s, buf, sumout, part_size);
         memcpy(dst, buf, part_size * sizeof(*dst));
         memcpy(buf, sumout + part_size, part_size * sizeof(*buf));
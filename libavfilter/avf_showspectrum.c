@@ -316,15 +316,11 @@ static av_cold void uninit(AVFilterContext *ctx)
             av_tx_uninit(&s->ifft[i]);
     }
     av_freep(&s->ifft);
-    if (s->fft_data) {
-        for (i = 0; i < s->nb_display_channels; i++)
-            av_freep(&s->fft_data[i]);
-    }
+    if (s->fft_data)
+        av_freep(&s->fft_data[0]);
     av_freep(&s->fft_data);
-    if (s->fft_in) {
-        for (i = 0; i < s->nb_display_channels; i++)
-            av_freep(&s->fft_in[i]);
-    }
+    if (s->fft_in)
+        av_freep(&s->fft_in[0]);
     av_freep(&s->fft_in);
     if (s->fft_scratch) {
         for (i = 0; i < s->nb_display_channels; i++)
@@ -380,13 +376,11 @@ static int query_formats(const AVFilterContext *ctx,
     return 0;
 }
 
-static int run_channel_fft(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static void channel_fft(AVFilterContext *ctx, AVFrame *fin, int ch)
 {
     ShowSpectrumContext *s = ctx->priv;
     AVFilterLink *inlink = ctx->inputs[0];
     const float *window_func_lut = s->window_func_lut;
-    AVFrame *fin = arg;
-    const int ch = jobnr;
     int n;
 
     /* fill FFT input with the number of samples available */
@@ -483,6 +477,17 @@ static int run_channel_fft(AVFilterContext *ctx, void *arg, int jobnr, int nb_jo
         /* run FFT on each samples set */
         s->tx_fn(s->fft[ch], s->fft_data[ch], s->fft_in[ch], sizeof(AVComplexFloat));
     }
+}
+
+static int run_channel_fft(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ShowSpectrumContext *s = ctx->priv;
+    AVFrame *fin = arg;
+    const int start = (s->nb_display_channels * jobnr) / nb_jobs;
+    const int end = (s->nb_display_channels * (jobnr+1)) / nb_jobs;
+
+    for (int ch = start; ch < end; ch++)
+        channel_fft(ctx, fin, ch);
 
     return 0;
 }
@@ -1133,9 +1138,12 @@ static int config_output(AVFilterLink *outlink)
                 av_freep(&s->fft_scratch[i]);
             }
             av_tx_uninit(&s->fft[i]);
-            av_freep(&s->fft_in[i]);
-            av_freep(&s->fft_data[i]);
         }
+        if (s->fft_in)
+            av_freep(&s->fft_in[0]);
+        av_freep(&s->fft_in);
+        if (s->fft_data)
+            av_freep(&s->fft_data[0]);
         av_freep(&s->fft_data);
 
         s->nb_display_channels = inlink->ch_layout.nb_channels;
@@ -1195,14 +1203,16 @@ static int config_output(AVFilterLink *outlink)
         s->fft_scratch = av_calloc(s->nb_display_channels, sizeof(*s->fft_scratch));
         if (!s->fft_scratch)
             return AVERROR(ENOMEM);
+        /* the buffers of all channels are allocated in one block */
+        s->fft_in[0] = av_calloc(s->nb_display_channels * s->buf_size, sizeof(**s->fft_in));
+        if (!s->fft_in[0])
+            return AVERROR(ENOMEM);
+        s->fft_data[0] = av_calloc(s->nb_display_channels * s->buf_size, sizeof(**s->fft_data));
+        if (!s->fft_data[0])
+            return AVERROR(ENOMEM);
         for (i = 0; i < s->nb_display_channels; i++) {
-            s->fft_in[i] = av_calloc(s->buf_size, sizeof(**s->fft_in));
-            if (!s->fft_in[i])
-                return AVERROR(ENOMEM);
-
-            s->fft_data[i] = av_calloc(s->buf_size, sizeof(**s->fft_data));
-            if (!s->fft_data[i])
-                return AVERROR(ENOMEM);
+            s->fft_in[i]   = s->fft_in[0]   + i * s->buf_size;
+            s->fft_data[i] = s->fft_data[0] + i * s->buf_size;
 
             s->fft_scratch[i] = av_calloc(s->buf_size, sizeof(**s->fft_scratch));
             if (!s->fft_scratch[i])
@@ -1600,7 +1610,8 @@ static int activate(AVFilterContext *ctx)
         if (ret < 0)
             return ret;
         if (ret > 0) {
-            ff_filter_execute(ctx, run_channel_fft, fin, NULL, s->nb_display_channels);
+            ff_filter_execute(ctx, run_channel_fft, fin, NULL,
+                              FFMIN(s->nb_display_channels, ff_filter_get_nb_threads(ctx)));
 
             if (s->data == D_MAGNITUDE)
                 ff_filter_execute(ctx, calc_channel_magnitudes, NULL, NULL, s->nb_display_channels);
@@ -1801,7 +1812,8 @@ static int showspectrumpic_request_frame(AVFilterLink *outlink)
                     break;
             }
 
-            ff_filter_execute(ctx, run_channel_fft, fin, NULL, s->nb_display_channels);
+            ff_filter_execute(ctx, run_channel_fft, fin, NULL,
+                              FFMIN(s->nb_display_channels, ff_filter_get_nb_threads(ctx)));
             acalc_magnitudes(s);
 
             consumed += spf;
@@ -84,8 +84,8 @@ struct FFEBUR128StateInternal {
     double b[5];
     /** BS.1770 filter coefficients (denominator). */
     double a[5];
-    /** BS.1770 filter state. */
-    double v[5][5];
+    /** BS.1770 filter state, v[1] to v[4] of each channel stored planar. */
+    double *v;
     /** Histograms, used to calculate LRA. */
     unsigned long *block_energy_histogram;
     unsigned long *short_term_block_energy_histogram;
@@ -105,8 +105,6 @@ static DECLARE_ALIGNED(32, double, histogram_energy_boundaries)[1001];
 
 static void ebur128_init_filter(FFEBUR128State * st)
 {
-    int i, j;
-
     double f0 = 1681.974450955533;
     double G = 3.999843853973347;
     double Q = 0.7071752369554196;
@@ -145,12 +143,6 @@ static void ebur128_init_filter(FFEBUR128State * st)
     st->d->a[2] = pa[0] * ra[2] + pa[1] * ra[1] + pa[2] * ra[0];
     st->d->a[3] = pa[1] * ra[2] + pa[2] * ra[1];
     st->d->a[4] = pa[2] * ra[2];
-
-    for (i = 0; i < 5; ++i) {
-        for (j = 0; j < 5; ++j) {
-            st->d->v[i][j] = 0.0;
-        }
-    }
 }
 
 static int ebur128_init_channel_map(FFEBUR128State * st)
@@ -258,11 +250,14 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
                              st->channels * sizeof(*st->d->audio_data));
     CHECK_ERROR(!st->d->audio_data, 0, free_sample_peak)
 
+    st->d->v = av_calloc(channels, 4 * sizeof(*st->d->v));
+    CHECK_ERROR(!st->d->v, 0, free_audio_data)
+
     ebur128_init_filter(st);
 
     st->d->block_energy_histogram =
         av_mallocz(1000 * sizeof(*st->d->block_energy_histogram));
-    CHECK_ERROR(!st->d->block_energy_histogram, 0, free_audio_data)
+    CHECK_ERROR(!st->d->block_energy_histogram, 0, free_filter_state)
     st->d->short_term_block_energy_histogram =
         av_mallocz(1000 * sizeof(*st->d->short_term_block_energy_histogram));
     CHECK_ERROR(!st->d->short_term_block_energy_histogram, 0,
@@ -287,6 +282,8 @@ free_short_term_block_energy_histogram:
     av_free(st->d->short_term_block_energy_histogram);
 free_block_energy_histogram:
     av_free(st->d->block_energy_histogram);
+free_filter_state:
+    av_free(st->d->v);
 free_audio_data:
     av_free(st->d->audio_data);
 free_sample_peak:
@@ -306,6 +303,7 @@ void ff_ebur128_destroy(FFEBUR128State ** st)
     av_free((*st)->d->block_energy_histogram);
     av_free((*st)->d->short_term_block_energy_histogram);
     av_free((*st)->d->audio_data);
+    av_free((*st)->d->v);
     av_free((*st)->d->channel_map);
     av_free((*st)->d->sample_peak);
     av_free((*st)->d->data_ptrs);
@@ -314,56 +312,55 @@ void ff_ebur128_destroy(FFEBUR128State ** st)
     *st = NULL;
 }
 
-#define EBUR128_FILTER(type, scaling_factor)                                       \
-static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,           \
-                                  size_t src_index, size_t frames,                 \
-                                  int stride) {                                    \
-    double* audio_data = st->d->audio_data + st->d->audio_data_index;              \
-    size_t i, c;                                                                   \
-                                                                                   \
-    if ((st->mode & FF_EBUR128_MODE_SAMPLE_PEAK) == FF_EBUR128_MODE_SAMPLE_PEAK) { \
-        for (c = 0; c < st->channels; ++c) {                                       \
-            double max = 0.0;                                                      \
-            for (i = 0; i < frames; ++i) {                                         \
-                type v = srcs[c][src_index + i * stride];                          \
-                if (v > max) {                                                     \
-                    max =        v;                                                \
-                } else if (-v > max) {                                             \
-                    max = -1.0 * v;                                                \
-                }                                                                  \
-            }                                                                      \
-            max /= scaling_factor;                                                 \
-            if (max > st->d->sample_peak[c]) st->d->sample_peak[c] = max;          \
-        }                                                                          \
-    }                                                                              \
-    for (c = 0; c < st->channels; ++c) {                                           \
-        int ci = st->d->channel_map[c] - 1;                                        \
-        if (ci < 0) continue;                                                      \
-        else if (ci == FF_EBUR128_DUAL_MONO - 1) ci = 0; /*dual mono */            \
-        for (i = 0; i < frames; ++i) {                                             \
-            st->d->v[ci][0] = (double) (srcs[c][src_index + i * stride] / scaling_factor) \
-                         - st->d->a[1] * st->d->v[ci][1]                           \
-                         - st->d->a[2] * st->d->v[ci][2]                           \
-                         - st->d->a[3] * st->d->v[ci][3]                           \
-                         - st->d->a[4] * st->d->v[ci][4];                          \
-            audio_data[i * st->channels + c] =                                     \
-                           st->d->b[0] * st->d->v[ci][0]                           \
-                         + st->d->b[1] * st->d->v[ci][1]                           \
-                         + st->d->b[2] * st->d->v[ci][2]                           \
-                         + st->d->b[3] * st->d->v[ci][3]                           \
-                         + st->d->b[4] * st->d->v[ci][4];                          \
-            st->d->v[ci][4] = st->d->v[ci][3];                                     \
-            st->d->v[ci][3] = st->d->v[ci][2];                                     \
-            st->d->v[ci][2] = st->d->v[ci][1];                                     \
-            st->d->v[ci][1] = st->d->v[ci][0];                                     \
-        }                                                                          \
-        st->d->v[ci][4] = fabs(st->d->v[ci][4]) < DBL_MIN ? 0.0 : st->d->v[ci][4]; \
-        st->d->v[ci][3] = fabs(st->d->v[ci][3]) < DBL_MIN ? 0.0 : st->d->v[ci][3]; \
-        st->d->v[ci][2] = fabs(st->d->v[ci][2]) < DBL_MIN ? 0.0 : st->d->v[ci][2]; \
-        st->d->v[ci][1] = fabs(st->d->v[ci][1]) < DBL_MIN ? 0.0 : st->d->v[ci][1]; \
-    }                                                                              \
+/* srcs always points to interleaved samples, see ff_ebur128_add_frames_double(),
+ * all the channels are filtered at once and the unused ones are ignored later */
+static void ebur128_filter_double(FFEBUR128State* st, const double** srcs,
+                                  size_t src_index, size_t frames,
+                                  int stride) {
+    double* audio_data = st->d->audio_data + st->d->audio_data_index;
+    const double *src = srcs[0] + src_index;
+    const double *b = st->d->b, *a = st->d->a;
+    size_t i, c;
+
+    if ((st->mode & FF_EBUR128_MODE_SAMPLE_PEAK) == FF_EBUR128_MODE_SAMPLE_PEAK) {
+        for (c = 0; c < st->channels; ++c) {
+            double max = 0.0;
+            for (i = 0; i < frames; ++i) {
+                double v = srcs[c][src_index + i * stride];
+                if (v > max) {
+                    max =        v;
+                } else if (-v > max) {
+                    max = -1.0 * v;
+                }
+            }
+            if (max > st->d->sample_peak[c]) st->d->sample_peak[c] = max;
+        }
+    }
+
+    /* the filter states are stored planar, one row of v[1] to v[4] */
+    for (c = 0; c < st->channels; ++c) {
+        double *v = st->d->v + c;
+        double v1 = v[0], v2 = v[st->channels];
+        double v3 = v[2 * st->channels], v4 = v[3 * st->channels];
+
+        for (i = 0; i < frames; ++i) {
+            const double v0 = src[i * st->channels + c]
+                            - a[1] * v1 - a[2] * v2 - a[3] * v3 - a[4] * v4;
+
+            audio_data[i * st->channels + c] =
+                b[0] * v0 + b[1] * v1 + b[2] * v2 + b[3] * v3 + b[4] * v4;
+            v4 = v3; v3 = v2; v2 = v1; v1 = v0;
+        }
+
+        v[0]                = v1;
+        v[st->channels]     = v2;
+        v[2 * st->channels] = v3;
+        v[3 * st->channels] = v4;
+    }
+
+    for (i = 0; i < 4 * st->channels; ++i)
+        st->d->v[i] = fabs(st->d->v[i]) < DBL_MIN ? 0.0 : st->d->v[i];
 }
-EBUR128_FILTER(double, 1.0)
 
 static double ebur128_energy_to_loudness(double energy)
 {
@@ -61,8 +61,12 @@ struct hist_entry {
     double loudness;                ///< L = -0.691 + 10 * log10(E)
 };
 
+typedef struct EBUR128Biquad {
+    double b0, b1, b2, a1, a2;
+} EBUR128Biquad;
+
 struct integrator {
-    double **cache;                 ///< window of filtered samples (N ms)
+    double *cache;                  ///< window of filtered samples (N ms), interleaved
     int cache_pos;                  ///< focus on the last added bin in the cache array
     int cache_size;
     double *sum;                    ///< sum of the last N ms filtered samples (cache content)
@@ -114,14 +118,10 @@ typedef struct EBUR128Context {
     AVFrame *insamples;             ///< input samples reference, updated regularly
 
     /* Filter caches.
-     * The mult by 3 in the following is for X[i], X[i-1] and X[i-2] */
-    double *x;                      ///< 3 input samples cache for each channel
-    double *y;                      ///< 3 pre-filter samples cache for each channel
-    double *z;                      ///< 3 RLB-filter samples cache for each channel
-    double pre_b[3];                ///< pre-filter numerator coefficients
-    double pre_a[3];                ///< pre-filter denominator coefficients
-    double rlb_b[3];                ///< rlb-filter numerator coefficients
-    double rlb_a[3];                ///< rlb-filter denominator coefficients
+     * The mult by 6 in the following is for X[i-1], X[i-2], Y[i-1], Y[i-2],
+     * Z[i-1] and Z[i-2], stored planar */
+    double *filter_state;           ///< 6 filter samples cache for each channel
+    EBUR128Biquad kweight[2];       ///< pre-filter and RLB-filter coefficients
 
     struct integrator i400;         ///< 400ms integrator, used for Momentary loudness  (M), and Integrated loudness (I)
     struct integrator i3000;        ///<    3s integrator, used for Short term loudness (S), and Loudness Range      (LRA)
@@ -406,21 +406,21 @@ static int config_audio_input(AVFilterLink *inlink)
 
     double a0 = 1.0 + K / Q + K * K;
 
-    ebur128->pre_b[0] = (Vh + Vb * K / Q + K * K) / a0;
-    ebur128->pre_b[1] = 2.0 * (K * K - Vh) / a0;
-    ebur128->pre_b[2] = (Vh - Vb * K / Q + K * K) / a0;
-    ebur128->pre_a[1] = 2.0 * (K * K - 1.0) / a0;
-    ebur128->pre_a[2] = (1.0 - K / Q + K * K) / a0;
+    ebur128->kweight[0].b0 = (Vh + Vb * K / Q + K * K) / a0;
+    ebur128->kweight[0].b1 = 2.0 * (K * K - Vh) / a0;
+    ebur128->kweight[0].b2 = (Vh - Vb * K / Q + K * K) / a0;
+    ebur128->kweight[0].a1 = 2.0 * (K * K - 1.0) / a0;
+    ebur128->kweight[0].a2 = (1.0 - K / Q + K * K) / a0;
 
     f0 = 38.13547087602444;
     Q = 0.5003270373238773;
     K = tan(M_PI * f0 / (double)inlink->sample_rate);
 
-    ebur128->rlb_b[0] = 1.0;
-    ebur128->rlb_b[1] = -2.0;
-    ebur128->rlb_b[2] = 1.0;
-    ebur128->rlb_a[1] = 2.0 * (K * K - 1.0) / (1.0 + K / Q + K * K);
-    ebur128->rlb_a[2] = (1.0 - K / Q + K * K) / (1.0 + K / Q + K * K);
+    ebur128->kweight[1].b0 = 1.0;
+    ebur128->kweight[1].b1 = -2.0;
+    ebur128->kweight[1].b2 = 1.0;
+    ebur128->kweight[1].a1 = 2.0 * (K * K - 1.0) / (1.0 + K / Q + K * K);
+    ebur128->kweight[1].a2 = (1.0 - K / Q + K * K) / (1.0 + K / Q + K * K);
 
     /* Force 100ms framing in case of metadata injection: the frames must have
      * a granularity of the window overlap to be accurately exploited.
@@ -446,20 +446,26 @@ static int config_audio_output(AVFilterLink *outlink)
                    AV_CH_SURROUND_DIRECT_LEFT               |AV_CH_SURROUND_DIRECT_RIGHT)
 
     ebur128->nb_channels  = nb_channels;
-    ebur128->x            = av_calloc(nb_channels, 3 * sizeof(*ebur128->x));
-    ebur128->y            = av_calloc(nb_channels, 3 * sizeof(*ebur128->y));
-    ebur128->z            = av_calloc(nb_channels, 3 * sizeof(*ebur128->z));
+    ebur128->filter_state = av_calloc(nb_channels, 6 * sizeof(*ebur128->filter_state));
     ebur128->ch_weighting = av_calloc(nb_channels, sizeof(*ebur128->ch_weighting));
-    if (!ebur128->ch_weighting || !ebur128->x || !ebur128->y || !ebur128->z)
+    if (!ebur128->ch_weighting || !ebur128->filter_state)
         return AVERROR(ENOMEM);
 
 #define I400_BINS(x)  ((x) * 4 / 10)
 #define I3000_BINS(x) ((x) * 3)
 
+    /* bins buffer for the two integration window (400ms and 3s), the channels
+     * without weighting are filtered along with the others so that all of
+     * them can be processed at once, their sums are skipped when computing
+     * the loudness */
+    ebur128->i400.cache_size = I400_BINS(outlink->sample_rate);
+    ebur128->i3000.cache_size = I3000_BINS(outlink->sample_rate);
     ebur128->i400.sum = av_calloc(nb_channels, sizeof(*ebur128->i400.sum));
     ebur128->i3000.sum = av_calloc(nb_channels, sizeof(*ebur128->i3000.sum));
-    ebur128->i400.cache = av_calloc(nb_channels, sizeof(*ebur128->i400.cache));
-    ebur128->i3000.cache = av_calloc(nb_channels, sizeof(*ebur128->i3000.cache));
+    ebur128->i400.cache  = av_calloc(ebur128->i400.cache_size,
+                                     nb_channels * sizeof(*ebur128->i400.cache));
+    ebur128->i3000.cache = av_calloc(ebur128->i3000.cache_size,
+                                     nb_channels * sizeof(*ebur128->i3000.cache));
     if (!ebur128->i400.sum || !ebur128->i3000.sum ||
         !ebur128->i400.cache || !ebur128->i3000.cache)
         return AVERROR(ENOMEM);
@@ -474,17 +480,6 @@ static int config_audio_output(AVFilterLink *outlink)
         } else {
             ebur128->ch_weighting[i] = 1.0;
         }
-
-        if (!ebur128->ch_weighting[i])
-            continue;
-
-        /* bins buffer for the two integration window (400ms and 3s) */
-        ebur128->i400.cache_size = I400_BINS(outlink->sample_rate);
-        ebur128->i3000.cache_size = I3000_BINS(outlink->sample_rate);
-        ebur128->i400.cache[i]  = av_calloc(ebur128->i400.cache_size,  sizeof(*ebur128->i400.cache[0]));
-        ebur128->i3000.cache[i] = av_calloc(ebur128->i3000.cache_size, sizeof(*ebur128->i3000.cache[0]));
-        if (!ebur128->i400.cache[i] || !ebur128->i3000.cache[i])
-            return AVERROR(ENOMEM);
     }
 
 #if CONFIG_SWRESAMPLE
@@ -626,6 +621,54 @@ static int gate_update(struct integrator *integ, double power,
     return gate_hist_pos;
 }
 
+/* apply the pre-filter k[0] then the RLB-filter k[1] to the interleaved
+ * samples of all channels, and add the squared output to the 400ms and 3s
+ * sums, replacing the oldest cache entries */
+static void kweight_integrate(double *state, const EBUR128Biquad *k,
+                              const double *samples,
+                              double *cache_400, double *cache_3000,
+                              double *sum_400, double *sum_3000,
+                              int nb_channels, int nb_samples)
+{
+    const EBUR128Biquad *pre = &k[0], *rlb = &k[1];
+
+    for (int ch = 0; ch < nb_channels; ch++) {
+        double *st = state + ch;
+        double x1 = st[0], x2 = st[nb_channels];
+        double y1 = st[2 * nb_channels], y2 = st[3 * nb_channels];
+        double z1 = st[4 * nb_channels], z2 = st[5 * nb_channels];
+        double s400 = sum_400[ch], s3000 = sum_3000[ch];
+
+        for (int n = 0; n < nb_samples; n++) {
+            const int i = n * nb_channels + ch;
+            const double x0 = samples[i];
+            const double y0 = x0 * pre->b0 + x1 * pre->b1 + x2 * pre->b2
+                                           - y1 * pre->a1 - y2 * pre->a2;
+            const double z0 = y0 * rlb->b0 + y1 * rlb->b1 + y2 * rlb->b2
+                                           - z1 * rlb->a1 - z2 * rlb->a2;
+            const double bin = z0 * z0;
+
+            s400  = s400  + bin - cache_400[i];
+            s3000 = s3000 + bin - cache_3000[i];
+            cache_400[i]  = bin;
+            cache_3000[i] = bin;
+
+            x2 = x1; x1 = x0;
+            y2 = y1; y1 = y0;
+            z2 = z1; z1 = z0;
+        }
+
+        st[0]               = x1;
+        st[nb_channels]     = x2;
+        st[2 * nb_channels] = y1;
+        st[3 * nb_channels] = y2;
+        st[4 * nb_channels] = z1;
+        st[5 * nb_channels] = z2;
+        sum_400[ch]  = s400;
+        sum_3000[ch] = s3000;
+    }
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
 {
     int i, ch, idx_insample, ret;
@@ -657,11 +700,32 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
 #endif
 
     for (idx_insample = ebur128->idx_insample; idx_insample < nb_samples; idx_insample++) {
-        const int bin_id_400  = ebur128->i400.cache_pos;
-        const int bin_id_3000 = ebur128->i3000.cache_pos;
+        const double *src = samples + idx_insample * nb_channels;
+        int len = nb_samples - idx_insample;
+
+        /* process up to the end of either cache or the next refresh at once */
+        len = FFMIN(len, ebur128->i400.cache_size  - ebur128->i400.cache_pos);
+        len = FFMIN(len, ebur128->i3000.cache_size - ebur128->i3000.cache_pos);
+        if (inlink->sample_rate / 10 > 0)
+            len = FFMIN(len, inlink->sample_rate / 10 - ebur128->sample_count);
+
+        if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS) {
+            for (i = 0; i < len; i++)
+                for (ch = 0; ch < nb_channels; ch++)
+                    ebur128->sample_peaks[ch] = FFMAX(ebur128->sample_peaks[ch], fabs(src[i * nb_channels + ch]));
+        }
 
-#define MOVE_TO_NEXT_CACHED_ENTRY(time) do {                \
-    ebur128->i##time.cache_pos++;                           \
+        /* apply pre-filter and RLB-filter, then add the new values to the
+         * sums and limit them to the cache size (400ms or 3s) by removing
+         * the oldest ones */
+        kweight_integrate(ebur128->filter_state, ebur128->kweight, src,
+                          ebur128->i400.cache  + ebur128->i400.cache_pos  * nb_channels,
+                          ebur128->i3000.cache + ebur128->i3000.cache_pos * nb_channels,
+                          ebur128->i400.sum, ebur128->i3000.sum,
+                          nb_channels, len);
+
+#define MOVE_TO_NEXT_CACHED_ENTRY(time, n) do {             \
+    ebur128->i##time.cache_pos += n;                        \
     if (ebur128->i##time.cache_pos ==                       \
         ebur128->i##time.cache_size) {                      \
         ebur128->i##time.filled    = 1;                     \
@@ -669,47 +733,11 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
     }                                                       \
 } while (0)
 
-        MOVE_TO_NEXT_CACHED_ENTRY(400);
-        MOVE_TO_NEXT_CACHED_ENTRY(3000);
+        MOVE_TO_NEXT_CACHED_ENTRY(400,  len);
+        MOVE_TO_NEXT_CACHED_ENTRY(3000, len);
 
-        for (ch = 0; ch < nb_channels; ch++) {
-            double bin;
-
-            if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS)
-                ebur128->sample_peaks[ch] = FFMAX(ebur128->sample_peaks[ch], fabs(samples[idx_insample * nb_channels + ch]));
-
-            ebur128->x[ch * 3] = samples[idx_insample * nb_channels + ch]; // set X[i]
-
-            if (!ebur128->ch_weighting[ch])
-                continue;
-
-            /* Y[i] = X[i]*b0 + X[i-1]*b1 + X[i-2]*b2 - Y[i-1]*a1 - Y[i-2]*a2 */
-#define FILTER(Y, X, NUM, DEN) do {                                             \
-            double *dst = ebur128->Y + ch*3;                                    \
-            double *src = ebur128->X + ch*3;                                    \
-            dst[2] = dst[1];                                                    \
-            dst[1] = dst[0];                                                    \
-            dst[0] = src[0]*NUM[0] + src[1]*NUM[1] + src[2]*NUM[2]              \
-                                   - dst[1]*DEN[1] - dst[2]*DEN[2];             \
-} while (0)
-
-            // TODO: merge both filters in one?
-            FILTER(y, x, ebur128->pre_b, ebur128->pre_a);  // apply pre-filter
-            ebur128->x[ch * 3 + 2] = ebur128->x[ch * 3 + 1];
-            ebur128->x[ch * 3 + 1] = ebur128->x[ch * 3    ];
-            FILTER(z, y, ebur128->rlb_b, ebur128->rlb_a);  // apply RLB-filter
-
-            bin = ebur128->z[ch * 3] * ebur128->z[ch * 3];
-
-            /* add the new value, and limit the sum to the cache size (400ms or 3s)
-             * by removing the oldest one */
-            ebur128->i400.sum [ch] = ebur128->i400.sum [ch] + bin - ebur128->i400.cache [ch][bin_id_400];
-            ebur128->i3000.sum[ch] = ebur128->i3000.sum[ch] + bin - ebur128->i3000.cache[ch][bin_id_3000];
-
-            /* override old cache entry with the new value */
-            ebur128->i400.cache [ch][bin_id_400 ] = bin;
-            ebur128->i3000.cache[ch][bin_id_3000] = bin;
-        }
+        /* the refresh below refers to the last sample of the block */
+        idx_insample += len - 1;
 
 #define FIND_PEAK(global, sp, ptype) do {                        \
     int ch;                                                      \
@@ -728,7 +756,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
         /* For integrated loudness, gating blocks are 400ms long with 75%
          * overlap (see BS.1770-2 p5), so a re-computation is needed each 100ms
          * (4800 samples at 48kHz). */
-        if (++ebur128->sample_count == inlink->sample_rate / 10) {
+        ebur128->sample_count += len;
+        if (ebur128->sample_count == inlink->sample_rate / 10) {
             double loudness_400, loudness_3000;
             double power_400 = 1e-12, power_3000 = 1e-12;
             AVFilterLink *outlink = ctx->outputs[0];
@@ -742,7 +771,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
     if (ebur128->i##time.filled) {                                                  \
         /* weighting sum of the last <time> ms */                                   \
         for (ch = 0; ch < nb_channels; ch++)                                        \
-            power_##time += ebur128->ch_weighting[ch] * ebur128->i##time.sum[ch];   \
+            if (ebur128->ch_weighting[ch])                                          \
+                power_##time += ebur128->ch_weighting[ch] * ebur128->i##time.sum[ch]; \
         power_##time /= I##time##_BINS(inlink->sample_rate);                        \
     }                                                                               \
     loudness_##time = LOUDNESS(power_##time);                                       \
@@ -1075,9 +1105,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     }
 
     av_freep(&ebur128->y_line_ref);
-    av_freep(&ebur128->x);
-    av_freep(&ebur128->y);
-    av_freep(&ebur128->z);
+    av_freep(&ebur128->filter_state);
     av_freep(&ebur128->ch_weighting);
     av_freep(&ebur128->true_peaks);
     av_freep(&ebur128->sample_peaks);
@@ -1086,12 +1114,6 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&ebur128->i3000.sum);
     av_freep(&ebur128->i400.histogram);
     av_freep(&ebur128->i3000.histogram);
-    for (int i = 0; i < ebur128->nb_channels; i++) {
-        if (ebur128->i400.cache)
-            av_freep(&ebur128->i400.cache[i]);
-        if (ebur128->i3000.cache)
-            av_freep(&ebur128->i3000.cache[i]);
-    }
     av_freep(&ebur128->i400.cache);
     av_freep(&ebur128->i3000.cache);
     av_frame_free(&ebur128->outpicref);
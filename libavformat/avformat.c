@@ -38,6 +38,7 @@
 #include "avformat.h"
 #include "avformat_internal.h"
 #include "avio.h"
+#include "compactindex.h"
 #include "demux.h"
 #include "mux.h"
 #include "internal.h"
@@ -65,6 +66,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
     avcodec_free_context(&sti->avctx);
     av_bsf_free(&sti->bsfc);
     av_freep(&sti->index_entries);
+    ff_compact_index_free(&sti->compact_index);
     av_freep(&sti->probe_data.buf);
 
     av_bsf_free(&sti->extract_extradata.bsf);
@@ -0,0 +1,331 @@
+/*
+ * Compact in-memory representation of stream indexes
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libavutil/error.h"
+#include "libavutil/macros.h"
+#include "libavutil/mem.h"
+
+#include "compactindex.h"
+
+#define BLOCK_BITS 6
+#define BLOCK_SIZE (1 << BLOCK_BITS)
+/* pos, timestamp and min_distance take up to 10 bytes, size and flags 5 */
+#define MAX_ENTRY_SIZE 35
+
+struct FFCompactIndex {
+    uint8_t *data;
+    size_t data_size;
+    size_t *block_offset;
+    int64_t *block_timestamp;   ///< timestamp of the first entry of each block
+    int nb_entries;
+    int nb_blocks;
+    /* timestamps strictly increase and no entry is discarded, so searching
+     * the first timestamps of the blocks gives the result */
+    int sorted;
+
+    /* decoded blocks, even ones in the first slot and odd ones in the second */
+    AVIndexEntry cache[2][BLOCK_SIZE];
+    int cache_block[2];
+};
+
+/* Values predicted from the previous entry of the block. */
+typedef struct CodingState {
+    uint64_t pos;
+    uint64_t timestamp;
+    uint64_t timestamp_delta;
+    uint64_t min_distance;
+} CodingState;
+
+static uint8_t *put_uvarint(uint8_t *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = v | 0x80;
+        v >>= 7;
+    }
+    *p++ = v;
+    return p;
+}
+
+static uint8_t *put_svarint(uint8_t *p, uint64_t v)
+{
+    return put_uvarint(p, (v << 1) ^ -(v >> 63));
+}
+
+static const uint8_t *get_uvarint(const uint8_t *p, uint64_t *v)
+{
+    uint64_t r = 0;
+    int shift = 0;
+
+    do {
+        r |= (uint64_t)(*p & 0x7f) << shift;
+        shift += 7;
+    } while (*p++ & 0x80);
+    *v = r;
+    return p;
+}
+
+static const uint8_t *get_svarint(const uint8_t *p, uint64_t *v)
+{
+    p = get_uvarint(p, v);
+    *v = (*v >> 1) ^ -(*v & 1);
+    return p;
+}
+
+static uint8_t *encode_entry(uint8_t *p, CodingState *s, const AVIndexEntry *e)
+{
+    uint64_t timestamp_delta = e->timestamp - s->timestamp;
+
+    p = put_svarint(p, e->pos - s->pos);
+    p = put_svarint(p, timestamp_delta - s->timestamp_delta);
+    p = put_uvarint(p, (uint64_t)(uint32_t)e->size << 2 | (e->flags & 3));
+    p = put_svarint(p, (uint64_t)e->min_distance - s->min_distance);
+
+    s->pos             = (uint64_t)e->pos + e->size;
+    s->timestamp       = e->timestamp;
+    s->timestamp_delta = timestamp_delta;
+    s->min_distance    = (uint64_t)e->min_distance + 1;
+    return p;
+}
+
+static void decode_block(FFCompactIndex *ci, int block, AVIndexEntry *entries)
+{
+    const uint8_t *p = ci->data + ci->block_offset[block];
+    int nb = FFMIN(ci->nb_entries - block * BLOCK_SIZE, BLOCK_SIZE);
+    CodingState s = { 0 };
+
+    for (int i = 0; i < nb; i++) {
+        AVIndexEntry *e = &entries[i];
+        uint64_t v;
+
+        p = get_svarint(p, &v);
+        e->pos = s.pos + v;
+        p = get_svarint(p, &v);
+        s.timestamp_delta += v;
+        s.timestamp       += s.timestamp_delta;
+        e->timestamp = s.timestamp;
+        p = get_uvarint(p, &v);
+        e->size  = (int32_t)(uint32_t)(v >> 2);
+        e->flags = v & 3;
+        p = get_svarint(p, &v);
+        e->min_distance = (int32_t)(uint32_t)(s.min_distance + v);
+
+        s.pos          = (uint64_t)e->pos + e->size;
+        s.min_distance = (uint64_t)e->min_distance + 1;
+    }
+}
+
+int ff_compact_index_create(FFCompactIndex **pci, const AVIndexEntry *entries,
+                            int nb_entries)
+{
+    FFCompactIndex *ci;
+    unsigned allocated = 0;
+
+    ci = av_mallocz(sizeof(*ci));
+    if (!ci)
+        return AVERROR(ENOMEM);
+    ci->nb_entries     = nb_entries;
+    ci->nb_blocks      = (nb_entries + BLOCK_SIZE - 1) >> BLOCK_BITS;
+    ci->cache_block[0] =
+    ci->cache_block[1] = -1;
+
+    ci->block_offset    = av_malloc_array(ci->nb_blocks + 1, sizeof(*ci->block_offset));
+    ci->block_timestamp = av_malloc_array(ci->nb_blocks + 1, sizeof(*ci->block_timestamp));
+    if (!ci->block_offset || !ci->block_timestamp)
+        goto fail;
+
+    ci->sorted = 1;
+    for (int i = 0; i < nb_entries; i++) {
+        if ((entries[i].flags & AVINDEX_DISCARD_FRAME) ||
+            (i && entries[i].timestamp <= entries[i - 1].timestamp)) {
+            ci->sorted = 0;
+            break;
+        }
+    }
+
+    for (int block = 0; block < ci->nb_blocks; block++) {
+        uint8_t buf[BLOCK_SIZE * MAX_ENTRY_SIZE], *p = buf;
+        int first = block * BLOCK_SIZE;
+        int nb = FFMIN(nb_entries - first, BLOCK_SIZE);
+        CodingState s = { 0 };
+        uint8_t *data;
+
+        for (int i = 0; i < nb; i++)
+            p = encode_entry(p, &s, &entries[first + i]);
+
+        if (ci->data_size + (p - buf) > UINT_MAX)
+            goto fail;
+        data = av_fast_realloc(ci->data, &allocated, ci->data_size + (p - buf));
+        if (!data)
+            goto fail;
+        ci->data = data;
+        memcpy(ci->data + ci->data_size, buf, p - buf);
+        ci->block_offset[block]    = ci->data_size;
+        ci->block_timestamp[block] = entries[first].timestamp;
+        ci->data_size += p - buf;
+    }
+
+    /* give back the slack left by av_fast_realloc() */
+    if (ci->data_size < allocated) {
+        uint8_t *data = av_realloc(ci->data, ci->data_size);
+        if (data)
+            ci->data = data;
+    }
+
+    *pci = ci;
+    return 0;
+fail:
+    ff_compact_index_free(&ci);
+    return AVERROR(ENOMEM);
+}
+
+void ff_compact_index_free(FFCompactIndex **pci)
+{
+    FFCompactIndex *ci = *pci;
+
+    if (!ci)
+        return;
+    av_freep(&ci->data);
+    av_freep(&ci->block_offset);
+    av_freep(&ci->block_timestamp);
+    av_freep(pci);
+}
+
+int ff_compact_index_nb_entries(const FFCompactIndex *ci)
+{
+    return ci->nb_entries;
+}
+
+AVIndexEntry *ff_compact_index_get(FFCompactIndex *ci, int idx)
+{
+    int block, slot;
+
+    if (idx < 0 || idx >= ci->nb_entries)
+        return NULL;
+
+    block = idx >> BLOCK_BITS;
+    slot  = block & 1;
+    if (ci->cache_block[slot] != block) {
+        decode_block(ci, block, ci->cache[slot]);
+        ci->cache_block[slot] = block;
+    }
+    return &ci->cache[slot][idx & (BLOCK_SIZE - 1)];
+}
+
+int ff_compact_index_expand(FFCompactIndex *ci, AVIndexEntry **pentries)
+{
+    AVIndexEntry *entries;
+
+    entries = av_malloc_array(ci->nb_entries, sizeof(*entries));
+    if (!entries)
+        return AVERROR(ENOMEM);
+    for (int block = 0; block < ci->nb_blocks; block++)
+        decode_block(ci, block, entries + block * BLOCK_SIZE);
+
+    *pentries = entries;
+    return 0;
+}
+
+/**
+ * With strictly increasing timestamps, the search in
+ * ff_index_search_timestamp() always ends with a on the last entry not after
+ * wanted_timestamp and b on the first entry not before it.
+ */
+static void search_sorted(FFCompactIndex *ci, int64_t wanted_timestamp,
+                          int *pa, int *pb)
+{
+    int lo = 0, hi = ci->nb_blocks, a;
+
+    /* find the first block starting after wanted_timestamp */
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (ci->block_timestamp[mid] <= wanted_timestamp)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    a = -1;
+    if (lo) {
+        a = (lo - 1) * BLOCK_SIZE;
+        while (a + 1 < FFMIN(lo * BLOCK_SIZE, ci->nb_entries) &&
+               ff_compact_index_get(ci, a + 1)->timestamp <= wanted_timestamp)
+            a++;
+    }
+
+    *pa = a;
+    *pb = a >= 0 && ff_compact_index_get(ci, a)->timestamp == wanted_timestamp ?
+          a : a + 1;
+}
+
+int ff_compact_index_search(FFCompactIndex *ci, int64_t wanted_timestamp,
+                            int flags)
+{
+    int nb_entries = ci->nb_entries;
+    int a, b, m;
+    int64_t timestamp;
+
+    a = -1;
+    b = nb_entries;
+
+    if (ci->sorted)
+        search_sorted(ci, wanted_timestamp, &a, &b);
+    else if (b && ff_compact_index_get(ci, b - 1)->timestamp < wanted_timestamp)
+        a = b - 1;
+
+    while (b - a > 1) {
+        m = (a + b) >> 1;
+
+        while ((ff_compact_index_get(ci, m)->flags & AVINDEX_DISCARD_FRAME) &&
+               m < b && m < nb_entries - 1) {
+            m++;
+            if (m == b && ff_compact_index_get(ci, m)->timestamp >= wanted_timestamp) {
+                m = b - 1;
+                break;
+            }
+        }
+
+        timestamp = ff_compact_index_get(ci, m)->timestamp;
+        if (timestamp >= wanted_timestamp)
+            b = m;
+        if (timestamp <= wanted_timestamp)
+            a = m;
+    }
+    m = (flags & AVSEEK_FLAG_BACKWARD) ? a : b;
+
+    if (!(flags & AVSEEK_FLAG_ANY))
+        while (m >= 0 && m < nb_entries &&
+               !(ff_compact_index_get(ci, m)->flags & AVINDEX_KEYFRAME))
+            m += (flags & AVSEEK_FLAG_BACKWARD) ? -1 : 1;
+
+    if (m == nb_entries)
+        return -1;
+    return m;
+}
+
+size_t ff_compact_index_memory(const FFCompactIndex *ci)
+{
+    return sizeof(*ci) + ci->data_size +
+           (ci->nb_blocks + 1) * (sizeof(*ci->block_offset) +
+                                  sizeof(*ci->block_timestamp));
+}
@@ -0,0 +1,76 @@
+/*
+ * Compact in-memory representation of stream indexes
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_COMPACTINDEX_H
+#define AVFORMAT_COMPACTINDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "avformat.h"
+
+/**
+ * Read-only index stored as blocks of variable length coded entries.
+ *
+ * Within a block, the position of an entry is coded relative to the end of
+ * the previous entry, the timestamp relative to the previous timestamp plus
+ * the previous timestamp delta, and min_distance relative to the previous
+ * value plus one, so entries of regularly interleaved constant frame rate
+ * tracks take a few bytes instead of sizeof(AVIndexEntry). The offset of
+ * every block is kept, so any entry is reached by decoding a single block.
+ *
+ * Decoded blocks are cached. An entry returned by ff_compact_index_get()
+ * stays valid until an entry of a block which is neither its own block nor
+ * one adjacent to it is requested.
+ */
+typedef struct FFCompactIndex FFCompactIndex;
+
+/**
+ * Create a compact index holding the given entries.
+ */
+int ff_compact_index_create(FFCompactIndex **pci, const AVIndexEntry *entries,
+                            int nb_entries);
+
+void ff_compact_index_free(FFCompactIndex **pci);
+
+int ff_compact_index_nb_entries(const FFCompactIndex *ci);
+
+/**
+ * @return the entry at idx, or NULL if idx is out of range
+ */
+AVIndexEntry *ff_compact_index_get(FFCompactIndex *ci, int idx);
+
+/**
+ * Expand the index into a newly allocated array of entries.
+ */
+int ff_compact_index_expand(FFCompactIndex *ci, AVIndexEntry **entries);
+
+/**
+ * Same as ff_index_search_timestamp() on the entries of the index.
+ */
+int ff_compact_index_search(FFCompactIndex *ci, int64_t wanted_timestamp,
+                            int flags);
+
+/**
+ * @return the amount of memory used by the index, in bytes
+ */
+size_t ff_compact_index_memory(const FFCompactIndex *ci);
+
+#endif /* AVFORMAT_COMPACTINDEX_H */
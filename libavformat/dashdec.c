@@ -30,6 +30,7 @@
 #include "avio_internal.h"
 #include "dash.h"
 #include "demux.h"
+#include "prefetch.h"
 #include "url.h"
 
 #define INITIAL_BUFFER_SIZE 32768
@@ -118,6 +119,12 @@ struct representation {
     uint32_t init_sec_buf_read_offset;
     int64_t cur_timestamp;
     int is_restart_needed;
+
+    /* Data of the current fragment if it was served by the prefetch
+     * window, read instead of input. */
+    AVBufferRef *seg_buf;
+
+    FFPrefetchContext *prefetch;
 };
 
 typedef struct DASHContext {
@@ -160,6 +167,12 @@ typedef struct DASHContext {
     int is_init_section_common_audio;
     int is_init_section_common_subtitle;
 
+    int prefetch_segments;
+    int64_t prefetch_max_size;
+    int64_t prefetch_coalesce_size;
+    int64_t prefetch_hits;
+    int64_t prefetch_misses;
+    int64_t prefetch_stalls;
 } DASHContext;
 
 static int ishttp(char *url)
@@ -350,6 +363,8 @@ static void free_timelines_list(struct representation *pls)
 
 static void free_representation(struct representation *pls)
 {
+    ff_prefetch_free(&pls->prefetch);
+    av_buffer_unref(&pls->seg_buf);
     free_fragment_list(pls);
     free_timelines_list(pls);
     free_fragment(&pls->cur_seg);
@@ -401,14 +416,11 @@ static void free_subtitle_list(DASHContext *c)
     c->n_subtitles = 0;
 }
 
-static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
-                    AVDictionary **opts, AVDictionary *opts2, int *is_http)
+static int check_url(AVFormatContext *s, const char *url, int *is_http)
 {
     DASHContext *c = s->priv_data;
-    AVDictionary *tmp = NULL;
     const char *proto_name = NULL;
     int proto_name_len;
-    int ret;
 
     if (av_strstart(url, "crypto", NULL)) {
         if (url[6] == '+' || url[6] == ':')
@@ -443,6 +455,21 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
     else if (strcmp(proto_name, "file") || !strncmp(url, "file,", 5))
         return AVERROR_INVALIDDATA;
 
+    *is_http = av_strstart(proto_name, "http", NULL);
+    return 0;
+}
+
+static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
+                    AVDictionary **opts, AVDictionary *opts2, int *is_http)
+{
+    DASHContext *c = s->priv_data;
+    AVDictionary *tmp = NULL;
+    int http;
+    int ret;
+
+    if ((ret = check_url(s, url, &http)) < 0)
+        return ret;
+
     av_freep(pb);
     av_dict_copy(&tmp, *opts, 0);
     av_dict_copy(&tmp, opts2, 0);
@@ -463,7 +490,7 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
     av_dict_free(&tmp);
 
     if (is_http)
-        *is_http = av_strstart(proto_name, "http", NULL);
+        *is_http = http;
 
     return ret;
 }
@@ -1582,6 +1609,35 @@ finish:
     return ret;
 }
 
+static int fill_template_fragment(struct representation *pls, struct fragment *seg, int64_t seq_no)
+{
+    DASHContext *c = pls->parent->priv_data;
+    char *tmpfilename;
+
+    if (!pls->url_template) {
+        av_log(pls->parent, AV_LOG_ERROR, "Cannot get fragment, missing template URL\n");
+        return AVERROR_INVALIDDATA;
+    }
+    tmpfilename = av_mallocz(c->max_url_size);
+    if (!tmpfilename)
+        return AVERROR(ENOMEM);
+    ff_dash_fill_tmpl_params(tmpfilename, c->max_url_size, pls->url_template, 0, seq_no, 0, get_segment_start_time_based_on_timeline(pls, seq_no));
+    seg->url = av_strireplace(pls->url_template, pls->url_template, tmpfilename);
+    if (!seg->url) {
+        av_log(pls->parent, AV_LOG_WARNING, "Unable to resolve template url '%s', try to use origin template\n", pls->url_template);
+        seg->url = av_strdup(pls->url_template);
+        if (!seg->url) {
+            av_log(pls->parent, AV_LOG_ERROR, "Cannot resolve template url '%s'\n", pls->url_template);
+            av_free(tmpfilename);
+            return AVERROR(ENOMEM);
+        }
+    }
+    av_free(tmpfilename);
+    seg->size = -1;
+
+    return 0;
+}
+
 static struct fragment *get_current_fragment(struct representation *pls)
 {
     int64_t min_seq_no = 0;
@@ -1634,32 +1690,34 @@ static struct fragment *get_current_fragment(struct representation *pls)
             return NULL;
         }
     }
-    if (seg) {
-        char *tmpfilename;
-        if (!pls->url_template) {
-            av_log(pls->parent, AV_LOG_ERROR, "Cannot get fragment, missing template URL\n");
-            av_free(seg);
-            return NULL;
-        }
-        tmpfilename = av_mallocz(c->max_url_size);
-        if (!tmpfilename) {
+    if (seg && fill_template_fragment(pls, seg, pls->cur_seq_no) < 0)
+        av_freep(&seg);
+
+    return seg;
+}
+
+/* Fragment seq_no of a VOD representation, or NULL if there is none. */
+static struct fragment *get_vod_fragment(struct representation *pls, int64_t seq_no)
+{
+    struct fragment *seg;
+
+    if (pls->n_fragments > 0 ? seq_no >= pls->n_fragments : seq_no > pls->last_seq_no)
+        return NULL;
+
+    seg = av_mallocz(sizeof(struct fragment));
+    if (!seg)
+        return NULL;
+
+    if (pls->n_fragments > 0) {
+        seg->url = av_strdup(pls->fragments[seq_no]->url);
+        if (!seg->url) {
             av_free(seg);
             return NULL;
         }
-        ff_dash_fill_tmpl_params(tmpfilename, c->max_url_size, pls->url_template, 0, pls->cur_seq_no, 0, get_segment_start_time_based_on_timeline(pls, pls->cur_seq_no));
-        seg->url = av_strireplace(pls->url_template, pls->url_template, tmpfilename);
-        if (!seg->url) {
-            av_log(pls->parent, AV_LOG_WARNING, "Unable to resolve template url '%s', try to use origin template\n", pls->url_template);
-            seg->url = av_strdup(pls->url_template);
-            if (!seg->url) {
-                av_log(pls->parent, AV_LOG_ERROR, "Cannot resolve template url '%s'\n", pls->url_template);
-                av_free(tmpfilename);
-                av_free(seg);
-                return NULL;
-            }
-        }
-        av_free(tmpfilename);
-        seg->size = -1;
+        seg->size = pls->fragments[seq_no]->size;
+        seg->url_offset = pls->fragments[seq_no]->url_offset;
+    } else if (fill_template_fragment(pls, seg, seq_no) < 0) {
+        av_freep(&seg);
     }
 
     return seg;
@@ -1670,6 +1728,15 @@ static int read_from_url(struct representation *pls, struct fragment *seg,
 {
     int ret;
 
+    if (pls->seg_buf) {
+        buf_size = FFMIN(buf_size, pls->seg_buf->size - pls->cur_seg_offset);
+        if (buf_size <= 0)
+            return AVERROR_EOF;
+        memcpy(buf, pls->seg_buf->data + pls->cur_seg_offset, buf_size);
+        pls->cur_seg_offset += buf_size;
+        return buf_size;
+    }
+
     /* limit read if the fragment was only a part of a file */
     if (seg->size >= 0)
         buf_size = FFMIN(buf_size, pls->cur_seg_size - pls->cur_seg_offset);
@@ -1762,6 +1829,14 @@ static int update_init_section(struct representation *pls)
 static int64_t seek_data(void *opaque, int64_t offset, int whence)
 {
     struct representation *v = opaque;
+    if (v->seg_buf && !v->init_sec_data_len) {
+        if (whence == AVSEEK_SIZE)
+            return v->seg_buf->size;
+        if (whence != SEEK_SET || offset < 0 || offset > v->seg_buf->size)
+            return AVERROR(EINVAL);
+        v->cur_seg_offset = offset;
+        return offset;
+    }
     if (v->n_fragments && !v->init_sec_data_len) {
         return avio_seek(v->input, offset, whence);
     }
@@ -1769,6 +1844,66 @@ static int64_t seek_data(void *opaque, int64_t offset, int whence)
     return AVERROR(ENOSYS);
 }
 
+static int prefetch_get_segment(void *opaque, int64_t seq_no, char **url,
+                                int64_t *url_offset, int64_t *size)
+{
+    struct representation *pls = opaque;
+    DASHContext *c = pls->parent->priv_data;
+    struct fragment *seg = get_vod_fragment(pls, seq_no);
+
+    if (!seg)
+        return AVERROR_EOF;
+    *url = av_mallocz(c->max_url_size);
+    if (!*url) {
+        free_fragment(&seg);
+        return AVERROR(ENOMEM);
+    }
+    ff_make_absolute_url(*url, c->max_url_size, c->base_url, seg->url);
+    *url_offset = seg->url_offset;
+    *size       = seg->size;
+    free_fragment(&seg);
+    return 0;
+}
+
+/**
+ * Take the current fragment from the prefetch window.
+ *
+ * @return 1 if pls->seg_buf was set, 0 if the fragment has to be opened
+ *         directly, a negative error code on interruption
+ */
+static int prefetch_open_fragment(DASHContext *c, struct representation *pls)
+{
+    int batch = 1, stalled, ret;
+
+    /* live manifests are refreshed while reading and single fragment
+     * representations are read (and seeked) as one file */
+    if (c->is_live || pls->n_fragments == 1)
+        return 0;
+
+    if (!pls->prefetch) {
+        ret = ff_prefetch_init(&pls->prefetch, pls->parent, c->prefetch_segments,
+                               c->prefetch_max_size, c->prefetch_coalesce_size,
+                               check_url, prefetch_get_segment, pls);
+        if (ret < 0) {
+            c->prefetch_segments = 0;
+            return 0;
+        }
+    }
+
+    if (c->prefetch_coalesce_size && pls->n_fragments > 0)
+        batch = (c->prefetch_segments + 1) / 2;
+    ff_prefetch_schedule(pls->prefetch, pls->cur_seq_no, batch, c->avio_opts);
+    ret = ff_prefetch_get(pls->prefetch, pls->cur_seq_no, &pls->seg_buf,
+                          &c->avio_opts, &stalled);
+    c->prefetch_stalls += stalled;
+    if (ret > 0)
+        c->prefetch_hits++;
+    else if (!ret)
+        c->prefetch_misses++;
+
+    return ret;
+}
+
 static int read_data(void *opaque, uint8_t *buf, int buf_size)
 {
     int ret = 0;
@@ -1776,7 +1911,7 @@ static int read_data(void *opaque, uint8_t *buf, int buf_size)
     DASHContext *c = v->parent->priv_data;
 
 restart:
-    if (!v->input) {
+    if (!v->input && !v->seg_buf) {
         free_fragment(&v->cur_seg);
         v->cur_seg = get_current_fragment(v);
         if (!v->cur_seg) {
@@ -1789,7 +1924,19 @@ restart:
         if (ret)
             goto end;
 
-        ret = open_input(c, v, v->cur_seg);
+        ret = 0;
+        if (c->prefetch_segments) {
+            ret = prefetch_open_fragment(c, v);
+            if (ret < 0)
+                goto end;
+            if (ret) {
+                v->cur_seg_offset = 0;
+                v->cur_seg_size   = v->seg_buf->size;
+                ret = 0;
+            }
+        }
+        if (!v->seg_buf)
+            ret = open_input(c, v, v->cur_seg);
         if (ret < 0) {
             if (ff_check_interrupt(c->interrupt_callback)) {
                 ret = AVERROR_EXIT;
@@ -2210,6 +2357,7 @@ static int dash_read_packet(AVFormatContext *s, AVPacket *pkt)
             cur->init_sec_buf_read_offset = 0;
             cur->is_restart_needed = 0;
             ff_format_io_close(cur->parent, &cur->input);
+            av_buffer_unref(&cur->seg_buf);
             ret = reopen_demux_for_component(s, cur);
         }
     }
@@ -2248,6 +2396,7 @@ static int dash_seek(AVFormatContext *s, struct representation *pls, int64_t see
     }
 
     ff_format_io_close(pls->parent, &pls->input);
+    av_buffer_unref(&pls->seg_buf);
 
     // find the nearest fragment
     if (pls->n_timelines > 0 && pls->fragment_timescale > 0) {
@@ -2346,6 +2495,18 @@ static const AVOption dash_options[] = {
         {.str = "aac,m4a,m4s,m4v,mov,mp4,webm,ts"},
         INT_MIN, INT_MAX, FLAGS},
     { "cenc_decryption_key", "Media decryption key (hex)", OFFSET(cenc_decryption_key), AV_OPT_TYPE_STRING, {.str = NULL}, INT_MIN, INT_MAX, .flags = FLAGS },
+    { "prefetch_segments", "Number of fragments to download ahead per representation, 0 = disable",
+        OFFSET(prefetch_segments), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 64, FLAGS },
+    { "prefetch_max_size", "Stop prefetching while this many bytes per representation are buffered",
+        OFFSET(prefetch_max_size), AV_OPT_TYPE_INT64, {.i64 = 64 << 20}, 0, INT64_MAX, FLAGS },
+    { "prefetch_coalesce_size", "Maximum size of a request coalescing adjacent byte ranges, 0 = disable",
+        OFFSET(prefetch_coalesce_size), AV_OPT_TYPE_INT64, {.i64 = 8 << 20}, 0, INT64_MAX, FLAGS },
+    { "prefetch_hits", "Number of fragments read from the prefetch window",
+        OFFSET(prefetch_hits), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, FLAGS | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "prefetch_misses", "Number of fragments opened directly while prefetching",
+        OFFSET(prefetch_misses), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, FLAGS | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "prefetch_stalls", "Number of times reading waited for a fragment being prefetched",
+        OFFSET(prefetch_stalls), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, FLAGS | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     {NULL}
 };
 
@@ -51,6 +51,7 @@
 #include "http.h"
 #endif
 #include "internal.h"
+#include "ioqueue.h"
 #include "isom.h"
 #include "mux.h"
 #include "os_support.h"
@@ -204,6 +205,14 @@ typedef struct DASHContext {
     AVRational min_playback_rate;
     AVRational max_playback_rate;
     int64_t update_period;
+    int async_io;
+    int async_io_queue;
+    int64_t async_io_max_size;
+    int64_t async_io_stalls;
+    int64_t async_io_stall_time;
+    int64_t async_io_peak_size;
+    FFIOQueue *io_queue;
+    AVIOContext *io_queue_out; /* written by the queue thread */
 } DASHContext;
 
 static const struct codec_string {
@@ -218,8 +227,8 @@ static const struct codec_string {
     { AV_CODEC_ID_NONE }
 };
 
-static int dashenc_io_open(AVFormatContext *s, AVIOContext **pb, char *filename,
-                           AVDictionary **options) {
+static int dashenc_io_open_direct(AVFormatContext *s, AVIOContext **pb, const char *filename,
+                                  AVDictionary **options) {
     DASHContext *c = s->priv_data;
     int http_base_proto = filename ? ff_is_http_proto(filename) : 0;
     int err = AVERROR_MUXER_NOT_FOUND;
@@ -237,7 +246,7 @@ static int dashenc_io_open(AVFormatContext *s, AVIOContext **pb, char *filename,
     return err;
 }
 
-static void dashenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename) {
+static void dashenc_io_close_direct(AVFormatContext *s, AVIOContext **pb, const char *filename) {
     DASHContext *c = s->priv_data;
     int http_base_proto = filename ? ff_is_http_proto(filename) : 0;
 
@@ -256,6 +265,35 @@ static void dashenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filenam
     }
 }
 
+/* With async_io, files are written to memory and handed to the queue thread
+ * when closed. */
+static int dashenc_io_open(AVFormatContext *s, AVIOContext **pb, char *filename,
+                           AVDictionary **options) {
+    DASHContext *c = s->priv_data;
+
+    if (c->io_queue)
+        return ff_ioqueue_open(c->io_queue, pb, filename, options);
+    return dashenc_io_open_direct(s, pb, filename, options);
+}
+
+static void dashenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename) {
+    DASHContext *c = s->priv_data;
+
+    if (c->io_queue)
+        ff_ioqueue_close(c->io_queue, pb);
+    else
+        dashenc_io_close_direct(s, pb, filename);
+}
+
+static int dashenc_rename(AVFormatContext *s, const char *oldpath, const char *newpath)
+{
+    DASHContext *c = s->priv_data;
+
+    if (c->io_queue)
+        return ff_ioqueue_rename(c->io_queue, oldpath, newpath);
+    return ff_rename(oldpath, newpath, s);
+}
+
 static const char *get_format_str(SegmentType segment_type)
 {
     switch (segment_type) {
@@ -482,6 +520,79 @@ static void set_http_options(AVDictionary **options, DASHContext *c)
         av_dict_set_int(options, "timeout", c->timeout, 0);
 }
 
+static void dashenc_delete_file_direct(AVFormatContext *s, const char *filename) {
+    DASHContext *c = s->priv_data;
+    int http_base_proto = ff_is_http_proto(filename);
+
+    if (http_base_proto) {
+        AVDictionary *http_opts = NULL;
+
+        set_http_options(&http_opts, c);
+        av_dict_set(&http_opts, "method", "DELETE", 0);
+
+        if (dashenc_io_open_direct(s, &c->http_delete, filename, &http_opts) < 0) {
+            av_log(s, AV_LOG_ERROR, "failed to delete %s\n", filename);
+        }
+        av_dict_free(&http_opts);
+
+        //Nothing to write
+        dashenc_io_close_direct(s, &c->http_delete, filename);
+    } else {
+        int res = ffurl_delete(filename);
+        if (res < 0) {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(res, errbuf, sizeof(errbuf));
+            av_log(s, (res == AVERROR(ENOENT) ? AV_LOG_WARNING : AV_LOG_ERROR), "failed to delete %s: %s\n", filename, errbuf);
+        }
+    }
+}
+
+static void dashenc_delete_file(AVFormatContext *s, char *filename) {
+    DASHContext *c = s->priv_data;
+
+    if (c->io_queue)
+        ff_ioqueue_delete(c->io_queue, filename);
+    else
+        dashenc_delete_file_direct(s, filename);
+}
+
+static int dash_run_io_job(AVFormatContext *s, FFIOQueueJob *job)
+{
+    DASHContext *c = s->priv_data;
+    AVDictionary *options = NULL;
+    int ret;
+
+    switch (job->op) {
+    case FF_IOQUEUE_WRITE:
+        av_dict_copy(&options, job->options, 0);
+        ret = dashenc_io_open_direct(s, &c->io_queue_out, job->filename, &options);
+        av_dict_free(&options);
+        if (ret < 0)
+            return handle_io_open_error(s, ret, job->filename);
+        avio_write(c->io_queue_out, job->data, job->size);
+        dashenc_io_close_direct(s, &c->io_queue_out, job->filename);
+        return 0;
+    case FF_IOQUEUE_RENAME:
+        return ff_rename(job->filename, job->new_filename, s);
+    case FF_IOQUEUE_DELETE:
+        dashenc_delete_file_direct(s, job->filename);
+        return 0;
+    }
+    return AVERROR_BUG;
+}
+
+static void dash_update_io_stats(DASHContext *c)
+{
+    FFIOQueueStats stats;
+
+    if (!c->io_queue)
+        return;
+    ff_ioqueue_get_stats(c->io_queue, &stats);
+    c->async_io_stalls     = stats.stalls;
+    c->async_io_stall_time = stats.stall_time;
+    c->async_io_peak_size  = stats.peak_size;
+}
+
 static void get_hls_playlist_name(char *playlist_name, int string_size,
                                   const char *base_url, int id) {
     if (base_url)
@@ -576,7 +687,7 @@ static void write_hls_media_playlist(OutputStream *os, AVFormatContext *s,
     dashenc_io_close(s, &c->m3u8_out, temp_filename_hls);
 
     if (use_rename)
-        ff_rename(temp_filename_hls, filename_hls, os->ctx);
+        dashenc_rename(s, temp_filename_hls, filename_hls);
 }
 
 static int flush_init_segment(AVFormatContext *s, OutputStream *os)
@@ -602,6 +713,9 @@ static void dash_free(AVFormatContext *s)
     DASHContext *c = s->priv_data;
     int i, j;
 
+    ff_ioqueue_free(&c->io_queue);
+    ff_format_io_close(s, &c->io_queue_out);
+
     if (c->as) {
         for (i = 0; i < c->nb_as; i++) {
             av_dict_free(&c->as[i].metadata);
@@ -1240,7 +1354,7 @@ static int write_manifest(AVFormatContext *s, int final)
     dashenc_io_close(s, &c->mpd_out, temp_filename);
 
     if (use_rename) {
-        if ((ret = ff_rename(temp_filename, s->url, s)) < 0)
+        if ((ret = dashenc_rename(s, temp_filename, s->url)) < 0)
             return ret;
     }
 
@@ -1356,7 +1470,7 @@ static int write_manifest(AVFormatContext *s, int final)
 
         dashenc_io_close(s, &c->m3u8_out, temp_filename);
         if (use_rename)
-            if ((ret = ff_rename(temp_filename, filename_hls, s)) < 0)
+            if ((ret = dashenc_rename(s, temp_filename, filename_hls)) < 0)
                 return ret;
         c->master_playlist_created = 1;
     }
@@ -1459,6 +1573,27 @@ static int dash_init(AVFormatContext *s)
         c->min_playback_rate = c->max_playback_rate = (AVRational) {1, 1};
     }
 
+    if (c->async_io) {
+        if (c->single_file || c->streaming) {
+            av_log(s, AV_LOG_WARNING, "'async_io' is not supported with single_file "
+                   "or streaming output, writing synchronously\n");
+        } else if (!ff_format_io_open_is_default(s)) {
+            /* Custom io_open/io_close2 callbacks are not required to be
+             * thread safe, so never call them from the queue thread. */
+            av_log(s, AV_LOG_WARNING, "'async_io' is not supported with custom "
+                   "I/O callbacks, writing synchronously\n");
+        } else {
+            ret = ff_ioqueue_alloc(&c->io_queue, s, dash_run_io_job,
+                                   c->async_io_queue, c->async_io_max_size);
+            if (ret == AVERROR(ENOSYS)) {
+                av_log(s, AV_LOG_WARNING, "'async_io' requires threads, "
+                       "writing synchronously\n");
+            } else if (ret < 0) {
+                return ret;
+            }
+        }
+    }
+
     av_strlcpy(c->dirname, s->url, sizeof(c->dirname));
     ptr = strrchr(c->dirname, '/');
     if (ptr) {
@@ -1583,7 +1718,7 @@ static int dash_init(AVFormatContext *s)
         if (!c->single_file) {
             if ((ret = avio_open_dyn_buf(&ctx->pb)) < 0)
                 return ret;
-            ret = s->io_open(s, &os->out, filename, AVIO_FLAG_WRITE, &opts);
+            ret = dashenc_io_open(s, &os->out, filename, &opts);
         } else {
             ctx->url = av_strdup(filename);
             ret = avio_open2(&ctx->pb, filename, AVIO_FLAG_WRITE, NULL, &opts);
@@ -1845,33 +1980,6 @@ static int update_stream_extradata(AVFormatContext *s, OutputStream *os,
     return 0;
 }
 
-static void dashenc_delete_file(AVFormatContext *s, char *filename) {
-    DASHContext *c = s->priv_data;
-    int http_base_proto = ff_is_http_proto(filename);
-
-    if (http_base_proto) {
-        AVDictionary *http_opts = NULL;
-
-        set_http_options(&http_opts, c);
-        av_dict_set(&http_opts, "method", "DELETE", 0);
-
-        if (dashenc_io_open(s, &c->http_delete, filename, &http_opts) < 0) {
-            av_log(s, AV_LOG_ERROR, "failed to delete %s\n", filename);
-        }
-        av_dict_free(&http_opts);
-
-        //Nothing to write
-        dashenc_io_close(s, &c->http_delete, filename);
-    } else {
-        int res = ffurl_delete(filename);
-        if (res < 0) {
-            char errbuf[AV_ERROR_MAX_STRING_SIZE];
-            av_strerror(res, errbuf, sizeof(errbuf));
-            av_log(s, (res == AVERROR(ENOENT) ? AV_LOG_WARNING : AV_LOG_ERROR), "failed to delete %s: %s\n", filename, errbuf);
-        }
-    }
-}
-
 static int dashenc_delete_segment_file(AVFormatContext *s, const char* file)
 {
     DASHContext *c = s->priv_data;
@@ -1967,7 +2075,7 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
             dashenc_io_close(s, &os->out, os->temp_path);
 
             if (use_rename) {
-                ret = ff_rename(os->temp_path, os->full_path, os->ctx);
+                ret = dashenc_rename(s, os->temp_path, os->full_path);
                 if (ret < 0)
                     break;
             }
@@ -2036,6 +2144,7 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         if (!c->streaming || final)
             ret = write_manifest(s, final);
     }
+    dash_update_io_stats(c);
     return ret;
 }
 
@@ -2330,6 +2439,13 @@ static int dash_write_trailer(AVFormatContext *s)
         }
     }
 
+    if (c->io_queue) {
+        int ret = ff_ioqueue_flush(c->io_queue);
+        dash_update_io_stats(c);
+        if (ret < 0)
+            return ret;
+    }
+
     return 0;
 }
 
@@ -2358,6 +2474,12 @@ static int dash_check_bitstream(AVFormatContext *s, AVStream *st,
 #define E AV_OPT_FLAG_ENCODING_PARAM
 static const AVOption options[] = {
     { "adaptation_sets", "Adaptation sets. Syntax: id=0,streams=0,1,2 id=1,streams=3,4 and so on", OFFSET(adaptation_sets), AV_OPT_TYPE_STRING, { 0 }, 0, 0, AV_OPT_FLAG_ENCODING_PARAM },
+    { "async_io", "write segments and manifests from a background thread", OFFSET(async_io), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    { "async_io_max_size", "maximum amount of queued data in bytes", OFFSET(async_io_max_size), AV_OPT_TYPE_INT64, { .i64 = 64 << 20 }, 0, INT64_MAX, E },
+    { "async_io_peak_size", "largest amount of queued data in bytes", OFFSET(async_io_peak_size), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "async_io_queue", "maximum number of queued file operations", OFFSET(async_io_queue), AV_OPT_TYPE_INT, { .i64 = 32 }, 1, 1024, E },
+    { "async_io_stall_time", "time muxing waited for the I/O thread, in microseconds", OFFSET(async_io_stall_time), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "async_io_stalls", "number of times muxing waited for the I/O thread", OFFSET(async_io_stalls), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { "dash_segment_type", "set dash segment files type", OFFSET(segment_type_option), AV_OPT_TYPE_INT, {.i64 = SEGMENT_TYPE_AUTO }, 0, SEGMENT_TYPE_NB - 1, E, .unit = "segment_type"},
         { "auto", "select segment file format based on codec", 0, AV_OPT_TYPE_CONST, {.i64 = SEGMENT_TYPE_AUTO }, 0, UINT_MAX,   E, .unit = "segment_type"},
         { "mp4", "make segment file in ISOBMFF format", 0, AV_OPT_TYPE_CONST, {.i64 = SEGMENT_TYPE_MP4 }, 0, UINT_MAX,   E, .unit = "segment_type"},
@@ -238,6 +238,25 @@ int ff_add_index_entry(AVIndexEntry **index_entries,
 
 void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance);
 
+/**
+ * Store the index of a stream in a compact form taking a fraction of the
+ * memory, for demuxers that are done modifying it. Entries are then only
+ * reachable through ff_index_get_entry() and the public index functions.
+ */
+int ff_index_compact(AVStream *st);
+
+/**
+ * Turn an index compacted by ff_index_compact() back into an array.
+ */
+int ff_index_expand(AVStream *st);
+
+/**
+ * Get an entry of the index of a stream, compacted or not. An entry of a
+ * compacted index stays valid until entries further away than the
+ * neighbouring ones are requested, and changes to it are not kept.
+ */
+AVIndexEntry *ff_index_get_entry(AVStream *st, int idx);
+
 /**
  * Ensure the index uses less memory than the maximum specified in
  * AVFormatContext.max_index_size by discarding entries if it grows
@@ -22,10 +22,12 @@
 #include "config_components.h"
 
 #include "libavutil/avstring.h"
+#include "libavutil/bprint.h"
 #include "libavutil/hash.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
+#include "libavutil/slicethread.h"
 #include "avformat.h"
 #include "internal.h"
 #include "mux.h"
@@ -33,9 +35,18 @@
 struct HashContext {
     const AVClass *avclass;
     struct AVHashContext **hashes;
+    int nb_hashes;
     char *hash_name;
     int per_stream;
     int format_version;
+
+    /* frame hashing on worker threads, one hash context per thread */
+    int hash_threads;
+    AVSliceThread *slicethread;
+    AVPacket **batch;
+    AVBPrint *lines;
+    int batch_size;
+    int nb_batched;
 };
 
 #define OFFSET(x) offsetof(struct HashContext, x)
@@ -44,6 +55,8 @@ struct HashContext {
     { "hash", "set hash to use", OFFSET(hash_name), AV_OPT_TYPE_STRING, {.str = defaulttype}, 0, 0, ENC }
 #define FORMAT_VERSION_OPT \
     { "format_version", "file format version", OFFSET(format_version), AV_OPT_TYPE_INT, {.i64 = 2}, 1, 2, ENC }
+#define HASH_THREADS_OPT \
+    { "hash_threads", "number of threads hashing frames, 0 for automatic", OFFSET(hash_threads), AV_OPT_TYPE_INT, {.i64 = 1}, 0, INT_MAX, ENC }
 
 #if CONFIG_HASH_MUXER || CONFIG_STREAMHASH_MUXER
 static const AVOption hash_streamhash_options[] = {
@@ -63,6 +76,7 @@ static const AVClass hash_streamhashenc_class = {
 static const AVOption framehash_options[] = {
     HASH_OPT("sha256"),
     FORMAT_VERSION_OPT,
+    HASH_THREADS_OPT,
     { NULL },
 };
 #endif
@@ -78,6 +92,7 @@ static const AVOption md5_options[] = {
 static const AVOption framemd5_options[] = {
     HASH_OPT("md5"),
     FORMAT_VERSION_OPT,
+    HASH_THREADS_OPT,
     { NULL },
 };
 #endif
@@ -91,6 +106,7 @@ static int hash_init(struct AVFormatContext *s)
     c->hashes = av_mallocz(sizeof(*c->hashes));
     if (!c->hashes)
         return AVERROR(ENOMEM);
+    c->nb_hashes = 1;
     res = av_hash_alloc(&c->hashes[0], c->hash_name);
     if (res < 0)
         return res;
@@ -108,6 +124,7 @@ static int streamhash_init(struct AVFormatContext *s)
     c->hashes = av_calloc(s->nb_streams, sizeof(*c->hashes));
     if (!c->hashes)
         return AVERROR(ENOMEM);
+    c->nb_hashes = s->nb_streams;
     for (i = 0; i < s->nb_streams; i++) {
         res = av_hash_alloc(&c->hashes[i], c->hash_name);
         if (res < 0) {
@@ -165,12 +182,19 @@ static void hash_free(struct AVFormatContext *s)
 {
     struct HashContext *c = s->priv_data;
     if (c->hashes) {
-        int num_hashes = c->per_stream ? s->nb_streams : 1;
-        for (int i = 0; i < num_hashes; i++) {
+        for (int i = 0; i < c->nb_hashes; i++) {
             av_hash_freep(&c->hashes[i]);
         }
     }
     av_freep(&c->hashes);
+
+    avpriv_slicethread_free(&c->slicethread);
+    if (c->batch) {
+        for (int i = 0; i < c->batch_size; i++)
+            av_packet_free(&c->batch[i]);
+    }
+    av_freep(&c->batch);
+    av_freep(&c->lines);
 }
 
 #if CONFIG_HASH_MUXER
@@ -232,6 +256,8 @@ const FFOutputFormat ff_streamhash_muxer = {
 #endif
 
 #if CONFIG_FRAMEHASH_MUXER || CONFIG_FRAMEMD5_MUXER
+#define FRAMEHASH_BATCH_PER_THREAD 8
+
 static void framehash_print_extradata(struct AVFormatContext *s)
 {
     int i;
@@ -253,17 +279,52 @@ static void framehash_print_extradata(struct AVFormatContext *s)
     }
 }
 
+static void framehash_worker(void *priv, int jobnr, int threadnr,
+                             int nb_jobs, int nb_threads);
+
 static int framehash_init(struct AVFormatContext *s)
 {
-    int res;
+    int res, nb_threads = 1;
     struct HashContext *c = s->priv_data;
     c->per_stream = 0;
-    c->hashes = av_mallocz(sizeof(*c->hashes));
+
+    if (c->hash_threads != 1) {
+        res = avpriv_slicethread_create(&c->slicethread, s, framehash_worker,
+                                        NULL, c->hash_threads);
+        if (res == AVERROR(ENOSYS)) {
+            av_log(s, AV_LOG_WARNING, "No thread support, hashing frames "
+                   "on the muxer thread\n");
+        } else if (res < 0) {
+            return res;
+        } else {
+            nb_threads = res;
+        }
+    }
+
+    c->hashes = av_calloc(nb_threads, sizeof(*c->hashes));
     if (!c->hashes)
         return AVERROR(ENOMEM);
-    res = av_hash_alloc(&c->hashes[0], c->hash_name);
-    if (res < 0)
-        return res;
+    c->nb_hashes = nb_threads;
+    for (int i = 0; i < nb_threads; i++) {
+        res = av_hash_alloc(&c->hashes[i], c->hash_name);
+        if (res < 0)
+            return res;
+    }
+
+    if (c->slicethread) {
+        /* enough packets per batch for the threads not to wait on each
+         * other at the end of a batch */
+        c->batch_size = nb_threads * FRAMEHASH_BATCH_PER_THREAD;
+        c->batch = av_calloc(c->batch_size, sizeof(*c->batch));
+        c->lines = av_calloc(c->batch_size, sizeof(*c->lines));
+        if (!c->batch || !c->lines)
+            return AVERROR(ENOMEM);
+        for (int i = 0; i < c->batch_size; i++) {
+            c->batch[i] = av_packet_alloc();
+            if (!c->batch[i])
+                return AVERROR(ENOMEM);
+        }
+    }
     return 0;
 }
 
@@ -279,42 +340,102 @@ static int framehash_write_header(struct AVFormatContext *s)
     return 0;
 }
 
-static int framehash_write_packet(struct AVFormatContext *s, AVPacket *pkt)
+static void framehash_print_packet(AVBPrint *bp, struct AVHashContext *hash,
+                                   const AVPacket *pkt, int format_version)
 {
-    struct HashContext *c = s->priv_data;
-    char buf[AV_HASH_MAX_SIZE*2+128];
-    int len;
-    av_hash_init(c->hashes[0]);
-    av_hash_update(c->hashes[0], pkt->data, pkt->size);
-
-    snprintf(buf, sizeof(buf) - (AV_HASH_MAX_SIZE * 2 + 1), "%d, %10"PRId64", %10"PRId64", %8"PRId64", %8d, ",
-             pkt->stream_index, pkt->dts, pkt->pts, pkt->duration, pkt->size);
-    len = strlen(buf);
-    av_hash_final_hex(c->hashes[0], buf + len, sizeof(buf) - len);
-    avio_write(s->pb, buf, strlen(buf));
-
-    if (c->format_version > 1 && pkt->side_data_elems) {
-        int i;
-        avio_printf(s->pb, ", S=%d", pkt->side_data_elems);
-        for (i = 0; i < pkt->side_data_elems; i++) {
-            av_hash_init(c->hashes[0]);
+    char buf[AV_HASH_MAX_SIZE*2+1];
+
+    av_hash_init(hash);
+    av_hash_update(hash, pkt->data, pkt->size);
+    av_hash_final_hex(hash, buf, sizeof(buf));
+    av_bprintf(bp, "%d, %10"PRId64", %10"PRId64", %8"PRId64", %8d, %s",
+               pkt->stream_index, pkt->dts, pkt->pts, pkt->duration, pkt->size, buf);
+
+    if (format_version > 1 && pkt->side_data_elems) {
+        av_bprintf(bp, ", S=%d", pkt->side_data_elems);
+        for (int i = 0; i < pkt->side_data_elems; i++) {
+            av_hash_init(hash);
             if (HAVE_BIGENDIAN && pkt->side_data[i].type == AV_PKT_DATA_PALETTE) {
                 for (size_t j = 0; j < pkt->side_data[i].size; j += sizeof(uint32_t)) {
                     uint32_t data = AV_RL32(pkt->side_data[i].data + j);
-                    av_hash_update(c->hashes[0], (uint8_t *)&data, sizeof(uint32_t));
+                    av_hash_update(hash, (uint8_t *)&data, sizeof(uint32_t));
                 }
             } else
-                av_hash_update(c->hashes[0], pkt->side_data[i].data, pkt->side_data[i].size);
-            snprintf(buf, sizeof(buf) - (AV_HASH_MAX_SIZE * 2 + 1),
-                     ", %8"SIZE_SPECIFIER", ", pkt->side_data[i].size);
-            len = strlen(buf);
-            av_hash_final_hex(c->hashes[0], buf + len, sizeof(buf) - len);
-            avio_write(s->pb, buf, strlen(buf));
+                av_hash_update(hash, pkt->side_data[i].data, pkt->side_data[i].size);
+            av_hash_final_hex(hash, buf, sizeof(buf));
+            av_bprintf(bp, ", %8"SIZE_SPECIFIER", %s", pkt->side_data[i].size, buf);
         }
     }
 
-    avio_printf(s->pb, "\n");
-    return 0;
+    av_bprintf(bp, "\n");
+}
+
+static int framehash_write_line(struct AVFormatContext *s, AVBPrint *bp)
+{
+    int ret = av_bprint_is_complete(bp) ? 0 : AVERROR(ENOMEM);
+
+    if (!ret)
+        avio_write(s->pb, bp->str, bp->len);
+    av_bprint_finalize(bp, NULL);
+    return ret;
+}
+
+static void framehash_worker(void *priv, int jobnr, int threadnr,
+                             int nb_jobs, int nb_threads)
+{
+    struct AVFormatContext *s = priv;
+    struct HashContext *c = s->priv_data;
+
+    av_bprint_init(&c->lines[jobnr], 0, AV_BPRINT_SIZE_UNLIMITED);
+    framehash_print_packet(&c->lines[jobnr], c->hashes[threadnr],
+                           c->batch[jobnr], c->format_version);
+    av_packet_unref(c->batch[jobnr]);
+}
+
+/* hash the batched packets on the worker threads and write their lines
+ * in the order the packets were received */
+static int framehash_flush_batch(struct AVFormatContext *s)
+{
+    struct HashContext *c = s->priv_data;
+    int nb = c->nb_batched, ret = 0;
+
+    if (!nb)
+        return 0;
+    avpriv_slicethread_execute(c->slicethread, nb, 0);
+    c->nb_batched = 0;
+
+    for (int i = 0; i < nb; i++) {
+        int err = framehash_write_line(s, &c->lines[i]);
+        if (err < 0 && !ret)
+            ret = err;
+    }
+    return ret;
+}
+
+static int framehash_write_packet(struct AVFormatContext *s, AVPacket *pkt)
+{
+    struct HashContext *c = s->priv_data;
+    AVBPrint bp;
+    int ret;
+
+    if (c->slicethread) {
+        ret = av_packet_ref(c->batch[c->nb_batched], pkt);
+        if (ret < 0)
+            return ret;
+        if (++c->nb_batched == c->batch_size)
+            return framehash_flush_batch(s);
+        return 0;
+    }
+
+    av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+    framehash_print_packet(&bp, c->hashes[0], pkt, c->format_version);
+    return framehash_write_line(s, &bp);
+}
+
+static int framehash_write_trailer(struct AVFormatContext *s)
+{
+    struct HashContext *c = s->priv_data;
+    return c->slicethread ? framehash_flush_batch(s) : 0;
 }
 #endif
 
@@ -335,6 +456,7 @@ const FFOutputFormat ff_framehash_muxer = {
     .init              = framehash_init,
     .write_header      = framehash_write_header,
     .write_packet      = framehash_write_packet,
+    .write_trailer     = framehash_write_trailer,
     .deinit            = hash_free,
     .p.flags           = AVFMT_VARIABLE_FPS | AVFMT_TS_NONSTRICT |
                          AVFMT_TS_NEGATIVE,
@@ -359,6 +481,7 @@ const FFOutputFormat ff_framemd5_muxer = {
     .init              = framehash_init,
     .write_header      = framehash_write_header,
     .write_packet      = framehash_write_packet,
+    .write_trailer     = framehash_write_trailer,
     .deinit            = hash_free,
     .p.flags           = AVFMT_VARIABLE_FPS | AVFMT_TS_NONSTRICT |
                          AVFMT_TS_NEGATIVE,
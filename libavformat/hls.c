@@ -44,6 +44,7 @@
 #include "internal.h"
 #include "avio_internal.h"
 #include "id3v2.h"
+#include "prefetch.h"
 #include "url.h"
 
 #include "hls_sample_encryption.h"
@@ -173,6 +174,13 @@ struct playlist {
      * playlist, if any. */
     int n_init_sections;
     struct segment **init_sections;
+
+    /* Data of the current segment if it was served by the prefetch
+     * window, read instead of input. */
+    AVBufferRef *seg_buf;
+
+    /* Prefetch window, NULL if no segment was prefetched yet. */
+    FFPrefetchContext *prefetch;
 };
 
 /*
@@ -228,6 +236,11 @@ typedef struct HLSContext {
     int http_multiple;
     int http_seekable;
     int seg_max_retry;
+    int prefetch_segments;
+    int64_t prefetch_max_size;
+    int64_t prefetch_hits;
+    int64_t prefetch_misses;
+    int64_t prefetch_stalls;
     AVIOContext *playlist_pb;
     HLSCryptoContext  crypto_ctx;
 } HLSContext;
@@ -266,6 +279,8 @@ static void free_playlist_list(HLSContext *c)
     int i;
     for (i = 0; i < c->n_playlists; i++) {
         struct playlist *pls = c->playlists[i];
+        ff_prefetch_free(&pls->prefetch);
+        av_buffer_unref(&pls->seg_buf);
         free_segment_list(pls);
         free_init_section_list(pls);
         av_freep(&pls->main_streams);
@@ -644,13 +659,11 @@ static int open_url_keepalive(AVFormatContext *s, AVIOContext **pb,
 #endif
 }
 
-static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
-                    AVDictionary **opts, AVDictionary *opts2, int *is_http_out)
+/* Check that url uses one of the protocols allowed for playlists and segments. */
+static int check_url(AVFormatContext *s, const char *url, int *is_http_out)
 {
     HLSContext *c = s->priv_data;
-    AVDictionary *tmp = NULL;
     const char *proto_name = NULL;
-    int ret;
     int is_http = 0;
 
     if (av_strstart(url, "crypto", NULL)) {
@@ -692,6 +705,21 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
     else if (strcmp(proto_name, "file") || !strncmp(url, "file,", 5))
         return AVERROR_INVALIDDATA;
 
+    *is_http_out = is_http;
+    return 0;
+}
+
+static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
+                    AVDictionary **opts, AVDictionary *opts2, int *is_http_out)
+{
+    HLSContext *c = s->priv_data;
+    AVDictionary *tmp = NULL;
+    int ret;
+    int is_http = 0;
+
+    if ((ret = check_url(s, url, &is_http)) < 0)
+        return ret;
+
     av_dict_copy(&tmp, *opts, 0);
     av_dict_copy(&tmp, opts2, 0);
 
@@ -1068,6 +1096,15 @@ static int read_from_url(struct playlist *pls, struct segment *seg,
 {
     int ret;
 
+    if (pls->seg_buf) {
+        buf_size = FFMIN(buf_size, pls->seg_buf->size - pls->cur_seg_offset);
+        if (buf_size <= 0)
+            return AVERROR_EOF;
+        memcpy(buf, pls->seg_buf->data + pls->cur_seg_offset, buf_size);
+        pls->cur_seg_offset += buf_size;
+        return buf_size;
+    }
+
      /* limit read if the segment was only a part of a file */
     if (seg->size >= 0)
         buf_size = FFMIN(buf_size, seg->size - pls->cur_seg_offset);
@@ -1473,6 +1510,67 @@ static int playlist_needed(struct playlist *pls)
     return 0;
 }
 
+static int prefetch_get_segment(void *opaque, int64_t seq_no, char **url,
+                                int64_t *url_offset, int64_t *size)
+{
+    struct playlist *pls = opaque;
+    int64_t n = seq_no - pls->start_seq_no;
+    struct segment *seg;
+
+    if (n < 0 || n >= pls->n_segments)
+        return AVERROR_EOF;
+    seg = pls->segments[n];
+    /* keys are fetched by the demuxer thread, see open_input() */
+    if (seg->key_type != KEY_NONE)
+        return 1;
+
+    *url = av_strdup(seg->url);
+    if (!*url)
+        return AVERROR(ENOMEM);
+    *url_offset = seg->url_offset;
+    *size       = seg->size;
+    return 0;
+}
+
+/**
+ * Take the current segment from the prefetch window.
+ *
+ * @return 1 if pls->seg_buf was set, 0 if the segment has to be opened
+ *         directly, a negative error code on interruption
+ */
+static int prefetch_open_segment(HLSContext *c, struct playlist *pls)
+{
+    int stalled, ret;
+
+    if (!pls->prefetch) {
+        /* the segments are not opened with s->io_open, see ff_prefetch_init() */
+        if (!ff_format_io_open_is_default(pls->parent)) {
+            av_log(pls->parent, AV_LOG_WARNING,
+                   "Prefetching is not supported with a custom io_open callback, disabling it\n");
+            c->prefetch_segments = 0;
+            return 0;
+        }
+        ret = ff_prefetch_init(&pls->prefetch, pls->parent, c->prefetch_segments,
+                               c->prefetch_max_size, 0, check_url,
+                               prefetch_get_segment, pls);
+        if (ret < 0) {
+            c->prefetch_segments = 0;
+            return 0;
+        }
+    }
+
+    ff_prefetch_schedule(pls->prefetch, pls->cur_seq_no, 1, c->avio_opts);
+    ret = ff_prefetch_get(pls->prefetch, pls->cur_seq_no, &pls->seg_buf,
+                          &c->avio_opts, &stalled);
+    c->prefetch_stalls += stalled;
+    if (ret > 0)
+        c->prefetch_hits++;
+    else if (!ret)
+        c->prefetch_misses++;
+
+    return ret;
+}
+
 static int read_data(void *opaque, uint8_t *buf, int buf_size)
 {
     struct playlist *v = opaque;
@@ -1487,7 +1585,7 @@ restart:
     if (!v->needed)
         return AVERROR_EOF;
 
-    if (!v->input || (c->http_persistent && v->input_read_done)) {
+    if (!v->seg_buf && (!v->input || (c->http_persistent && v->input_read_done))) {
         int64_t reload_interval;
 
         /* Check that the playlist is still needed before opening a new
@@ -1563,6 +1661,11 @@ reload:
             v->cur_seg_offset = 0;
             v->input_next_requested = 0;
             ret = 0;
+        } else if (c->prefetch_segments && (ret = prefetch_open_segment(c, v))) {
+            if (ret < 0)
+                return ret;
+            v->cur_seg_offset = 0;
+            ret = 0;
         } else {
             ret = open_input(c, v, seg, &v->input);
         }
@@ -1587,7 +1690,7 @@ reload:
         just_opened = 1;
     }
 
-    if (c->http_multiple == -1) {
+    if (c->http_multiple == -1 && v->input) {
         uint8_t *http_version_opt = NULL;
         int r = av_opt_get(v->input, "http_version", AV_OPT_SEARCH_CHILDREN, &http_version_opt);
         if (r >= 0) {
@@ -1597,7 +1700,7 @@ reload:
     }
 
     seg = next_segment(v);
-    if (c->http_multiple == 1 && !v->input_next_requested &&
+    if (c->http_multiple == 1 && !c->prefetch_segments && !v->input_next_requested &&
         seg && seg->key_type == KEY_NONE && av_strstart(seg->url, "http", NULL)) {
         ret = open_input(c, v, seg, &v->input_next);
         if (ret < 0) {
@@ -1630,7 +1733,11 @@ reload:
 
         return ret;
     }
-    if (c->http_persistent &&
+    if (v->seg_buf) {
+        av_buffer_unref(&v->seg_buf);
+        /* a persistent connection left open by an earlier segment is idle */
+        v->input_read_done = 1;
+    } else if (c->http_persistent &&
         seg->key_type == KEY_NONE && av_strstart(seg->url, "http", NULL)) {
         v->input_read_done = 1;
     } else {
@@ -2498,6 +2605,7 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
         pls->input_read_done = 0;
         ff_format_io_close(pls->parent, &pls->input_next);
         pls->input_next_requested = 0;
+        av_buffer_unref(&pls->seg_buf);
         av_packet_unref(pls->pkt);
         pb->eof_reached = 0;
         /* Clear any buffered data */
@@ -2590,6 +2698,16 @@ static const AVOption hls_options[] = {
         OFFSET(seg_format_opts), AV_OPT_TYPE_DICT, {.str = NULL}, 0, 0, FLAGS},
     {"seg_max_retry", "Maximum number of times to reload a segment on error.",
      OFFSET(seg_max_retry), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, FLAGS},
+    {"prefetch_segments", "Number of segments to download ahead per playlist, 0 = disable",
+        OFFSET(prefetch_segments), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 64, FLAGS},
+    {"prefetch_max_size", "Stop prefetching while this many bytes per playlist are buffered",
+        OFFSET(prefetch_max_size), AV_OPT_TYPE_INT64, {.i64 = 64 << 20}, 0, INT64_MAX, FLAGS},
+    {"prefetch_hits", "Number of segments read from the prefetch window",
+        OFFSET(prefetch_hits), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, FLAGS | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY},
+    {"prefetch_misses", "Number of segments opened directly while prefetching",
+        OFFSET(prefetch_misses), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, FLAGS | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY},
+    {"prefetch_stalls", "Number of times reading waited for a segment being prefetched",
+        OFFSET(prefetch_stalls), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, FLAGS | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY},
     {NULL}
 };
 
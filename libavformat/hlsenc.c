@@ -50,6 +50,7 @@
 #endif
 #include "hlsplaylist.h"
 #include "internal.h"
+#include "ioqueue.h"
 #include "nal.h"
 #include "mux.h"
 #include "os_support.h"
@@ -263,6 +264,15 @@ typedef struct HLSContext {
     char *headers;
     int has_default_key; /* has DEFAULT field of var_stream_map */
     int has_video_m3u8; /* has video stream m3u8 list */
+
+    int async_io;
+    int async_io_queue;
+    int64_t async_io_max_size;
+    int64_t async_io_stalls;
+    int64_t async_io_stall_time;
+    int64_t async_io_peak_size;
+    FFIOQueue *io_queue;
+    AVIOContext *io_queue_out; /* written by the queue thread */
 } HLSContext;
 
 static int strftime_expand(const char *fmt, char **dest)
@@ -288,8 +298,8 @@ static int strftime_expand(const char *fmt, char **dest)
     return r;
 }
 
-static int hlsenc_io_open(AVFormatContext *s, AVIOContext **pb, const char *filename,
-                          AVDictionary **options)
+static int hlsenc_io_open_direct(AVFormatContext *s, AVIOContext **pb, const char *filename,
+                                 AVDictionary **options)
 {
     HLSContext *hls = s->priv_data;
     int http_base_proto = filename ? ff_is_http_proto(filename) : 0;
@@ -309,7 +319,7 @@ static int hlsenc_io_open(AVFormatContext *s, AVIOContext **pb, const char *file
     return err;
 }
 
-static int hlsenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename)
+static int hlsenc_io_close_direct(AVFormatContext *s, AVIOContext **pb, const char *filename)
 {
     HLSContext *hls = s->priv_data;
     int http_base_proto = filename ? ff_is_http_proto(filename) : 0;
@@ -329,6 +339,36 @@ static int hlsenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename)
     return ret;
 }
 
+/* With async_io, files are written to memory and handed to the queue thread
+ * when closed. */
+static int hlsenc_io_open(AVFormatContext *s, AVIOContext **pb, const char *filename,
+                          AVDictionary **options)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (hls->io_queue)
+        return ff_ioqueue_open(hls->io_queue, pb, filename, options);
+    return hlsenc_io_open_direct(s, pb, filename, options);
+}
+
+static int hlsenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (hls->io_queue)
+        return ff_ioqueue_close(hls->io_queue, pb);
+    return hlsenc_io_close_direct(s, pb, filename);
+}
+
+static int hlsenc_rename(AVFormatContext *s, const char *oldpath, const char *newpath)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (hls->io_queue)
+        return ff_ioqueue_rename(hls->io_queue, oldpath, newpath);
+    return ff_rename(oldpath, newpath, s);
+}
+
 static void set_http_options(AVFormatContext *s, AVDictionary **options, HLSContext *c)
 {
     int http_base_proto = ff_is_http_proto(s->url);
@@ -577,8 +617,8 @@ static void reflush_dynbuf(VariantStream *vs, int *range_length)
     avio_write(vs->out, vs->temp_buffer, *range_length);
 }
 
-static int hls_delete_file(HLSContext *hls, AVFormatContext *avf,
-                           char *path, const char *proto)
+static int hls_delete_file_direct(HLSContext *hls, AVFormatContext *avf,
+                                  const char *path, const char *proto)
 {
     if (hls->method || (proto && !av_strcasecmp(proto, "http"))) {
         AVDictionary *opt = NULL;
@@ -587,13 +627,13 @@ static int hls_delete_file(HLSContext *hls, AVFormatContext *avf,
         set_http_options(avf, &opt, hls);
         av_dict_set(&opt, "method", "DELETE", 0);
 
-        ret = hlsenc_io_open(avf, &hls->http_delete, path, &opt);
+        ret = hlsenc_io_open_direct(avf, &hls->http_delete, path, &opt);
         av_dict_free(&opt);
         if (ret < 0)
             return hls->ignore_io_errors ? 1 : ret;
 
         //Nothing to write
-        hlsenc_io_close(avf, &hls->http_delete, path);
+        hlsenc_io_close_direct(avf, &hls->http_delete, path);
     } else if (unlink(path) < 0) {
         av_log(hls, AV_LOG_ERROR, "failed to delete old segment %s: %s\n",
                path, strerror(errno));
@@ -601,6 +641,76 @@ static int hls_delete_file(HLSContext *hls, AVFormatContext *avf,
     return 0;
 }
 
+static int hls_delete_file(HLSContext *hls, AVFormatContext *avf,
+                           char *path, const char *proto)
+{
+    if (hls->io_queue)
+        return ff_ioqueue_delete(hls->io_queue, path);
+    return hls_delete_file_direct(hls, avf, path, proto);
+}
+
+static int hls_write_queued_file(AVFormatContext *s, FFIOQueueJob *job)
+{
+    HLSContext *hls = s->priv_data;
+    AVDictionary *options = NULL;
+    int ret;
+
+    av_dict_copy(&options, job->options, 0);
+    ret = hlsenc_io_open_direct(s, &hls->io_queue_out, job->filename, &options);
+    av_dict_free(&options);
+    if (ret < 0) {
+        av_log(s, hls->ignore_io_errors ? AV_LOG_WARNING : AV_LOG_ERROR,
+               "Failed to open file '%s'\n", job->filename);
+        return hls->ignore_io_errors ? 0 : ret;
+    }
+    avio_write(hls->io_queue_out, job->data, job->size);
+    ret = hlsenc_io_close_direct(s, &hls->io_queue_out, job->filename);
+    if (ret < 0) {
+        av_log(s, AV_LOG_WARNING, "upload of '%s' failed,"
+               " will retry with a new http session.\n", job->filename);
+        ff_format_io_close(s, &hls->io_queue_out);
+        av_dict_copy(&options, job->options, 0);
+        ret = hlsenc_io_open_direct(s, &hls->io_queue_out, job->filename, &options);
+        av_dict_free(&options);
+        if (ret >= 0) {
+            avio_write(hls->io_queue_out, job->data, job->size);
+            ret = hlsenc_io_close_direct(s, &hls->io_queue_out, job->filename);
+        }
+    }
+    return ret;
+}
+
+static int hls_run_io_job(AVFormatContext *s, FFIOQueueJob *job)
+{
+    HLSContext *hls = s->priv_data;
+    int ret;
+
+    switch (job->op) {
+    case FF_IOQUEUE_WRITE:
+        return hls_write_queued_file(s, job);
+    case FF_IOQUEUE_RENAME:
+        /* failed renames are not fatal, as in synchronous mode */
+        ff_rename(job->filename, job->new_filename, s);
+        return 0;
+    case FF_IOQUEUE_DELETE:
+        ret = hls_delete_file_direct(hls, s, job->filename, avio_find_protocol_name(s->url));
+        return FFMIN(ret, 0);
+    }
+    return AVERROR_BUG;
+}
+
+static void hls_update_io_stats(HLSContext *hls)
+{
+    FFIOQueueStats stats;
+
+    if (!hls->io_queue)
+        return;
+    ff_ioqueue_get_stats(hls->io_queue, &stats);
+    hls->async_io_stalls     = stats.stalls;
+    hls->async_io_stall_time = stats.stall_time;
+    hls->async_io_peak_size  = stats.peak_size;
+}
+
 static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls,
                                    VariantStream *vs)
 {
@@ -1053,10 +1163,11 @@ static int sls_flag_check_duration_size(HLSContext *hls, VariantStream *vs)
     return ret;
 }
 
-static void sls_flag_file_rename(HLSContext *hls, VariantStream *vs, char *old_filename) {
+static void sls_flag_file_rename(AVFormatContext *s, VariantStream *vs, char *old_filename) {
+    HLSContext *hls = s->priv_data;
     if ((hls->flags & (HLS_SECOND_LEVEL_SEGMENT_SIZE | HLS_SECOND_LEVEL_SEGMENT_DURATION)) &&
         strlen(vs->current_segment_final_filename_fmt)) {
-        ff_rename(old_filename, vs->avf->url, hls);
+        hlsenc_rename(s, old_filename, vs->avf->url);
     }
 }
 
@@ -1368,7 +1479,7 @@ static int hls_rename_temp_file(AVFormatContext *s, AVFormatContext *oc)
     if (!final_filename)
         return AVERROR(ENOMEM);
     final_filename[len-4] = '\0';
-    ret = ff_rename(oc->url, final_filename, s);
+    ret = hlsenc_rename(s, oc->url, final_filename);
     oc->url[len-4] = '\0';
     av_freep(&final_filename);
     return ret;
@@ -1585,7 +1696,7 @@ fail:
         hls->master_m3u8_created = 1;
     hlsenc_io_close(s, &hls->m3u8_out, temp_filename);
     if (use_temp_file)
-        ff_rename(temp_filename, hls->master_m3u8_url, s);
+        hlsenc_rename(s, temp_filename, hls->master_m3u8_url);
 
     return ret;
 }
@@ -1723,9 +1834,9 @@ fail:
     }
     hlsenc_io_close(s, &hls->sub_m3u8_out, vs->vtt_m3u8_name);
     if (use_temp_file) {
-        ff_rename(temp_filename, vs->m3u8_name, s);
+        hlsenc_rename(s, temp_filename, vs->m3u8_name);
         if (vs->vtt_m3u8_name)
-            ff_rename(temp_vtt_filename, vs->vtt_m3u8_name, s);
+            hlsenc_rename(s, temp_vtt_filename, vs->vtt_m3u8_name);
     }
     if (ret >= 0 && hls->master_pl_name)
         if (create_master_playlist(s, vs, last) < 0)
@@ -2715,7 +2826,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         } else if (hls->max_seg_size > 0) {
             if (vs->size + vs->start_pos >= hls->max_seg_size) {
                 vs->sequence++;
-                sls_flag_file_rename(hls, vs, old_filename);
+                sls_flag_file_rename(s, vs, old_filename);
                 ret = hls_start(s, vs);
                 vs->start_pos = 0;
                 /* When split segment by byte, the duration is short than hls_time,
@@ -2725,11 +2836,12 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
             }
         } else {
             vs->start_pos = 0;
-            sls_flag_file_rename(hls, vs, old_filename);
+            sls_flag_file_rename(s, vs, old_filename);
             ret = hls_start(s, vs);
         }
         vs->number++;
         av_freep(&old_filename);
+        hls_update_io_stats(hls);
 
         if (ret < 0) {
             return ret;
@@ -2777,6 +2889,8 @@ static void hls_deinit(AVFormatContext *s)
         av_freep(&vs->streams);
     }
 
+    ff_ioqueue_free(&hls->io_queue);
+    ff_format_io_close(s, &hls->io_queue_out);
     ff_format_io_close(s, &hls->m3u8_out);
     ff_format_io_close(s, &hls->sub_m3u8_out);
     ff_format_io_close(s, &hls->http_delete);
@@ -2839,7 +2953,8 @@ static int hls_write_trailer(struct AVFormatContext *s)
                 vs->start_pos = range_length;
                 byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
                 if (!byterange_mode) {
-                    ff_format_io_close(s, &vs->out);
+                    if (!hls->io_queue)
+                        ff_format_io_close(s, &vs->out);
                     hlsenc_io_close(s, &vs->out, vs->base_output_dirname);
                 }
             }
@@ -2903,13 +3018,16 @@ failed:
         /* after av_write_trailer, then duration + 1 duration per packet */
         hls_append_segment(s, hls, vs, vs->duration + vs->dpp, vs->start_pos, vs->size);
 
-        sls_flag_file_rename(hls, vs, old_filename);
+        sls_flag_file_rename(s, vs, old_filename);
 
         if (vtt_oc) {
             if (vtt_oc->pb)
                 av_write_trailer(vtt_oc);
             vs->size = avio_tell(vs->vtt_avf->pb) - vs->start_pos;
-            ff_format_io_close(s, &vtt_oc->pb);
+            if (hls->io_queue)
+                hlsenc_io_close(s, &vtt_oc->pb, vtt_oc->url);
+            else
+                ff_format_io_close(s, &vtt_oc->pb);
         }
         ret = hls_window(s, 1, vs);
         if (ret < 0) {
@@ -2922,6 +3040,13 @@ failed:
         av_free(old_filename);
     }
 
+    if (hls->io_queue) {
+        ret = ff_ioqueue_flush(hls->io_queue);
+        hls_update_io_stats(hls);
+        if (ret < 0)
+            return ret;
+    }
+
     return 0;
 }
 
@@ -3022,6 +3147,27 @@ static int hls_init(AVFormatContext *s)
                "enabled together. Disabling 'independent_segments' flag\n");
     }
 
+    if (hls->async_io) {
+        if ((hls->flags & HLS_SINGLE_FILE) || hls->max_seg_size > 0) {
+            av_log(s, AV_LOG_WARNING, "'async_io' is not supported with byte range "
+                   "segments, writing synchronously\n");
+        } else if (!ff_format_io_open_is_default(s)) {
+            /* Custom io_open/io_close2 callbacks are not required to be
+             * thread safe, so never call them from the queue thread. */
+            av_log(s, AV_LOG_WARNING, "'async_io' is not supported with custom "
+                   "I/O callbacks, writing synchronously\n");
+        } else {
+            ret = ff_ioqueue_alloc(&hls->io_queue, s, hls_run_io_job,
+                                   hls->async_io_queue, hls->async_io_max_size);
+            if (ret == AVERROR(ENOSYS)) {
+                av_log(s, AV_LOG_WARNING, "'async_io' requires threads, "
+                       "writing synchronously\n");
+            } else if (ret < 0) {
+                return ret;
+            }
+        }
+    }
+
     for (i = 0; i < hls->nb_varstreams; i++) {
         vs = &hls->var_streams[i];
 
@@ -3238,6 +3384,12 @@ static const AVOption options[] = {
     {"timeout", "set timeout for socket I/O operations", OFFSET(timeout), AV_OPT_TYPE_DURATION, { .i64 = -1 }, -1, INT_MAX, .flags = E },
     {"ignore_io_errors", "Ignore IO errors for stable long-duration runs with network output", OFFSET(ignore_io_errors), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     {"headers", "set custom HTTP headers, can override built in default headers", OFFSET(headers), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, E },
+    {"async_io", "write segments and playlists from a background thread", OFFSET(async_io), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    {"async_io_queue", "maximum number of queued file operations", OFFSET(async_io_queue), AV_OPT_TYPE_INT, { .i64 = 32 }, 1, 1024, E },
+    {"async_io_max_size", "maximum amount of queued data in bytes", OFFSET(async_io_max_size), AV_OPT_TYPE_INT64, { .i64 = 64 << 20 }, 0, INT64_MAX, E },
+    {"async_io_stalls", "number of times muxing waited for the I/O thread", OFFSET(async_io_stalls), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    {"async_io_stall_time", "time muxing waited for the I/O thread, in microseconds", OFFSET(async_io_stall_time), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    {"async_io_peak_size", "largest amount of queued data in bytes", OFFSET(async_io_peak_size), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { NULL },
 };
 
@@ -210,6 +210,11 @@ typedef struct FFStream {
                                     support seeking natively. */
     int nb_index_entries;
     unsigned int index_entries_allocated_size;
+    /**
+     * Compacted index set by ff_index_compact(). When set, index_entries is
+     * NULL and entries must be accessed with ff_index_get_entry().
+     */
+    struct FFCompactIndex *compact_index;
 
     int64_t interleaver_chunk_size;
     int64_t interleaver_chunk_duration;
@@ -626,6 +631,13 @@ int ff_copy_whiteblacklists(AVFormatContext *dst, const AVFormatContext *src);
  */
 int ff_format_io_close(AVFormatContext *s, AVIOContext **pb);
 
+/**
+ * Check whether AVFormatContext.io_open is still the default one, i.e.
+ * whether URLs may be opened with ffio_open_whitelist() directly, for
+ * example from another thread, without bypassing a user callback.
+ */
+int ff_format_io_open_is_default(const AVFormatContext *s);
+
 /**
  * Utility function to check if the file uses http or https protocol
  *
@@ -0,0 +1,353 @@
+/*
+ * Background output queue for segmenting muxers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/error.h"
+#include "libavutil/fifo.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+
+#include "avio_internal.h"
+#include "ioqueue.h"
+
+#if HAVE_THREADS
+
+/* a file opened by ff_ioqueue_open() */
+typedef struct PendingFile {
+    AVIOContext **pb;
+    char *filename;
+    AVDictionary *options;
+} PendingFile;
+
+struct FFIOQueue {
+    AVFormatContext *s;
+    FFIOQueueRunFn run;
+    int max_jobs;
+    int64_t max_size;
+
+    pthread_t thread;
+    AVMutex mutex;
+    AVCond cond;
+
+    /* protected by mutex */
+    AVFifo *jobs;
+    int64_t size;   ///< data of the queued and the running operation
+    int busy;       ///< an operation is running
+    int finish;
+    int error;
+    FFIOQueueStats stats;
+
+    /* only accessed by the muxing thread */
+    PendingFile *pending;
+    int nb_pending;
+};
+
+static void free_job(FFIOQueueJob *job)
+{
+    av_freep(&job->filename);
+    av_freep(&job->new_filename);
+    av_dict_free(&job->options);
+    av_freep(&job->data);
+}
+
+static void *ioqueue_thread(void *arg)
+{
+    FFIOQueue *q = arg;
+
+    ff_mutex_lock(&q->mutex);
+    while (1) {
+        FFIOQueueJob job;
+        int ret = 0;
+
+        if (av_fifo_read(q->jobs, &job, 1) < 0) {
+            if (q->finish)
+                break;
+            ff_cond_wait(&q->cond, &q->mutex);
+            continue;
+        }
+
+        q->busy = 1;
+        if (!q->error) {
+            ff_mutex_unlock(&q->mutex);
+            ret = q->run(q->s, &job);
+            ff_mutex_lock(&q->mutex);
+        }
+        q->busy  = 0;
+        q->size -= job.size;
+        if (ret < 0 && !q->error)
+            q->error = ret;
+        free_job(&job);
+        ff_cond_broadcast(&q->cond);
+    }
+    ff_mutex_unlock(&q->mutex);
+
+    return NULL;
+}
+
+int ff_ioqueue_alloc(FFIOQueue **pq, AVFormatContext *s, FFIOQueueRunFn run,
+                     int max_jobs, int64_t max_size)
+{
+    FFIOQueue *q;
+    int ret;
+
+    q = av_mallocz(sizeof(*q));
+    if (!q)
+        return AVERROR(ENOMEM);
+    q->s        = s;
+    q->run      = run;
+    q->max_jobs = FFMAX(max_jobs, 1);
+    q->max_size = max_size;
+
+    q->jobs = av_fifo_alloc2(q->max_jobs, sizeof(FFIOQueueJob), 0);
+    if (!q->jobs) {
+        av_free(q);
+        return AVERROR(ENOMEM);
+    }
+    if ((ret = ff_mutex_init(&q->mutex, NULL))) {
+        av_fifo_freep2(&q->jobs);
+        av_free(q);
+        return AVERROR(ret);
+    }
+    if ((ret = ff_cond_init(&q->cond, NULL))) {
+        ff_mutex_destroy(&q->mutex);
+        av_fifo_freep2(&q->jobs);
+        av_free(q);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_create(&q->thread, NULL, ioqueue_thread, q))) {
+        ff_cond_destroy(&q->cond);
+        ff_mutex_destroy(&q->mutex);
+        av_fifo_freep2(&q->jobs);
+        av_free(q);
+        return AVERROR(ret);
+    }
+
+    *pq = q;
+    return 0;
+}
+
+void ff_ioqueue_free(FFIOQueue **pq)
+{
+    FFIOQueue *q = *pq;
+
+    if (!q)
+        return;
+
+    ff_mutex_lock(&q->mutex);
+    q->finish = 1;
+    ff_cond_broadcast(&q->cond);
+    ff_mutex_unlock(&q->mutex);
+    pthread_join(q->thread, NULL);
+
+    for (int i = 0; i < q->nb_pending; i++) {
+        ffio_free_dyn_buf(q->pending[i].pb);
+        av_freep(&q->pending[i].filename);
+        av_dict_free(&q->pending[i].options);
+    }
+    av_freep(&q->pending);
+
+    ff_cond_destroy(&q->cond);
+    ff_mutex_destroy(&q->mutex);
+    av_fifo_freep2(&q->jobs);
+    av_freep(pq);
+}
+
+/* Takes ownership of the contents of job. */
+static int ioqueue_submit(FFIOQueue *q, FFIOQueueJob *job)
+{
+    int64_t start = 0;
+    int ret;
+
+    ff_mutex_lock(&q->mutex);
+    while (!q->error && (!av_fifo_can_write(q->jobs) ||
+                         (q->size && q->size + job->size > q->max_size))) {
+        if (!start) {
+            start = av_gettime_relative();
+            q->stats.stalls++;
+        }
+        ff_cond_wait(&q->cond, &q->mutex);
+    }
+    if (start)
+        q->stats.stall_time += av_gettime_relative() - start;
+
+    ret = q->error;
+    if (!ret) {
+        av_fifo_write(q->jobs, job, 1);
+        q->size += job->size;
+        q->stats.peak_size = FFMAX(q->stats.peak_size, q->size);
+        ff_cond_broadcast(&q->cond);
+    }
+    ff_mutex_unlock(&q->mutex);
+
+    if (ret < 0)
+        free_job(job);
+    return ret;
+}
+
+int ff_ioqueue_open(FFIOQueue *q, AVIOContext **pb, const char *filename,
+                    AVDictionary **options)
+{
+    PendingFile *pending;
+    int ret;
+
+    pending = av_realloc_array(q->pending, q->nb_pending + 1, sizeof(*q->pending));
+    if (!pending)
+        return AVERROR(ENOMEM);
+    q->pending = pending;
+    pending   += q->nb_pending;
+    memset(pending, 0, sizeof(*pending));
+
+    pending->filename = av_strdup(filename);
+    if (!pending->filename)
+        return AVERROR(ENOMEM);
+    if (options && (ret = av_dict_copy(&pending->options, *options, 0)) < 0)
+        goto fail;
+    if ((ret = avio_open_dyn_buf(pb)) < 0)
+        goto fail;
+
+    pending->pb = pb;
+    q->nb_pending++;
+    return 0;
+
+fail:
+    av_freep(&pending->filename);
+    av_dict_free(&pending->options);
+    return ret;
+}
+
+int ff_ioqueue_close(FFIOQueue *q, AVIOContext **pb)
+{
+    FFIOQueueJob job = { FF_IOQUEUE_WRITE };
+    int i, ret;
+
+    if (!*pb)
+        return 0;
+
+    for (i = 0; i < q->nb_pending; i++)
+        if (*q->pending[i].pb == *pb)
+            break;
+    if (i == q->nb_pending)
+        return AVERROR_BUG;
+
+    job.filename = q->pending[i].filename;
+    job.options  = q->pending[i].options;
+    ret = avio_close_dyn_buf(*pb, &job.data);
+    *pb = NULL;
+    q->pending[i] = q->pending[--q->nb_pending];
+
+    if (ret < 0) {
+        free_job(&job);
+        return ret;
+    }
+    job.size = ret;
+
+    return ioqueue_submit(q, &job);
+}
+
+int ff_ioqueue_rename(FFIOQueue *q, const char *oldpath, const char *newpath)
+{
+    FFIOQueueJob job = { FF_IOQUEUE_RENAME };
+
+    job.filename     = av_strdup(oldpath);
+    job.new_filename = av_strdup(newpath);
+    if (!job.filename || !job.new_filename) {
+        free_job(&job);
+        return AVERROR(ENOMEM);
+    }
+
+    return ioqueue_submit(q, &job);
+}
+
+int ff_ioqueue_delete(FFIOQueue *q, const char *filename)
+{
+    FFIOQueueJob job = { FF_IOQUEUE_DELETE };
+
+    job.filename = av_strdup(filename);
+    if (!job.filename)
+        return AVERROR(ENOMEM);
+
+    return ioqueue_submit(q, &job);
+}
+
+int ff_ioqueue_flush(FFIOQueue *q)
+{
+    int ret;
+
+    ff_mutex_lock(&q->mutex);
+    while (av_fifo_can_read(q->jobs) || q->busy)
+        ff_cond_wait(&q->cond, &q->mutex);
+    ret = q->error;
+    ff_mutex_unlock(&q->mutex);
+
+    return ret;
+}
+
+void ff_ioqueue_get_stats(FFIOQueue *q, FFIOQueueStats *stats)
+{
+    ff_mutex_lock(&q->mutex);
+    *stats = q->stats;
+    ff_mutex_unlock(&q->mutex);
+}
+
+#else
+
+int ff_ioqueue_alloc(FFIOQueue **pq, AVFormatContext *s, FFIOQueueRunFn run,
+                     int max_jobs, int64_t max_size)
+{
+    return AVERROR(ENOSYS);
+}
+
+void ff_ioqueue_free(FFIOQueue **pq)
+{
+}
+
+int ff_ioqueue_open(FFIOQueue *q, AVIOContext **pb, const char *filename,
+                    AVDictionary **options)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_ioqueue_close(FFIOQueue *q, AVIOContext **pb)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_ioqueue_rename(FFIOQueue *q, const char *oldpath, const char *newpath)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_ioqueue_delete(FFIOQueue *q, const char *filename)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_ioqueue_flush(FFIOQueue *q)
+{
+    return AVERROR(ENOSYS);
+}
+
+void ff_ioqueue_get_stats(FFIOQueue *q, FFIOQueueStats *stats)
+{
+}
+
+#endif /* HAVE_THREADS */
@@ -0,0 +1,118 @@
+/*
+ * Background output queue for segmenting muxers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_IOQUEUE_H
+#define AVFORMAT_IOQUEUE_H
+
+#include <stdint.h>
+
+#include "libavutil/dict.h"
+
+#include "avformat.h"
+#include "avio.h"
+
+/**
+ * Queue of file operations that a background thread performs one at a time,
+ * in submission order. Muxers use it to keep uploads, playlist rewrites and
+ * deletions of segments from blocking the muxing thread.
+ *
+ * Files are produced in memory: ff_ioqueue_open() returns a dynamic buffer
+ * and ff_ioqueue_close() queues writing its contents. When the queue is full,
+ * submitting blocks until the thread has caught up.
+ *
+ * The first error returned by an operation is kept; the remaining queued
+ * operations are dropped and all further calls return it.
+ */
+typedef struct FFIOQueue FFIOQueue;
+
+enum FFIOQueueOp {
+    FF_IOQUEUE_WRITE,   ///< write data to filename
+    FF_IOQUEUE_RENAME,  ///< rename filename to new_filename
+    FF_IOQUEUE_DELETE,  ///< delete filename
+};
+
+typedef struct FFIOQueueJob {
+    enum FFIOQueueOp op;
+    char *filename;
+    char *new_filename;
+    AVDictionary *options;  ///< options given to ff_ioqueue_open()
+    uint8_t *data;
+    int size;
+} FFIOQueueJob;
+
+typedef struct FFIOQueueStats {
+    int64_t stalls;      ///< number of submissions that waited for the queue
+    int64_t stall_time;  ///< total time spent waiting, in microseconds
+    int64_t peak_size;   ///< largest amount of queued data, in bytes
+} FFIOQueueStats;
+
+/**
+ * Perform a queued operation, called on the queue thread.
+ *
+ * @return 0 on success, a negative error code that stops the queue otherwise
+ */
+typedef int (*FFIOQueueRunFn)(AVFormatContext *s, FFIOQueueJob *job);
+
+/**
+ * Allocate a queue and start its thread.
+ *
+ * @param max_jobs maximum number of queued operations
+ * @param max_size maximum amount of queued data in bytes, a single
+ *                 operation larger than this is queued alone
+ * @return 0 on success, AVERROR(ENOSYS) if threads are not available,
+ *         another negative error code on failure
+ */
+int ff_ioqueue_alloc(FFIOQueue **pq, AVFormatContext *s, FFIOQueueRunFn run,
+                     int max_jobs, int64_t max_size);
+
+/**
+ * Perform all queued operations, then stop the thread and free the queue.
+ * Files that are still open are discarded and their AVIOContext pointers
+ * set to NULL.
+ */
+void ff_ioqueue_free(FFIOQueue **pq);
+
+/**
+ * Open an in-memory file to be written to filename by ff_ioqueue_close().
+ * pb must stay valid until the file is closed or the queue is freed.
+ */
+int ff_ioqueue_open(FFIOQueue *q, AVIOContext **pb, const char *filename,
+                    AVDictionary **options);
+
+/**
+ * Close a file opened with ff_ioqueue_open() and queue writing it.
+ * *pb is set to NULL in any case.
+ */
+int ff_ioqueue_close(FFIOQueue *q, AVIOContext **pb);
+
+int ff_ioqueue_rename(FFIOQueue *q, const char *oldpath, const char *newpath);
+
+int ff_ioqueue_delete(FFIOQueue *q, const char *filename);
+
+/**
+ * Wait until all queued operations have been performed.
+ *
+ * @return the error of a failed operation, 0 if there was none
+ */
+int ff_ioqueue_flush(FFIOQueue *q);
+
+void ff_ioqueue_get_stats(FFIOQueue *q, FFIOQueueStats *stats);
+
+#endif /* AVFORMAT_IOQUEUE_H */
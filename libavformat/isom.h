@@ -227,6 +227,8 @@ typedef struct MOVStreamContext {
     uint8_t tmcd_nb_frames;  ///< tmcd number of frames per tick / second
     int64_t track_end;    ///< used for dts generation in fragmented movie files
     int start_pad;        ///< amount of samples to skip due to enc-dec delay
+    int index_pending;    ///< index construction deferred by lazy_index
+    int index_start_pad;  ///< start_pad when the index construction was deferred
     unsigned int rap_group_count;
     MOVSbgp *rap_group;
     unsigned int sync_group_count;
@@ -367,6 +369,10 @@ typedef struct MOVContext {
     int thmb_item_id;
     int64_t idat_offset;
     int interleaved_read;
+    int lazy_index;
+    int index_threads;
+    int nb_pending_indexes;
+    int compact_index;
 } MOVContext;
 
 int ff_mp4_read_descr_len(AVIOContext *pb);
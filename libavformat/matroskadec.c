@@ -439,6 +439,13 @@ typedef struct MatroskaDemuxContext {
 
     /* Bandwidth value for WebM DASH Manifest */
     int bandwidth;
+
+    /* Clusters up to this size are read into memory at once */
+    int cluster_prefetch_size;
+    /* The rest of the current cluster when it has been prefetched,
+     * and the context its elements are parsed from */
+    AVBufferRef *cluster_buf;
+    FFIOContext cluster_pb;
 } MatroskaDemuxContext;
 
 #define CHILD_OF(parent) { .def = { .n = parent } }
@@ -847,6 +854,8 @@ static int matroska_reset_status(MatroskaDemuxContext *matroska,
                                  uint32_t id, int64_t position)
 {
     int64_t err = 0;
+
+    av_buffer_unref(&matroska->cluster_buf);
     if (position >= 0) {
         err = avio_seek(matroska->ctx->pb, position, SEEK_SET);
         if (err > 0)
@@ -869,6 +878,8 @@ static int matroska_resync(MatroskaDemuxContext *matroska, int64_t last_pos)
     AVIOContext *pb = matroska->ctx->pb;
     uint32_t id;
 
+    av_buffer_unref(&matroska->cluster_buf);
+
     /* Try to seek to the last position to resync from. If this doesn't work,
      * we resync from the earliest position available: The start of the buffer. */
     if (last_pos < avio_tell(pb) && avio_seek(pb, last_pos + 1, SEEK_SET) < 0) {
@@ -1107,6 +1118,30 @@ static int ebml_read_binary(AVIOContext *pb, int length,
     return 0;
 }
 
+/*
+ * Reference binary data inside a prefetched cluster instead of copying it.
+ * 0 is success, < 0 or NEEDS_CHECKING is failure.
+ */
+static int ebml_ref_binary(AVIOContext *pb, AVBufferRef *cluster_buf,
+                           int length, int64_t pos, EbmlBin *bin)
+{
+    int ret;
+
+    if (pb->buf_end - pb->buf_ptr < length)
+        return ebml_read_binary(pb, length, pos, bin);
+
+    ret = av_buffer_replace(&bin->buf, cluster_buf);
+    if (ret < 0)
+        return ret;
+
+    bin->data = pb->buf_ptr;
+    bin->size = length;
+    bin->pos  = pos;
+    avio_skip(pb, length);
+
+    return 0;
+}
+
 /*
  * Read the next element, but only the header. The contents
  * are supposed to be sub-elements which can be read separately.
@@ -1272,7 +1307,8 @@ static int ebml_parse(MatroskaDemuxContext *matroska,
         [EBML_BIN]   = 0x10000000,
         // no limits for anything else
     };
-    AVIOContext *pb = matroska->ctx->pb;
+    AVIOContext *pb = matroska->cluster_buf ? &matroska->cluster_pb.pub
+                                            : matroska->ctx->pb;
     uint32_t id;
     uint64_t length;
     int64_t pos = avio_tell(pb), pos_alt;
@@ -1486,7 +1522,10 @@ static int ebml_parse(MatroskaDemuxContext *matroska,
         res = ebml_read_ascii(pb, length, syntax->def.s, data);
         break;
     case EBML_BIN:
-        res = ebml_read_binary(pb, length, pos_alt, data);
+        if (matroska->cluster_buf)
+            res = ebml_ref_binary(pb, matroska->cluster_buf, length, pos_alt, data);
+        else
+            res = ebml_read_binary(pb, length, pos_alt, data);
         break;
     case EBML_LEVEL1:
     case EBML_NEST:
@@ -4239,6 +4278,42 @@ static int matroska_parse_block(MatroskaDemuxContext *matroska, AVBufferRef *buf
     return 0;
 }
 
+/*
+ * Read the rest of the cluster just entered with a single read, so that its
+ * blocks are parsed from memory and their packets reference the buffer.
+ */
+static int matroska_prefetch_cluster(MatroskaDemuxContext *matroska)
+{
+    AVIOContext *pb = matroska->ctx->pb;
+    const MatroskaLevel *level = &matroska->levels[1];
+    int64_t pos = avio_tell(pb), size;
+    AVBufferRef *buf;
+    int ret;
+
+    if (level->length == EBML_UNKNOWN_LENGTH)
+        return 0;
+    size = level->start + level->length - pos;
+    if (size <= 0 || size > matroska->cluster_prefetch_size)
+        return 0;
+
+    buf = av_buffer_alloc(size + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!buf)
+        return AVERROR(ENOMEM);
+    ret = avio_read(pb, buf->data, size);
+    if (ret < 0) {
+        av_buffer_unref(&buf);
+        return ret;
+    }
+    memset(buf->data + ret, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+    ffio_init_read_context(&matroska->cluster_pb, buf->data, ret);
+    matroska->cluster_pb.pub.pos     += pos;
+    matroska->cluster_pb.pub.seekable = pb->seekable;
+    matroska->cluster_buf = buf;
+
+    return 0;
+}
+
 static int matroska_parse_cluster(MatroskaDemuxContext *matroska)
 {
     MatroskaCluster *cluster = &matroska->current_cluster;
@@ -4257,6 +4332,9 @@ static int matroska_parse_cluster(MatroskaDemuxContext *matroska)
             res = ebml_parse(matroska, matroska_cluster_enter, cluster);
             if (res < 0)
                 return res;
+            if (matroska->cluster_prefetch_size && matroska->num_levels == 2 &&
+                (res = matroska_prefetch_cluster(matroska)) < 0)
+                return res;
         }
     }
 
@@ -4277,6 +4355,9 @@ static int matroska_parse_cluster(MatroskaDemuxContext *matroska)
 
         ebml_free(matroska_blockgroup, block);
         memset(block, 0, sizeof(*block));
+
+        if (matroska->num_levels < 2)
+            av_buffer_unref(&matroska->cluster_buf);
     } else if (!matroska->num_levels) {
         if (!avio_feof(matroska->ctx->pb)) {
             avio_r8(matroska->ctx->pb);
@@ -4388,6 +4469,7 @@ static int matroska_read_close(AVFormatContext *s)
     int n;
 
     matroska_clear_queue(matroska);
+    av_buffer_unref(&matroska->cluster_buf);
 
     for (n = 0; n < matroska->tracks.nb_elem; n++)
         if (tracks[n].type == MATROSKA_TRACK_TYPE_AUDIO)
@@ -4397,6 +4479,19 @@ static int matroska_read_close(AVFormatContext *s)
     return 0;
 }
 
+#define OFFSET(x) offsetof(MatroskaDemuxContext, x)
+static const AVOption matroska_options[] = {
+    { "cluster_prefetch_size", "read clusters up to this size into memory at once", OFFSET(cluster_prefetch_size), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX - AV_INPUT_BUFFER_PADDING_SIZE, AV_OPT_FLAG_DECODING_PARAM },
+    { NULL },
+};
+
+static const AVClass matroska_class = {
+    .class_name = "matroska,webm demuxer",
+    .item_name  = av_default_item_name,
+    .option     = matroska_options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
 #if CONFIG_WEBM_DASH_MANIFEST_DEMUXER
 typedef struct {
     int64_t start_time_ns;
@@ -4815,7 +4910,6 @@ static int webm_dash_manifest_read_packet(AVFormatContext *s, AVPacket *pkt)
     return AVERROR_EOF;
 }
 
-#define OFFSET(x) offsetof(MatroskaDemuxContext, x)
 static const AVOption options[] = {
     { "live", "flag indicating that the input is a live file that only has the headers.", OFFSET(is_live), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { "bandwidth", "bandwidth of this stream to be specified in the DASH manifest.", OFFSET(bandwidth), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_DECODING_PARAM },
@@ -4846,6 +4940,7 @@ const FFInputFormat ff_matroska_demuxer = {
     .p.long_name    = NULL_IF_CONFIG_SMALL("Matroska / WebM"),
     .p.extensions   = "mkv,mk3d,mka,mks,webm",
     .p.mime_type    = "audio/webm,audio/x-matroska,video/webm,video/x-matroska",
+    .p.priv_class   = &matroska_class,
     .priv_data_size = sizeof(MatroskaDemuxContext),
     .flags_internal = FF_INFMT_FLAG_INIT_CLEANUP,
     .read_probe     = matroska_probe,
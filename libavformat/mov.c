@@ -47,6 +47,7 @@
 #include "libavutil/aes_ctr.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/sha.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/spherical.h"
 #include "libavutil/stereo3d.h"
 #include "libavutil/timecode.h"
@@ -5064,6 +5065,147 @@ static int mov_update_iamf_streams(MOVContext *c, const AVStream *st)
 }
 #endif
 
+static void mov_free_sample_tables(MOVStreamContext *sc)
+{
+    av_freep(&sc->chunk_offsets);
+    av_freep(&sc->sample_sizes);
+    av_freep(&sc->keyframes);
+    av_freep(&sc->stts_data);
+    av_freep(&sc->stps_data);
+    av_freep(&sc->elst_data);
+    av_freep(&sc->rap_group);
+    av_freep(&sc->sync_group);
+    av_freep(&sc->sgpd_sync);
+}
+
+#define MOV_MAX_INDEX_THREADS 64
+
+/**
+ * The index of most tracks is only needed once packets are read from them or
+ * they are seeked, so lazy_index defers its construction until then.
+ */
+static int mov_can_defer_index(MOVContext *c, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    return c->lazy_index && sc->sample_count && !sc->iamf &&
+           st->codecpar->codec_tag != MKTAG('t','m','c','d') &&
+           st->codecpar->codec_tag != MKTAG('r','t','m','d');
+}
+
+/**
+ * Build the index of a track deferred by lazy_index. Only the state of st is
+ * touched, so distinct tracks can be handled concurrently.
+ */
+static void mov_build_deferred_index(MOVContext *mov, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int start_pad = sc->start_pad;
+
+    mov_build_index(mov, st);
+
+    /* Priming set by metadata read after the track takes precedence, like
+     * when the index is built while reading the header. */
+    if (start_pad != sc->index_start_pad)
+        sc->start_pad = start_pad;
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+        st->codecpar->codec_id   == AV_CODEC_ID_AAC)
+        ffstream(st)->skip_samples = sc->start_pad;
+
+    mov_free_sample_tables(sc);
+    sc->index_pending = 0;
+
+    if (mov->compact_index && !mov->frag_index.nb_items)
+        ff_index_compact(st);
+}
+
+static void mov_ensure_index(MOVContext *mov, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    if (sc->index_pending) {
+        mov_build_deferred_index(mov, st);
+        mov->nb_pending_indexes--;
+    }
+}
+
+typedef struct MOVIndexJobs {
+    MOVContext *mov;
+    AVStream **streams;
+} MOVIndexJobs;
+
+static void mov_index_worker(void *priv, int jobnr, int threadnr,
+                             int nb_jobs, int nb_threads)
+{
+    MOVIndexJobs *jobs = priv;
+
+    mov_build_deferred_index(jobs->mov, jobs->streams[jobnr]);
+}
+
+/**
+ * Build the deferred indexes of all tracks that are not discarded, and of
+ * st if not NULL, using up to index_threads threads.
+ */
+static int mov_build_pending_indexes(AVFormatContext *s, AVStream *st)
+{
+    MOVContext *mov = s->priv_data;
+    AVStream **streams;
+    int nb_streams = 0, nb_built = 0, ret;
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        MOVStreamContext *sc = s->streams[i]->priv_data;
+        if (sc->index_pending && (s->streams[i]->discard < AVDISCARD_ALL ||
+                                  s->streams[i] == st))
+            nb_streams++;
+    }
+    if (!nb_streams)
+        return 0;
+
+    streams = av_malloc_array(nb_streams, sizeof(*streams));
+    if (!streams)
+        return AVERROR(ENOMEM);
+    nb_streams = 0;
+    for (int i = 0; i < s->nb_streams; i++) {
+        MOVStreamContext *sc = s->streams[i]->priv_data;
+        if (sc->index_pending && (s->streams[i]->discard < AVDISCARD_ALL ||
+                                  s->streams[i] == st))
+            streams[nb_streams++] = s->streams[i];
+    }
+
+    if (mov->index_threads > 1 && nb_streams > 1) {
+        MOVIndexJobs jobs = { mov, streams };
+        AVSliceThread *slicethread;
+
+        ret = avpriv_slicethread_create(&slicethread, &jobs, mov_index_worker, NULL,
+                                        FFMIN(mov->index_threads, nb_streams));
+        if (ret >= 0) {
+            avpriv_slicethread_execute(slicethread, nb_streams, 0);
+            avpriv_slicethread_free(&slicethread);
+            nb_built = nb_streams;
+        } else if (ret != AVERROR(ENOSYS)) {
+            av_free(streams);
+            return ret;
+        }
+    }
+    for (int i = nb_built; i < nb_streams; i++)
+        mov_build_deferred_index(mov, streams[i]);
+
+    mov->nb_pending_indexes -= nb_streams;
+    av_free(streams);
+
+    /* done by mov_read_header() for the indexes built there */
+    ff_configure_buffers_for_index(s, AV_TIME_BASE);
+    if (mov->compact_index && !mov->frag_index.nb_items) {
+        for (int i = 0; i < s->nb_streams; i++) {
+            if (ffstream(s->streams[i])->nb_index_entries &&
+                (ret = ff_index_compact(s->streams[i])) < 0)
+                return ret;
+        }
+    }
+
+    return 0;
+}
+
 static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
 {
     AVStream *st;
@@ -5123,11 +5265,19 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
 
         av_log(c->fc, AV_LOG_VERBOSE, "advanced_editlist does not work with fragmented "
                                       "MP4. disabling.\n");
+        /* deferred indexes of the previous tracks use the old setting */
+        for (int i = 0; i < st->index; i++)
+            mov_ensure_index(c, c->fc->streams[i]);
         c->advanced_editlist = 0;
         c->advanced_editlist_autodisabled = 1;
     }
 
-    mov_build_index(c, st);
+    if (mov_can_defer_index(c, st)) {
+        sc->index_pending   = 1;
+        sc->index_start_pad = sc->start_pad;
+        c->nb_pending_indexes++;
+    } else
+        mov_build_index(c, st);
 
 #if CONFIG_IAMFDEC
     if (sc->iamf) {
@@ -5210,15 +5360,8 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
             ffstream(st)->need_parsing = AVSTREAM_PARSE_FULL;
     }
     /* Do not need those anymore. */
-    av_freep(&sc->chunk_offsets);
-    av_freep(&sc->sample_sizes);
-    av_freep(&sc->keyframes);
-    av_freep(&sc->stts_data);
-    av_freep(&sc->stps_data);
-    av_freep(&sc->elst_data);
-    av_freep(&sc->rap_group);
-    av_freep(&sc->sync_group);
-    av_freep(&sc->sgpd_sync);
+    if (!sc->index_pending)
+        mov_free_sample_tables(sc);
 
     return 0;
 }
@@ -5691,7 +5834,7 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     int64_t dts, pts = AV_NOPTS_VALUE;
     int data_offset = 0;
     unsigned entries, first_sample_flags = frag->flags;
-    int flags, distance, i;
+    int flags, distance, i, ret;
     int64_t prev_dts = AV_NOPTS_VALUE;
     int next_frag_index = -1, index_entry_pos;
     size_t requested_size;
@@ -5717,6 +5860,9 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
         return 0;
     }
     sc = st->priv_data;
+    mov_ensure_index(c, st);
+    if ((ret = ff_index_expand(st)) < 0)
+        return ret;
     if (sc->pseudo_stream_id+1 != frag->stsd_id && sc->pseudo_stream_id != -1)
         return 0;
 
@@ -9509,13 +9655,14 @@ static void mov_read_chapters(AVFormatContext *s)
         sti = ffstream(st);
 
         sc = st->priv_data;
+        mov_ensure_index(mov, st);
         cur_pos = avio_tell(sc->pb);
 
         if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
             st->disposition |= AV_DISPOSITION_ATTACHED_PIC | AV_DISPOSITION_TIMED_THUMBNAILS;
             if (!st->attached_pic.data && sti->nb_index_entries) {
                 // Retrieve the first frame, if possible
-                AVIndexEntry *sample = &sti->index_entries[0];
+                AVIndexEntry *sample = ff_index_get_entry(st, 0);
                 if (avio_seek(sc->pb, sample->pos, SEEK_SET) != sample->pos) {
                     av_log(s, AV_LOG_ERROR, "Failed to retrieve first frame\n");
                     goto finish;
@@ -9529,8 +9676,8 @@ static void mov_read_chapters(AVFormatContext *s)
             st->codecpar->codec_id = AV_CODEC_ID_BIN_DATA;
             st->discard = AVDISCARD_ALL;
             for (int i = 0; i < sti->nb_index_entries; i++) {
-                AVIndexEntry *sample = &sti->index_entries[i];
-                int64_t end = i+1 < sti->nb_index_entries ? sti->index_entries[i+1].timestamp : st->duration;
+                AVIndexEntry *sample = ff_index_get_entry(st, i);
+                int64_t end = i+1 < sti->nb_index_entries ? ff_index_get_entry(st, i+1)->timestamp : st->duration;
                 uint8_t *title;
                 uint16_t ch;
                 int len, title_len;
@@ -10561,6 +10708,14 @@ static int mov_read_header(AVFormatContext *s)
     }
     ff_configure_buffers_for_index(s, AV_TIME_BASE);
 
+    if (mov->compact_index && !mov->frag_index.nb_items) {
+        for (i = 0; i < s->nb_streams; i++) {
+            if (ffstream(s->streams[i])->nb_index_entries &&
+                (err = ff_index_compact(s->streams[i])) < 0)
+                return err;
+        }
+    }
+
     for (i = 0; i < mov->frag_index.nb_items; i++)
         if (mov->frag_index.item[i].moof_offset <= mov->fragment.moof_offset)
             mov->frag_index.item[i].headers_read = 1;
@@ -10580,7 +10735,7 @@ static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
         FFStream *const avsti = ffstream(avst);
         MOVStreamContext *msc = avst->priv_data;
         if (msc->pb && msc->current_sample < avsti->nb_index_entries) {
-            AVIndexEntry *current_sample = &avsti->index_entries[msc->current_sample];
+            AVIndexEntry *current_sample = ff_index_get_entry(avst, msc->current_sample);
             int64_t dts = av_rescale(current_sample->timestamp, AV_TIME_BASE, msc->time_scale);
             uint64_t dtsdiff = best_dts > dts ? best_dts - (uint64_t)dts : ((uint64_t)dts - best_dts);
             av_log(s, AV_LOG_TRACE, "stream %d, sample %d, dts %"PRId64"\n", i, msc->current_sample, dts);
@@ -10707,7 +10862,7 @@ static int mov_finalize_packet(AVFormatContext *s, AVStream *st, AVIndexEntry *s
         }
     } else {
         int64_t next_dts = (sc->current_sample < ffstream(st)->nb_index_entries) ?
-            ffstream(st)->index_entries[sc->current_sample].timestamp : st->duration;
+            ff_index_get_entry(st, sc->current_sample)->timestamp : st->duration;
 
         if (next_dts >= pkt->dts)
             pkt->duration = next_dts - pkt->dts;
@@ -10753,6 +10908,9 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
     int64_t current_index;
     int ret;
     mov->fc = s;
+    if (mov->nb_pending_indexes &&
+        (ret = mov_build_pending_indexes(s, NULL)) < 0)
+        return ret;
  retry:
     sample = mov_find_next_sample(s, &st);
     if (!sample || (mov->next_root_atom && sample->pos > mov->next_root_atom)) {
@@ -10910,7 +11068,6 @@ static int is_open_key_sample(const MOVStreamContext *sc, int sample)
 static int can_seek_to_key_sample(AVStream *st, int sample, int64_t requested_pts)
 {
     MOVStreamContext *sc = st->priv_data;
-    FFStream *const sti = ffstream(st);
     int64_t key_sample_dts, key_sample_pts;
 
     if (st->codecpar->codec_id != AV_CODEC_ID_HEVC)
@@ -10919,7 +11076,7 @@ static int can_seek_to_key_sample(AVStream *st, int sample, int64_t requested_pt
     if (sample >= sc->sample_offsets_count)
         return 1;
 
-    key_sample_dts = sti->index_entries[sample].timestamp;
+    key_sample_dts = ff_index_get_entry(st, sample)->timestamp;
     key_sample_pts = key_sample_dts + sc->sample_offsets[sample] + sc->dts_shift;
 
     /*
@@ -10951,7 +11108,7 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
     for (;;) {
         sample = av_index_search_timestamp(st, timestamp, flags);
         av_log(s, AV_LOG_TRACE, "stream %d, timestamp %"PRId64", sample %d\n", st->index, timestamp, sample);
-        if (sample < 0 && sti->nb_index_entries && timestamp < sti->index_entries[0].timestamp)
+        if (sample < 0 && sti->nb_index_entries && timestamp < ff_index_get_entry(st, 0)->timestamp)
             sample = 0;
         if (sample < 0) /* not sure what to do */
             return AVERROR_INVALIDDATA;
@@ -11008,9 +11165,8 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
 static int64_t mov_get_skip_samples(AVStream *st, int sample)
 {
     MOVStreamContext *sc = st->priv_data;
-    FFStream *const sti = ffstream(st);
-    int64_t first_ts = sti->index_entries[0].timestamp;
-    int64_t ts = sti->index_entries[sample].timestamp;
+    int64_t first_ts = ff_index_get_entry(st, 0)->timestamp;
+    int64_t ts = ff_index_get_entry(st, sample)->timestamp;
     int64_t off;
 
     if (st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
@@ -11040,6 +11196,9 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
         return AVERROR_INVALIDDATA;
 
     st = s->streams[stream_index];
+    if (mc->nb_pending_indexes &&
+        (sample = mov_build_pending_indexes(s, st)) < 0)
+        return sample;
     sti = ffstream(st);
     sample = mov_seek_stream(s, st, sample_time, flags);
     if (sample < 0)
@@ -11047,7 +11206,7 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
 
     if (mc->seek_individually) {
         /* adjust seek timestamp to found sample timestamp */
-        int64_t seek_timestamp = sti->index_entries[sample].timestamp;
+        int64_t seek_timestamp = ff_index_get_entry(st, sample)->timestamp;
         sti->skip_samples = mov_get_skip_samples(st, sample);
 
         for (i = 0; i < s->nb_streams; i++) {
@@ -11135,6 +11294,12 @@ static const AVOption mov_options[] = {
         {.i64 = 0}, 0, 1, FLAGS },
     { "max_stts_delta", "treat offsets above this value as invalid", OFFSET(max_stts_delta), AV_OPT_TYPE_INT, {.i64 = UINT_MAX-48000*10 }, 0, UINT_MAX, .flags = AV_OPT_FLAG_DECODING_PARAM },
     { "interleaved_read", "Interleave packets from multiple tracks at demuxer level", OFFSET(interleaved_read), AV_OPT_TYPE_BOOL, {.i64 = 1 }, 0, 1, .flags = AV_OPT_FLAG_DECODING_PARAM },
+    { "lazy_index", "Build the index of a track when it is first read or seeked", OFFSET(lazy_index), AV_OPT_TYPE_BOOL,
+        {.i64 = 0}, 0, 1, FLAGS },
+    { "index_threads", "Number of threads building deferred indexes", OFFSET(index_threads), AV_OPT_TYPE_INT,
+        {.i64 = 1}, 1, MOV_MAX_INDEX_THREADS, FLAGS },
+    { "compact_index", "Keep the index in a compact form using less memory", OFFSET(compact_index), AV_OPT_TYPE_BOOL,
+        {.i64 = 0}, 0, 1, FLAGS },
 
     { NULL },
 };
@@ -79,6 +79,7 @@ static const AVOption options[] = {
     { "encryption_key", "The media encryption key (hex)", offsetof(MOVMuxContext, encryption_key), AV_OPT_TYPE_BINARY, .flags = AV_OPT_FLAG_ENCODING_PARAM },
     { "encryption_kid", "The media encryption key identifier (hex)", offsetof(MOVMuxContext, encryption_kid), AV_OPT_TYPE_BINARY, .flags = AV_OPT_FLAG_ENCODING_PARAM },
     { "encryption_scheme",    "Configures the encryption scheme, allowed values are none, cenc-aes-ctr", offsetof(MOVMuxContext, encryption_scheme_str),   AV_OPT_TYPE_STRING, {.str = NULL}, .flags = AV_OPT_FLAG_ENCODING_PARAM },
+    { "frag_direct_samples", "Write fragments directly to the output, reserving space for the moof of this many samples", offsetof(MOVMuxContext, frag_direct_samples), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 1 << 20, AV_OPT_FLAG_ENCODING_PARAM},
     { "frag_duration", "Maximum fragment duration", offsetof(MOVMuxContext, max_fragment_duration), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM},
     { "frag_interleave", "Interleave samples within fragments (max number of consecutive samples, lower is tighter interleaving, but with more overhead)", offsetof(MOVMuxContext, frag_interleave), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
     { "frag_size", "Maximum fragment size", offsetof(MOVMuxContext, max_fragment_size), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM},
@@ -6256,6 +6257,97 @@ static int mov_finish_fragment(MOVMuxContext *mov, MOVTrack *track,
     return 0;
 }
 
+/*
+ * Fragments can be written directly to a seekable output instead of being
+ * buffered in memory until they are complete. Space for the moof is
+ * reserved in front of the mdat, sized for the worst case of
+ * frag_direct_samples samples that all start a separate trun. When the
+ * fragment is flushed, the moof is written at the end of the reserved
+ * space and the rest of it is covered by a free box.
+ */
+static int mov_frag_direct_reserve(const MOVMuxContext *mov)
+{
+    /* moof + mfhd, traf + tfhd + tfdt per track, trun header and entry per sample */
+    return 8 + 16 + mov->nb_tracks * (8 + 40 + 20) +
+           (mov->frag_direct_samples + mov->nb_tracks) * (24 + 16) + 8;
+}
+
+/**
+ * Start writing the current fragment directly to the output if possible.
+ *
+ * @return 1 if the fragment data goes to s->pb, 0 if it has to be buffered
+ */
+static int mov_frag_direct_open(AVFormatContext *s)
+{
+    MOVMuxContext *mov = s->priv_data;
+
+    if (!mov->frag_direct_samples || !mov->moov_written)
+        return 0;
+    if (mov->frag_direct_pos)
+        return 1;
+    /* Finish a fragment that was started before the moov was written
+     * in memory. */
+    if (mov->mdat_buf)
+        return 0;
+    for (int i = 0; i < mov->nb_tracks; i++)
+        if (mov->tracks[i].mdat_buf)
+            return 0;
+
+    mov->frag_direct_pos     = avio_tell(s->pb);
+    mov->frag_direct_reserve = mov_frag_direct_reserve(mov);
+    /* reserved moof space and mdat header */
+    ffio_fill(s->pb, 0, mov->frag_direct_reserve + 8);
+    return 1;
+}
+
+static int mov_flush_fragment_direct(AVFormatContext *s)
+{
+    MOVMuxContext *mov = s->priv_data;
+    int64_t end = avio_tell(s->pb);
+    int64_t mdat_start = mov->frag_direct_pos + mov->frag_direct_reserve + 8;
+    int64_t mdat_size = end - mdat_start;
+    AVIOContext *avio_buf;
+    int ret, moof_size;
+
+    for (int i = 0; i < mov->nb_tracks; i++) {
+        MOVTrack *track = &mov->tracks[i];
+        track->data_offset = 0;
+        for (int j = 0; j < track->entry; j++)
+            track->cluster[j].pos -= mdat_start;
+    }
+
+    if ((ret = ffio_open_null_buf(&avio_buf)) < 0)
+        return ret;
+    mov_write_moof_tag_internal(avio_buf, mov, -1, 0);
+    moof_size = ffio_close_null_buf(avio_buf);
+    if (moof_size + 8 > mov->frag_direct_reserve) {
+        av_log(s, AV_LOG_ERROR, "moof of %d bytes does not fit into the "
+               "reserved %d bytes\n", moof_size, mov->frag_direct_reserve);
+        return AVERROR_BUG;
+    }
+
+    avio_seek(s->pb, mov->frag_direct_pos, SEEK_SET);
+    avio_wb32(s->pb, mov->frag_direct_reserve - moof_size);
+    ffio_wfourcc(s->pb, "free");
+    avio_seek(s->pb, mov->frag_direct_pos + mov->frag_direct_reserve - moof_size,
+              SEEK_SET);
+
+    if ((ret = mov_write_moof_tag(s->pb, mov, -1, mdat_size)) < 0)
+        return ret;
+    mov->fragments++;
+    avio_wb32(s->pb, mdat_size + 8);
+    ffio_wfourcc(s->pb, "mdat");
+    avio_seek(s->pb, end, SEEK_SET);
+
+    for (int i = 0; i < mov->nb_tracks; i++)
+        mov_finish_fragment(mov, &mov->tracks[i], mdat_start);
+    mov->frag_direct_pos = 0;
+    mov->mdat_size       = 0;
+
+    avio_write_marker(s->pb, AV_NOPTS_VALUE, AVIO_DATA_MARKER_FLUSH_POINT);
+    return 0;
+}
+
 static int mov_flush_fragment(AVFormatContext *s, int force)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -6371,6 +6463,9 @@ static int mov_flush_fragment(AVFormatContext *s, int force)
         return 0;
     }
 
+    if (mov->frag_direct_pos)
+        return mov_flush_fragment_direct(s);
+
     if (mov->frag_interleave) {
         for (i = 0; i < mov->nb_tracks; i++) {
             MOVTrack *track = &mov->tracks[i];
@@ -6548,11 +6643,17 @@ int ff_mov_write_packet(AVFormatContext *s, AVPacket *pkt)
                 }
             }
 
-            if (!trk->mdat_buf) {
-                if ((ret = avio_open_dyn_buf(&trk->mdat_buf)) < 0)
-                    return ret;
+            if ((ret = mov_frag_direct_open(s)) < 0)
+                return ret;
+            if (ret) {
+                pb = s->pb;
+            } else {
+                if (!trk->mdat_buf) {
+                    if ((ret = avio_open_dyn_buf(&trk->mdat_buf)) < 0)
+                        return ret;
+                }
+                pb = trk->mdat_buf;
             }
-            pb = trk->mdat_buf;
         } else {
             if (!mov->mdat_buf) {
                 if ((ret = avio_open_dyn_buf(&mov->mdat_buf)) < 0)
@@ -6890,6 +6991,7 @@ static int mov_write_single_packet(AVFormatContext *s, AVPacket *pkt)
     AVCodecParameters *par = trk->par;
     int64_t frag_duration = 0;
     int size = pkt->size;
+    int frag_full = 0;
 
     int ret = check_pkt(s, trk, pkt);
     if (ret < 0)
@@ -6942,14 +7044,21 @@ static int mov_write_single_packet(AVFormatContext *s, AVPacket *pkt)
         frag_duration = av_rescale_q(pkt->dts - trk->cluster[0].dts,
                 s->streams[pkt->stream_index]->time_base,
                 AV_TIME_BASE_Q);
-    if ((mov->max_fragment_duration &&
+    if (mov->frag_direct_pos) {
+        int entries = 0;
+        for (int i = 0; i < mov->nb_tracks; i++)
+            entries += mov->tracks[i].entry;
+        frag_full = entries >= mov->frag_direct_samples;
+    }
+    if (frag_full ||
+        (mov->max_fragment_duration &&
                 frag_duration >= mov->max_fragment_duration) ||
             (mov->max_fragment_size && mov->mdat_size + size >= mov->max_fragment_size) ||
             (mov->flags & FF_MOV_FLAG_FRAG_KEYFRAME &&
              par->codec_type == AVMEDIA_TYPE_VIDEO &&
              trk->entry && pkt->flags & AV_PKT_FLAG_KEY) ||
             (mov->flags & FF_MOV_FLAG_FRAG_EVERY_FRAME)) {
-        if (frag_duration >= mov->min_fragment_duration) {
+        if (frag_full || frag_duration >= mov->min_fragment_duration) {
             if (trk->entry) {
                 // Set the duration of this track to line up with the next
                 // sample in this track. This avoids relying on AVPacket
@@ -7703,6 +7812,25 @@ static int mov_init(AVFormatContext *s)
         return AVERROR(EINVAL);
     }
 
+    if (mov->frag_direct_samples) {
+        if (!(mov->flags & FF_MOV_FLAG_FRAGMENT) ||
+            !(s->pb->seekable & AVIO_SEEKABLE_NORMAL)) {
+            av_log(s, AV_LOG_WARNING, "frag_direct_samples requires fragmented, "
+                   "seekable output, buffering fragments in memory\n");
+            mov->frag_direct_samples = 0;
+        } else if (mov->frag_interleave || mov->mode == MODE_ISM ||
+                   mov->write_prft > MOV_PRFT_NONE ||
+                   mov->flags & (FF_MOV_FLAG_OMIT_TFHD_OFFSET | FF_MOV_FLAG_SEPARATE_MOOF |
+                                 FF_MOV_FLAG_GLOBAL_SIDX) ||
+                   (mov->flags & FF_MOV_FLAG_DASH && !(mov->flags & FF_MOV_FLAG_SKIP_SIDX))) {
+            av_log(s, AV_LOG_ERROR,
+                   "Writing fragments directly is mutually exclusive with "
+                   "frag_interleave, separate_moof, omit_tfhd_offset, sidx, "
+                   "prft and ISM output\n");
+            return AVERROR(EINVAL);
+        }
+    }
+
     /* Non-seekable output is ok if using fragmentation. If ism_lookahead
      * is enabled, we don't support non-seekable output at all. */
     if (!(s->pb->seekable & AVIO_SEEKABLE_NORMAL) &&
@@ -236,6 +236,10 @@ typedef struct MOVMuxContext {
     int frag_interleave;
     int missing_duration_warned;
 
+    int frag_direct_samples;
+    int64_t frag_direct_pos;     ///< start of the fragment written directly to the output, 0 if none
+    int frag_direct_reserve;     ///< space reserved for the moof of that fragment
+
     char *encryption_scheme_str;
     MOVEncryptionScheme encryption_scheme;
     uint8_t *encryption_key;
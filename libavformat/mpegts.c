@@ -31,6 +31,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/avassert.h"
 #include "libavutil/dovi_meta.h"
+#include "libavcodec/avcodec.h"
 #include "libavcodec/bytestream.h"
 #include "libavcodec/defs.h"
 #include "libavcodec/get_bits.h"
@@ -164,6 +165,7 @@ struct MpegTSContext {
     int resync_size;
     int merge_pmt_versions;
     int max_packet_size;
+    int complete_pes_frames;
 
     int id;
 
@@ -210,6 +212,8 @@ static const AVOption options[] = {
      {.i64 = 0}, 0, 1, 0 },
     {"max_packet_size", "maximum size of emitted packet", offsetof(MpegTSContext, max_packet_size), AV_OPT_TYPE_INT,
      {.i64 = 204800}, 1, INT_MAX/2, AV_OPT_FLAG_DECODING_PARAM },
+    {"complete_pes_frames", "pass aligned video PES packets on as complete frames", offsetof(MpegTSContext, complete_pes_frames), AV_OPT_TYPE_BOOL,
+     {.i64 = 0}, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { NULL },
 };
 
@@ -272,6 +276,8 @@ typedef struct PESContext {
     AVBufferRef *buffer;
     SLConfigDescr sl;
     int merged_st;
+    /** 1 if PES packets are passed on as complete frames, -1 if they cannot be */
+    int complete_frames;
 } PESContext;
 
 extern const FFInputFormat ff_mpegts_demuxer;
@@ -1138,6 +1144,36 @@ static AVBufferRef *buffer_pool_get(MpegTSContext *ts, int size)
     return av_buffer_pool_get(ts->pools[index]);
 }
 
+/**
+ * With the complete_pes_frames option, video PES packets that start with
+ * the data alignment indicator set and are followed by another such packet
+ * are assumed to hold whole frames. The parser then only extracts headers
+ * instead of reassembling the frames, which would copy all of the data.
+ * Once a packet does not qualify, the stream returns to full parsing.
+ */
+static void update_complete_frames(PESContext *pes, int aligned)
+{
+    FFStream *const sti = ffstream(pes->st);
+
+    if (pes->complete_frames < 0)
+        return;
+    if (!aligned) {
+        if (pes->complete_frames > 0) {
+            av_log(pes->stream, AV_LOG_VERBOSE, "pid=%x PES packets are not "
+                   "frame aligned, reassembling frames\n", pes->pid);
+            sti->need_parsing = AVSTREAM_PARSE_FULL;
+            if (sti->parser)
+                sti->parser->flags &= ~PARSER_FLAG_COMPLETE_FRAMES;
+        }
+        pes->complete_frames = -1;
+    } else if (!pes->complete_frames && !sti->parser &&
+               sti->need_parsing == AVSTREAM_PARSE_FULL &&
+               pes->st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+        sti->need_parsing    = AVSTREAM_PARSE_HEADERS;
+        pes->complete_frames = 1;
+    }
+}
+
 /* return non zero if a packet could be constructed */
 static int mpegts_push_data(MpegTSFilter *filter,
                             const uint8_t *buf, int buf_size, int is_start,
@@ -1153,6 +1189,9 @@ static int mpegts_push_data(MpegTSFilter *filter,
 
     if (is_start) {
         if (pes->state == MPEGTS_PAYLOAD && pes->data_index > 0) {
+            if (pes->complete_frames > 0)
+                update_complete_frames(pes, buf_size > 6 && AV_RB24(buf) == 1 &&
+                                            (buf[6] & 0x04));
             ret = new_pes_packet(pes, ts->pkt);
             if (ret < 0)
                 return ret;
@@ -1267,6 +1306,9 @@ skip:
                 const uint8_t *r;
                 unsigned int flags, pes_ext, skip;
 
+                if (ts->complete_pes_frames)
+                    update_complete_frames(pes, pes->header[6] & 0x04);
+
                 flags = pes->header[7];
                 r = pes->header + 9;
                 pes->pts = AV_NOPTS_VALUE;
@@ -1386,6 +1428,8 @@ skip:
 
                 if (pes->data_index > 0 &&
                     pes->data_index + buf_size > max_packet_size) {
+                    if (pes->complete_frames > 0)
+                        update_complete_frames(pes, 0);
                     ret = new_pes_packet(pes, ts->pkt);
                     if (ret < 0)
                         return ret;
@@ -1410,7 +1454,7 @@ skip:
                 /* emit complete packets with known packet size
                  * decreases demuxer delay for infrequent packets like subtitles from
                  * a couple of seconds to milliseconds for properly muxed files. */
-                if (!ts->stop_parse && pes->PES_packet_length &&
+                if (!ts->stop_parse && pes->PES_packet_length && pes->complete_frames <= 0 &&
                     pes->pes_header_size + pes->data_index == pes->PES_packet_length + PES_START_SIZE) {
                     ts->stop_parse = 1;
                     ret = new_pes_packet(pes, ts->pkt);
@@ -2975,6 +3019,44 @@ static void finished_reading_packet(AVFormatContext *s, int raw_packet_size)
         avio_skip(pb, skip);
 }
 
+/**
+ * Consume the packets at the start of the I/O buffer that handle_packet()
+ * would ignore, i.e. those of pids without a filter or of discarded pids,
+ * without going through read_packet() and handle_packet() for each of them.
+ * Stops at the first packet that needs handling, at a missing sync byte or
+ * when fewer than max_packets packets may be consumed.
+ *
+ * @return number of packets consumed
+ */
+static int skip_ignored_packets(MpegTSContext *ts, int64_t max_packets)
+{
+    AVIOContext *pb = ts->stream->pb;
+    const int raw_packet_size = ts->raw_packet_size;
+    const uint8_t *p = pb->buf_ptr;
+    int nb_packets, i;
+
+    if (pb->write_flag)
+        return 0;
+    nb_packets = (pb->buf_end - p) / raw_packet_size;
+    if (max_packets > 0)
+        nb_packets = FFMIN(nb_packets, max_packets);
+
+    for (i = 0; i < nb_packets; i++, p += raw_packet_size) {
+        const MpegTSFilter *tss;
+        int is_start;
+
+        if (p[0] != 0x47)
+            break;
+        is_start = p[1] & 0x40;
+        tss = ts->pids[AV_RB16(p + 1) & 0x1fff];
+        if (tss ? !tss->discard || is_start : ts->auto_guess && is_start)
+            break;
+    }
+    pb->buf_ptr += i * raw_packet_size;
+
+    return i;
+}
+
 static int handle_packets(MpegTSContext *ts, int64_t nb_packets)
 {
     AVFormatContext *s = ts->stream;
@@ -3016,6 +3098,12 @@ static int handle_packets(MpegTSContext *ts, int64_t nb_packets)
         if (ts->stop_parse > 0)
             break;
 
+        packet_num += skip_ignored_packets(ts, nb_packets ? nb_packets - packet_num : 0);
+        if (nb_packets != 0 && packet_num >= nb_packets) {
+            ret = AVERROR(EAGAIN);
+            break;
+        }
+
         ret = read_packet(s, packet, ts->raw_packet_size, &data);
         if (ret != 0)
             break;
@@ -1444,6 +1444,66 @@ static uint8_t *get_ts_payload_start(uint8_t *pkt)
         return pkt + 4;
 }
 
+/* number of TS packets gathered for a single write by mpegts_write_pes_payload() */
+#define PES_PAYLOAD_BATCH 32
+
+/*
+ * In VBR mode the PCR used for scheduling does not advance within a PES
+ * packet, so once its first TS packet is written no PCR or SI table can
+ * become due before its end, unless a retransmission period is zero.
+ */
+static int pes_payload_only(const MpegTSWrite *ts)
+{
+    return ts->mux_rate <= 1 && ts->pat_period > 0 && ts->sdt_period > 0 &&
+           (ts->nit_period > 0 || !(ts->flags & MPEGTS_FLAG_NIT));
+}
+
+/*
+ * Write the TS packets following the start of a PES packet that are
+ * completely filled with payload, without stuffing and adaptation field.
+ * They are built in batches and passed to the AVIOContext in one go.
+ * The last TS packet is left to the caller.
+ *
+ * @return the number of payload bytes written
+ */
+static int mpegts_write_pes_payload(AVFormatContext *s, AVStream *st,
+                                    const uint8_t *payload, int payload_size)
+{
+    MpegTSWrite *ts = s->priv_data;
+    MpegTSWriteStream *ts_st = st->priv_data;
+    uint8_t batch[PES_PAYLOAD_BATCH * (TS_PACKET_SIZE + 4)];
+    int pid_hi = ts_st->pid >> 8;
+    int written = 0;
+
+    if (ts->m2ts_mode && st->codecpar->codec_id == AV_CODEC_ID_AC3)
+        pid_hi |= 0x20;
+
+    while (payload_size - written > TS_PACKET_SIZE - 4) {
+        int nb_packets = FFMIN((payload_size - written - 1) / (TS_PACKET_SIZE - 4),
+                               PES_PAYLOAD_BATCH);
+        uint8_t *q = batch;
+
+        for (int i = 0; i < nb_packets; i++) {
+            if (ts->m2ts_mode) {
+                AV_WB32(q, get_pcr(ts) % 0x3fffffff);
+                q += 4;
+            }
+            ts_st->cc = ts_st->cc + 1 & 0xf;
+            q[0] = 0x47;
+            q[1] = pid_hi;
+            q[2] = ts_st->pid;
+            q[3] = 0x10 | ts_st->cc;
+            memcpy(q + 4, payload + written, TS_PACKET_SIZE - 4);
+            q               += TS_PACKET_SIZE;
+            written         += TS_PACKET_SIZE - 4;
+            ts->total_size  += TS_PACKET_SIZE;
+        }
+        avio_write(s->pb, batch, q - batch);
+    }
+
+    return written;
+}
+
 static int get_pes_stream_id(AVFormatContext *s, AVStream *st, int stream_id, int *async)
 {
     MpegTSWrite *ts = s->priv_data;
@@ -1495,6 +1555,7 @@ static void mpegts_write_pes(AVFormatContext *s, AVStream *st,
     int force_pat = st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && key && !ts_st->prev_payload_key;
     int force_sdt = 0;
     int force_nit = 0;
+    int payload_only = pes_payload_only(ts);
 
     av_assert0(ts_st->payload != buf || st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO);
     if (ts->flags & MPEGTS_FLAG_PAT_PMT_AT_FRAMES && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
@@ -1511,6 +1572,13 @@ static void mpegts_write_pes(AVFormatContext *s, AVStream *st,
     is_start = 1;
     while (payload_size > 0) {
         int64_t pcr = AV_NOPTS_VALUE;
+
+        if (!is_start && payload_only) {
+            len = mpegts_write_pes_payload(s, st, payload, payload_size);
+            payload      += len;
+            payload_size -= len;
+        }
+
         if (ts->mux_rate > 1)
             pcr = get_pcr(ts);
         else if (dts != AV_NOPTS_VALUE)
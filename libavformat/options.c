@@ -168,6 +168,11 @@ static int io_close2_default(AVFormatContext *s, AVIOContext *pb)
     return avio_close(pb);
 }
 
+int ff_format_io_open_is_default(const AVFormatContext *s)
+{
+    return s->io_open == io_open_default;
+}
+
 AVFormatContext *avformat_alloc_context(void)
 {
     FormatContextInternal *fci; // 内部格式上下文
@@ -0,0 +1,491 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/error.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+#include "avio_internal.h"
+#include "internal.h"
+#include "prefetch.h"
+#include "url.h"
+
+#if HAVE_THREADS
+
+enum PrefetchState {
+    PREFETCH_FREE,
+    PREFETCH_QUEUED,
+    PREFETCH_RUNNING,
+    PREFETCH_DONE,
+};
+
+/*
+ * A segment downloaded ahead of the demuxer. The segment is described by
+ * copies of its playlist entry since the playlist may be reloaded meanwhile.
+ * Slots of adjacent byte ranges of the same url may share one download.
+ */
+typedef struct PrefetchSlot {
+    enum PrefetchState state;
+    int cancel;
+    int64_t seq_no;
+    char *url;
+    int64_t url_offset;
+    int64_t size;
+    AVDictionary *opts;
+    AVBufferRef *buf;
+    char *cookies; ///< cookies set by the server
+    int ret;
+} PrefetchSlot;
+
+/* The slots and bytes are protected by mutex. */
+struct FFPrefetchContext {
+    AVFormatContext *s;
+    FFPrefetchCheckURLFunc check_url;
+    FFPrefetchSegmentFunc get_segment;
+    void *opaque;
+    int64_t max_size;
+    int64_t coalesce_size;
+
+    PrefetchSlot *slots; ///< slot seq_no % nb_slots holds segment seq_no
+    int nb_slots;
+    pthread_t *threads;
+    int nb_threads;
+    AVMutex mutex;
+    AVCond cond;
+    int abort;
+    int64_t bytes; ///< size of the downloaded, not yet consumed segments
+};
+
+static void reset_slot(FFPrefetchContext *p, PrefetchSlot *slot)
+{
+    if (slot->buf)
+        p->bytes -= slot->buf->size;
+    av_buffer_unref(&slot->buf);
+    av_freep(&slot->url);
+    av_dict_free(&slot->opts);
+    av_freep(&slot->cookies);
+    slot->state  = PREFETCH_FREE;
+    slot->cancel = 0;
+}
+
+static int cancelled(FFPrefetchContext *p, PrefetchSlot *slot)
+{
+    int cancel;
+
+    ff_mutex_lock(&p->mutex);
+    cancel = slot->cancel || p->abort;
+    ff_mutex_unlock(&p->mutex);
+    return cancel;
+}
+
+/*
+ * Download the byte range [url_offset, url_offset + size) of the url of
+ * slot, or the rest of the url if size is negative. Called without the lock
+ * held.
+ */
+static int download(FFPrefetchContext *p, PrefetchSlot *slot, int64_t size,
+                    AVBufferRef **pbuf)
+{
+    AVFormatContext *s = p->s;
+    AVIOContext *in = NULL;
+    AVDictionary *opts = NULL;
+    uint8_t *data = NULL;
+    unsigned int data_size = 0;
+    int64_t len = 0;
+    int is_http = 0, ret;
+
+    if ((ret = p->check_url(s, slot->url, &is_http)) < 0)
+        return ret;
+
+    av_dict_copy(&opts, slot->opts, 0);
+    if (size >= 0) {
+        /* try to restrict the HTTP request to the part we want */
+        av_dict_set_int(&opts, "offset", slot->url_offset, 0);
+        av_dict_set_int(&opts, "end_offset", slot->url_offset + size, 0);
+    }
+
+    ret = ffio_open_whitelist(&in, slot->url, AVIO_FLAG_READ, &s->interrupt_callback,
+                              &opts, s->protocol_whitelist, s->protocol_blacklist);
+    av_dict_free(&opts);
+    if (ret < 0)
+        return ret;
+
+    /* handed back to the demuxer along with the data */
+    av_opt_get(in, "cookies", AV_OPT_SEARCH_CHILDREN, (uint8_t **)&slot->cookies);
+
+    if (!is_http && slot->url_offset) {
+        int64_t seekret = avio_seek(in, slot->url_offset, SEEK_SET);
+        if (seekret < 0) {
+            ret = seekret;
+            goto fail;
+        }
+    }
+
+    if (size < 0)
+        size = avio_size(in);
+
+    while (size < 0 || len < size) {
+        int chunk = size < 0 ? 65536 : FFMIN(size - len, 65536);
+        uint8_t *tmp;
+
+        if (len + chunk > INT_MAX - AV_INPUT_BUFFER_PADDING_SIZE) {
+            ret = AVERROR(ERANGE);
+            goto fail;
+        }
+        tmp = av_fast_realloc(data, &data_size, len + chunk + AV_INPUT_BUFFER_PADDING_SIZE);
+        if (!tmp) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        data = tmp;
+
+        ret = avio_read(in, data + len, chunk);
+        if (ret == AVERROR_EOF)
+            break;
+        if (ret < 0)
+            goto fail;
+        len += ret;
+
+        if (cancelled(p, slot)) {
+            ret = AVERROR_EXIT;
+            goto fail;
+        }
+    }
+    avio_closep(&in);
+
+    *pbuf = av_buffer_create(data, len, av_buffer_default_free, NULL, 0);
+    if (!*pbuf) {
+        av_free(data);
+        return AVERROR(ENOMEM);
+    }
+    return 0;
+
+fail:
+    avio_closep(&in);
+    av_free(data);
+    return ret;
+}
+
+static void *prefetch_thread(void *arg)
+{
+    FFPrefetchContext *p = arg;
+    PrefetchSlot **group;
+
+    group = av_malloc_array(p->nb_slots, sizeof(*group));
+    if (!group)
+        return NULL;
+
+    ff_mutex_lock(&p->mutex);
+    while (!p->abort) {
+        PrefetchSlot *slot = NULL;
+        AVBufferRef *buf = NULL;
+        int64_t size;
+        int nb_group = 1, ret;
+
+        /* download the earliest queued segment first */
+        for (int i = 0; i < p->nb_slots; i++) {
+            PrefetchSlot *cand = &p->slots[i];
+            if (cand->state == PREFETCH_QUEUED && (!slot || cand->seq_no < slot->seq_no))
+                slot = cand;
+        }
+        if (!slot) {
+            ff_cond_wait(&p->cond, &p->mutex);
+            continue;
+        }
+
+        /* coalesce the queued byte ranges that directly follow it */
+        group[0] = slot;
+        size = slot->size;
+        while (size >= 0 && nb_group < p->nb_slots) {
+            PrefetchSlot *next = &p->slots[(slot->seq_no + nb_group) % p->nb_slots];
+            if (next->state != PREFETCH_QUEUED || next->seq_no != slot->seq_no + nb_group ||
+                next->size < 0 || strcmp(next->url, slot->url) ||
+                next->url_offset != slot->url_offset + size ||
+                size + next->size > p->coalesce_size)
+                break;
+            size += next->size;
+            group[nb_group++] = next;
+        }
+        for (int i = 0; i < nb_group; i++)
+            group[i]->state = PREFETCH_RUNNING;
+        ff_mutex_unlock(&p->mutex);
+
+        if (nb_group > 1)
+            av_log(p->s, AV_LOG_DEBUG, "Coalescing %d segments from offset %"PRId64" of '%s'\n",
+                   nb_group, slot->url_offset, slot->url);
+        ret = download(p, slot, size, &buf);
+
+        ff_mutex_lock(&p->mutex);
+        for (int i = 0, offset = 0; i < nb_group; i++) {
+            PrefetchSlot *cur = group[i];
+
+            if (cur->cancel) {
+                offset += cur->size;
+                reset_slot(p, cur);
+                continue;
+            }
+            cur->ret = ret;
+            if (buf && nb_group == 1) {
+                cur->buf = av_buffer_ref(buf);
+            } else if (buf && offset + cur->size <= buf->size) {
+                /* the segments share the downloaded buffer */
+                cur->buf = av_buffer_ref(buf);
+                if (cur->buf) {
+                    cur->buf->data += offset;
+                    cur->buf->size  = cur->size;
+                }
+            } else if (ret >= 0) {
+                cur->ret = AVERROR_INVALIDDATA;
+            }
+            if (cur->buf)
+                p->bytes += cur->buf->size;
+            cur->state = PREFETCH_DONE;
+            offset += cur->size;
+        }
+        av_buffer_unref(&buf);
+        ff_cond_broadcast(&p->cond);
+    }
+    ff_mutex_unlock(&p->mutex);
+
+    av_free(group);
+    return NULL;
+}
+
+void ff_prefetch_free(FFPrefetchContext **pp)
+{
+    FFPrefetchContext *p = *pp;
+
+    if (!p)
+        return;
+
+    ff_mutex_lock(&p->mutex);
+    p->abort = 1;
+    ff_cond_broadcast(&p->cond);
+    ff_mutex_unlock(&p->mutex);
+
+    for (int i = 0; i < p->nb_threads; i++)
+        pthread_join(p->threads[i], NULL);
+    av_freep(&p->threads);
+
+    for (int i = 0; i < p->nb_slots; i++)
+        reset_slot(p, &p->slots[i]);
+    av_freep(&p->slots);
+
+    ff_cond_destroy(&p->cond);
+    ff_mutex_destroy(&p->mutex);
+    av_freep(pp);
+}
+
+int ff_prefetch_init(FFPrefetchContext **pp, AVFormatContext *s, int nb_slots,
+                     int64_t max_size, int64_t coalesce_size,
+                     FFPrefetchCheckURLFunc check_url,
+                     FFPrefetchSegmentFunc get_segment, void *opaque)
+{
+    FFPrefetchContext *p;
+    int ret;
+
+    p = av_mallocz(sizeof(*p));
+    if (!p)
+        goto nomem;
+    p->slots   = av_calloc(nb_slots, sizeof(*p->slots));
+    p->threads = av_calloc(nb_slots, sizeof(*p->threads));
+    if (!p->slots || !p->threads) {
+        av_freep(&p->slots);
+        av_freep(&p->threads);
+        av_freep(&p);
+        goto nomem;
+    }
+    if ((ret = ff_mutex_init(&p->mutex, NULL))) {
+        av_freep(&p->slots);
+        av_freep(&p->threads);
+        av_freep(&p);
+        goto fail;
+    }
+    if ((ret = ff_cond_init(&p->cond, NULL))) {
+        ff_mutex_destroy(&p->mutex);
+        av_freep(&p->slots);
+        av_freep(&p->threads);
+        av_freep(&p);
+        goto fail;
+    }
+    p->s             = s;
+    p->check_url     = check_url;
+    p->get_segment   = get_segment;
+    p->opaque        = opaque;
+    p->max_size      = max_size;
+    p->coalesce_size = coalesce_size;
+    p->nb_slots      = nb_slots;
+    *pp = p;
+
+    for (int i = 0; i < nb_slots; i++) {
+        ret = pthread_create(&p->threads[i], NULL, prefetch_thread, p);
+        if (ret) {
+            ff_prefetch_free(pp);
+            goto fail;
+        }
+        p->nb_threads++;
+    }
+
+    return 0;
+nomem:
+    ret = ENOMEM;
+fail:
+    av_log(s, AV_LOG_WARNING, "Failed to start prefetching: %s\n",
+           av_err2str(AVERROR(ret)));
+    return AVERROR(ret);
+}
+
+void ff_prefetch_schedule(FFPrefetchContext *p, int64_t cur_seq_no, int batch,
+                          const AVDictionary *opts)
+{
+    PrefetchSlot *cur = &p->slots[cur_seq_no % p->nb_slots];
+    int missing = 0;
+
+    ff_mutex_lock(&p->mutex);
+    for (int64_t seq_no = cur_seq_no; seq_no < cur_seq_no + p->nb_slots; seq_no++) {
+        PrefetchSlot *slot = &p->slots[seq_no % p->nb_slots];
+        if (slot->state == PREFETCH_FREE || slot->seq_no != seq_no)
+            missing++;
+    }
+    if (missing < batch && cur->state != PREFETCH_FREE && cur->seq_no == cur_seq_no) {
+        ff_mutex_unlock(&p->mutex);
+        return;
+    }
+
+    for (int64_t seq_no = cur_seq_no; seq_no < cur_seq_no + p->nb_slots; seq_no++) {
+        PrefetchSlot *slot = &p->slots[seq_no % p->nb_slots];
+        int ret;
+
+        if (slot->state != PREFETCH_FREE && slot->seq_no == seq_no) {
+            /* wanted again after a seek back into the window */
+            slot->cancel = 0;
+            continue;
+        }
+        /* the slot holds a segment outside of the window, e.g. after a seek */
+        if (slot->state == PREFETCH_RUNNING) {
+            slot->cancel = 1;
+            continue;
+        }
+        reset_slot(p, slot);
+
+        if (p->bytes >= p->max_size)
+            break;
+
+        ret = p->get_segment(p->opaque, seq_no, &slot->url,
+                             &slot->url_offset, &slot->size);
+        if (ret < 0) {
+            reset_slot(p, slot);
+            break;
+        }
+        if (ret > 0) {
+            reset_slot(p, slot);
+            continue;
+        }
+        if (av_dict_copy(&slot->opts, opts, 0) < 0) {
+            reset_slot(p, slot);
+            break;
+        }
+        slot->seq_no = seq_no;
+        slot->state  = PREFETCH_QUEUED;
+    }
+    ff_cond_broadcast(&p->cond);
+    ff_mutex_unlock(&p->mutex);
+}
+
+int ff_prefetch_get(FFPrefetchContext *p, int64_t seq_no, AVBufferRef **buf,
+                    AVDictionary **opts, int *stalled)
+{
+    PrefetchSlot *slot = &p->slots[seq_no % p->nb_slots];
+    int ret = 0;
+
+    *stalled = 0;
+
+    ff_mutex_lock(&p->mutex);
+    while (slot->state != PREFETCH_DONE) {
+        int64_t t = av_gettime() + 100000;
+        struct timespec tv = { .tv_sec  =  t / 1000000,
+                               .tv_nsec = (t % 1000000) * 1000 };
+
+        /* not scheduled, or cancelled before it was wanted again */
+        if (slot->state == PREFETCH_FREE || slot->seq_no != seq_no) {
+            ff_mutex_unlock(&p->mutex);
+            return 0;
+        }
+        *stalled = 1;
+        ff_cond_timedwait(&p->cond, &p->mutex, &tv);
+        if (ff_check_interrupt(&p->s->interrupt_callback)) {
+            ff_mutex_unlock(&p->mutex);
+            return AVERROR_EXIT;
+        }
+    }
+    if (slot->seq_no != seq_no) {
+        ff_mutex_unlock(&p->mutex);
+        return 0;
+    }
+
+    if (slot->cookies) {
+        av_dict_set(opts, "cookies", slot->cookies, AV_DICT_DONT_STRDUP_VAL);
+        slot->cookies = NULL;
+    }
+    if (slot->buf) {
+        p->bytes -= slot->buf->size;
+        *buf      = slot->buf;
+        slot->buf = NULL;
+        ret = 1;
+    } else {
+        /* let the demuxer retry and report the error */
+        av_log(p->s, AV_LOG_DEBUG, "Prefetching segment %"PRId64" failed: %s\n",
+               seq_no, av_err2str(slot->ret));
+    }
+    reset_slot(p, slot);
+    ff_mutex_unlock(&p->mutex);
+
+    return ret;
+}
+
+#else
+
+int ff_prefetch_init(FFPrefetchContext **pp, AVFormatContext *s, int nb_slots,
+                     int64_t max_size, int64_t coalesce_size,
+                     FFPrefetchCheckURLFunc check_url,
+                     FFPrefetchSegmentFunc get_segment, void *opaque)
+{
+    av_log(s, AV_LOG_WARNING, "Prefetching requires threads\n");
+    return AVERROR(ENOSYS);
+}
+
+void ff_prefetch_free(FFPrefetchContext **pp)
+{
+}
+
+void ff_prefetch_schedule(FFPrefetchContext *p, int64_t cur_seq_no, int batch,
+                          const AVDictionary *opts)
+{
+}
+
+int ff_prefetch_get(FFPrefetchContext *p, int64_t seq_no, AVBufferRef **buf,
+                    AVDictionary **opts, int *stalled)
+{
+    *stalled = 0;
+    return 0;
+}
+
+#endif /* HAVE_THREADS */
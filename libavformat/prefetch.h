@@ -0,0 +1,114 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_PREFETCH_H
+#define AVFORMAT_PREFETCH_H
+
+#include <stdint.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/dict.h"
+#include "avformat.h"
+
+/**
+ * @file
+ * Download window of the segments of a playlist, shared by the HLS and DASH
+ * demuxers. Segment seq_no is downloaded by background threads into a slot
+ * of the window, which holds segments cur_seq_no to
+ * cur_seq_no + nb_slots - 1 and is refilled as the demuxer moves on.
+ */
+
+typedef struct FFPrefetchContext FFPrefetchContext;
+
+/**
+ * Describe segment seq_no to the prefetch window. Called from the demuxer
+ * thread.
+ *
+ * @param url        set to a string allocated with av_malloc(), owned by
+ *                   the prefetch window afterwards
+ * @param url_offset set to the start of the segment in url
+ * @param size       set to the size of the segment, or -1 if it is the
+ *                   remainder of url
+ * @return 0 on success, 1 if the segment must not be prefetched, e.g. as it
+ *         is encrypted, AVERROR_EOF after the last segment or another
+ *         negative error code
+ */
+typedef int (*FFPrefetchSegmentFunc)(void *opaque, int64_t seq_no, char **url,
+                                     int64_t *url_offset, int64_t *size);
+
+/**
+ * Check that url may be opened by the demuxer, called from the prefetch
+ * threads. is_http must be set to whether url is a HTTP url.
+ */
+typedef int (*FFPrefetchCheckURLFunc)(AVFormatContext *s, const char *url,
+                                      int *is_http);
+
+/**
+ * Start the prefetch threads.
+ *
+ * Segments are opened with the I/O options given to ff_prefetch_schedule(),
+ * the protocol whitelists and the interrupt callback of s, but not with
+ * s->io_open, which is not required to be thread-safe.
+ *
+ * @param nb_slots      number of segments of the window, also the number of
+ *                      threads
+ * @param max_size      do not queue segments while at least this many bytes
+ *                      of the window are downloaded
+ * @param coalesce_size fetch queued adjacent byte ranges of the same url
+ *                      with one request of up to this many bytes, 0 to
+ *                      disable
+ * @return 0 on success, a negative error code otherwise, which has been
+ *         logged
+ */
+int ff_prefetch_init(FFPrefetchContext **pp, AVFormatContext *s, int nb_slots,
+                     int64_t max_size, int64_t coalesce_size,
+                     FFPrefetchCheckURLFunc check_url,
+                     FFPrefetchSegmentFunc get_segment, void *opaque);
+
+/**
+ * Stop the prefetch threads and free the window.
+ */
+void ff_prefetch_free(FFPrefetchContext **pp);
+
+/**
+ * Queue the segments of the window starting at cur_seq_no that are not
+ * queued or downloaded yet, and cancel the downloads of segments outside of
+ * it.
+ *
+ * @param batch only queue segments once at least this many of the window
+ *              are missing, so that adjacent byte ranges can be coalesced
+ * @param opts  I/O options of the requests
+ */
+void ff_prefetch_schedule(FFPrefetchContext *p, int64_t cur_seq_no, int batch,
+                          const AVDictionary *opts);
+
+/**
+ * Take segment seq_no from the window, waiting for it if it is being
+ * downloaded.
+ *
+ * @param buf     set to the data of the segment on success
+ * @param opts    I/O options of the demuxer, updated with the cookies set by
+ *                the server
+ * @param stalled set to 1 if it was waited for the segment, 0 otherwise
+ * @return 1 if buf was set, 0 if the segment has to be opened directly, a
+ *         negative error code on interruption
+ */
+int ff_prefetch_get(FFPrefetchContext *p, int64_t seq_no, AVBufferRef **buf,
+                    AVDictionary **opts, int *stalled);
+
+#endif /* AVFORMAT_PREFETCH_H */
@@ -31,6 +31,7 @@
 #include "avformat.h"
 #include "avformat_internal.h"
 #include "avio_internal.h"
+#include "compactindex.h"
 #include "demux.h"
 #include "internal.h"
 
@@ -55,6 +56,8 @@ void ff_reduce_index(AVFormatContext *s, int stream_index)
 
     if ((unsigned) sti->nb_index_entries >= max_entries) {
         int i;
+        if (ff_index_expand(st) < 0)
+            return;
         for (i = 0; 2 * i < sti->nb_index_entries; i++)
             sti->index_entries[i] = sti->index_entries[2 * i];
         sti->nb_index_entries = i;
@@ -123,6 +126,9 @@ int av_add_index_entry(AVStream *st, int64_t pos, int64_t timestamp,
                        int size, int distance, int flags)
 {
     FFStream *const sti = ffstream(st);
+    int ret = ff_index_expand(st);
+    if (ret < 0)
+        return ret;
     timestamp = ff_wrap_timestamp(st, timestamp);
     return ff_add_index_entry(&sti->index_entries, &sti->nb_index_entries,
                               &sti->index_entries_allocated_size, pos,
@@ -203,14 +209,14 @@ void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance)
                 continue;
 
             for (int i1 = 0, i2 = 0; i1 < sti1->nb_index_entries; i1++) {
-                const AVIndexEntry *const e1 = &sti1->index_entries[i1];
+                const AVIndexEntry *const e1 = ff_index_get_entry(st1, i1);
                 int64_t e1_pts = av_rescale_q(e1->timestamp, st1->time_base, AV_TIME_BASE_Q);
 
                 if (e1->size < (1 << 23))
                     skip = FFMAX(skip, e1->size);
 
                 for (; i2 < sti2->nb_index_entries; i2++) {
-                    const AVIndexEntry *const e2 = &sti2->index_entries[i2];
+                    const AVIndexEntry *const e2 = ff_index_get_entry(st2, i2);
                     int64_t e2_pts = av_rescale_q(e2->timestamp, st2->time_base, AV_TIME_BASE_Q);
                     int64_t cur_delta;
                     if (e2_pts < e1_pts || e2_pts - (uint64_t)e1_pts < time_tolerance)
@@ -242,9 +248,50 @@ void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance)
     ctx->short_seek_threshold = FFMAX(ctx->short_seek_threshold, skip);
 }
 
+int ff_index_compact(AVStream *st)
+{
+    FFStream *const sti = ffstream(st);
+    int ret;
+
+    if (sti->compact_index)
+        return 0;
+    ret = ff_compact_index_create(&sti->compact_index, sti->index_entries,
+                                  sti->nb_index_entries);
+    if (ret < 0)
+        return ret;
+    av_freep(&sti->index_entries);
+    sti->index_entries_allocated_size = 0;
+    return 0;
+}
+
+int ff_index_expand(AVStream *st)
+{
+    FFStream *const sti = ffstream(st);
+    int ret;
+
+    if (!sti->compact_index)
+        return 0;
+    ret = ff_compact_index_expand(sti->compact_index, &sti->index_entries);
+    if (ret < 0)
+        return ret;
+    sti->index_entries_allocated_size = sti->nb_index_entries * sizeof(*sti->index_entries);
+    ff_compact_index_free(&sti->compact_index);
+    return 0;
+}
+
+AVIndexEntry *ff_index_get_entry(AVStream *st, int idx)
+{
+    FFStream *const sti = ffstream(st);
+    if (sti->compact_index)
+        return ff_compact_index_get(sti->compact_index, idx);
+    return &sti->index_entries[idx];
+}
+
 int av_index_search_timestamp(AVStream *st, int64_t wanted_timestamp, int flags)
 {
     const FFStream *const sti = ffstream(st);
+    if (sti->compact_index)
+        return ff_compact_index_search(sti->compact_index, wanted_timestamp, flags);
     return ff_index_search_timestamp(sti->index_entries, sti->nb_index_entries,
                                      wanted_timestamp, flags);
 }
@@ -260,22 +307,19 @@ const AVIndexEntry *avformat_index_get_entry(AVStream *st, int idx)
     if (idx < 0 || idx >= sti->nb_index_entries)
         return NULL;
 
-    return &sti->index_entries[idx];
+    return ff_index_get_entry(st, idx);
 }
 
 const AVIndexEntry *avformat_index_get_entry_from_timestamp(AVStream *st,
                                                             int64_t wanted_timestamp,
                                                             int flags)
 {
-    const FFStream *const sti = ffstream(st);
-    int idx = ff_index_search_timestamp(sti->index_entries,
-                                        sti->nb_index_entries,
-                                        wanted_timestamp, flags);
+    int idx = av_index_search_timestamp(st, wanted_timestamp, flags);
 
     if (idx < 0)
         return NULL;
 
-    return &sti->index_entries[idx];
+    return ff_index_get_entry(st, idx);
 }
 
 static int64_t read_timestamp(AVFormatContext *s, int stream_index, int64_t *ppos, int64_t pos_limit,
@@ -309,7 +353,7 @@ int ff_seek_frame_binary(AVFormatContext *s, int stream_index,
 
     st  = s->streams[stream_index];
     sti = ffstream(st);
-    if (sti->index_entries) {
+    if (sti->index_entries || sti->compact_index) {
         const AVIndexEntry *e;
 
         /* FIXME: Whole function must be checked for non-keyframe entries in
@@ -317,7 +361,7 @@ int ff_seek_frame_binary(AVFormatContext *s, int stream_index,
         index = av_index_search_timestamp(st, target_ts,
                                           flags | AVSEEK_FLAG_BACKWARD);
         index = FFMAX(index, 0);
-        e     = &sti->index_entries[index];
+        e     = ff_index_get_entry(st, index);
 
         if (e->timestamp <= target_ts || e->pos == e->min_distance) {
             pos_min = e->pos;
@@ -332,7 +376,7 @@ int ff_seek_frame_binary(AVFormatContext *s, int stream_index,
                                           flags & ~AVSEEK_FLAG_BACKWARD);
         av_assert0(index < sti->nb_index_entries);
         if (index >= 0) {
-            e = &sti->index_entries[index];
+            e = ff_index_get_entry(st, index);
             av_assert1(e->timestamp >= target_ts);
             pos_max   = e->pos;
             ts_max    = e->timestamp;
@@ -544,7 +588,7 @@ static int seek_frame_generic(AVFormatContext *s, int stream_index,
     index = av_index_search_timestamp(st, timestamp, flags);
 
     if (index < 0 && sti->nb_index_entries &&
-        timestamp < sti->index_entries[0].timestamp)
+        timestamp < ff_index_get_entry(st, 0)->timestamp)
         return -1;
 
     if (index < 0 || index == sti->nb_index_entries - 1) {
@@ -552,8 +596,8 @@ static int seek_frame_generic(AVFormatContext *s, int stream_index,
         int nonkey = 0;
 
         if (sti->nb_index_entries) {
-            av_assert0(sti->index_entries);
-            ie = &sti->index_entries[sti->nb_index_entries - 1];
+            av_assert0(sti->index_entries || sti->compact_index);
+            ie = ff_index_get_entry(st, sti->nb_index_entries - 1);
             if ((ret = avio_seek(s->pb, ie->pos, SEEK_SET)) < 0)
                 return ret;
             s->io_repositioned = 1;
@@ -593,7 +637,7 @@ static int seek_frame_generic(AVFormatContext *s, int stream_index,
     if (ffifmt(s->iformat)->read_seek)
         if (ffifmt(s->iformat)->read_seek(s, stream_index, timestamp, flags) >= 0)
             return 0;
-    ie = &sti->index_entries[index];
+    ie = ff_index_get_entry(st, index);
     if ((ret = avio_seek(s->pb, ie->pos, SEEK_SET)) < 0)
         return ret;
     s->io_repositioned = 1;
@@ -0,0 +1,196 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Checks that a compacted index returns the same entries and search results
+ * as the plain one. With a number of entries as argument, it prints the
+ * memory use and search speed of both instead.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+
+#include "libavformat/compactindex.h"
+#include "libavformat/demux.h"
+
+static const int search_flags[] = {
+    0, AVSEEK_FLAG_BACKWARD, AVSEEK_FLAG_ANY,
+    AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_ANY,
+};
+
+/* a regularly interleaved 60 fps track, optionally with leading discarded
+ * entries as produced by edit lists */
+static void fill_track(AVLFG *lfg, AVIndexEntry *e, int nb, int discard)
+{
+    int64_t pos = 48;
+
+    for (int i = 0; i < nb; i++) {
+        int key = !(i % 60);
+
+        e[i].pos          = pos;
+        e[i].timestamp    = i * 1001LL - 2002;
+        e[i].size         = key ? 60000 + av_lfg_get(lfg) % 20000 :
+                                  2000 + av_lfg_get(lfg) % 8000;
+        e[i].flags        = (key ? AVINDEX_KEYFRAME : 0) |
+                            (i < discard ? AVINDEX_DISCARD_FRAME : 0);
+        e[i].min_distance = i % 60;
+        pos += e[i].size + (i % 3 ? 0 : 4000);
+    }
+}
+
+static void fill_random(AVLFG *lfg, AVIndexEntry *e, int nb)
+{
+    for (int i = 0; i < nb; i++) {
+        e[i].pos          = (int64_t)((uint64_t)av_lfg_get(lfg) << 32 | av_lfg_get(lfg));
+        e[i].timestamp    = (int64_t)((uint64_t)av_lfg_get(lfg) << 32 | av_lfg_get(lfg));
+        e[i].size         = (int)av_lfg_get(lfg) >> 2;
+        e[i].flags        = av_lfg_get(lfg);
+        e[i].min_distance = av_lfg_get(lfg);
+    }
+}
+
+static int same_entry(const AVIndexEntry *a, const AVIndexEntry *b)
+{
+    return a->pos == b->pos && a->timestamp == b->timestamp &&
+           a->size == b->size && a->flags == b->flags &&
+           a->min_distance == b->min_distance;
+}
+
+static int check(AVLFG *lfg, const AVIndexEntry *entries, int nb, int search)
+{
+    FFCompactIndex *ci = NULL;
+    AVIndexEntry *expanded = NULL;
+    int ret = 1;
+
+    if (ff_compact_index_create(&ci, entries, nb) < 0)
+        return 1;
+    if (ff_compact_index_nb_entries(ci) != nb)
+        goto end;
+
+    for (int i = 0; i < nb; i++)
+        if (!same_entry(ff_compact_index_get(ci, i), &entries[i]))
+            goto end;
+    for (int i = 0; i < nb; i++) {
+        int idx = av_lfg_get(lfg) % nb;
+        if (!same_entry(ff_compact_index_get(ci, idx), &entries[idx]))
+            goto end;
+    }
+    if (ff_compact_index_get(ci, -1) || ff_compact_index_get(ci, nb))
+        goto end;
+
+    if (ff_compact_index_expand(ci, &expanded) < 0)
+        goto end;
+    for (int i = 0; i < nb; i++)
+        if (!same_entry(&expanded[i], &entries[i]))
+            goto end;
+
+    for (int i = 0; search && i < 4 * nb; i++) {
+        int64_t ts = nb ? (int64_t)(av_lfg_get(lfg) % (nb * 1001U + 4004)) - 4004 : 0;
+        int flags  = search_flags[i % FF_ARRAY_ELEMS(search_flags)];
+
+        if (ff_compact_index_search(ci, ts, flags) !=
+            ff_index_search_timestamp(entries, nb, ts, flags))
+            goto end;
+    }
+
+    ret = 0;
+end:
+    av_free(expanded);
+    ff_compact_index_free(&ci);
+    return ret;
+}
+
+static int bench(int nb)
+{
+    AVIndexEntry *entries = av_malloc_array(nb, sizeof(*entries));
+    FFCompactIndex *ci = NULL;
+    int64_t sum = 0, t;
+    AVLFG lfg;
+    int runs = 1000000;
+
+    if (!entries)
+        return 1;
+    av_lfg_init(&lfg, 1);
+    fill_track(&lfg, entries, nb, 0);
+    if (ff_compact_index_create(&ci, entries, nb) < 0) {
+        av_free(entries);
+        return 1;
+    }
+
+    printf("entries: %d\n", nb);
+    printf("memory:  %zu bytes plain, %zu bytes compact\n",
+           nb * sizeof(*entries), ff_compact_index_memory(ci));
+
+    t = av_gettime_relative();
+    for (int i = 0; i < runs; i++)
+        sum += ff_index_search_timestamp(entries, nb, (i * 7919LL) % (nb * 1001LL), 0);
+    printf("search:  %.1f ns plain, ", (av_gettime_relative() - t) * 1000.0 / runs);
+    t = av_gettime_relative();
+    for (int i = 0; i < runs; i++)
+        sum -= ff_compact_index_search(ci, (i * 7919LL) % (nb * 1001LL), 0);
+    printf("%.1f ns compact\n", (av_gettime_relative() - t) * 1000.0 / runs);
+
+    t = av_gettime_relative();
+    for (int i = 0; i < nb; i++)
+        sum += ff_compact_index_get(ci, i)->pos;
+    printf("read:    %.1f ns per entry in order\n",
+           (av_gettime_relative() - t) * 1000.0 / nb);
+
+    ff_compact_index_free(&ci);
+    av_free(entries);
+    return sum == INT64_MIN;
+}
+
+int main(int argc, char **argv)
+{
+    static const int sizes[] = { 0, 1, 63, 64, 65, 1000, 100000 };
+    AVIndexEntry *entries;
+    AVLFG lfg;
+    int ret = 0;
+
+    if (argc > 1)
+        return bench(atoi(argv[1]));
+
+    entries = av_malloc_array(100000, sizeof(*entries));
+    if (!entries)
+        return 1;
+    av_lfg_init(&lfg, 0xc0ffee);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        for (int discard = 0; discard <= 2; discard += 2) {
+            fill_track(&lfg, entries, sizes[i], discard);
+            if (check(&lfg, entries, sizes[i], 1)) {
+                fprintf(stderr, "track with %d entries failed\n", sizes[i]);
+                ret = 1;
+            }
+        }
+        fill_random(&lfg, entries, sizes[i]);
+        if (check(&lfg, entries, sizes[i], 0)) {
+            fprintf(stderr, "random entries (%d) failed\n", sizes[i]);
+            ret = 1;
+        }
+    }
+
+    av_free(entries);
+    return ret;
+}
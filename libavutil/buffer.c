@@ -23,6 +23,8 @@
 #include "avassert.h"
 #include "buffer_internal.h"
 #include "common.h"
+#include "cpu.h"
+#include "error.h"
 #include "mem.h"
 #include "thread.h"
 
@@ -313,17 +315,74 @@ AVBufferPool *av_buffer_pool_init(size_t size, AVBufferRef* (*alloc)(size_t size
     return pool;
 }
 
-static void buffer_pool_flush(AVBufferPool *pool)
+static int buffer_pool_init_caches(AVBufferPool *pool)
+{
+    int nb_caches = 2;
+
+    while (nb_caches < FFMIN(av_cpu_count(), 64))
+        nb_caches <<= 1;
+
+    pool->caches = av_calloc(nb_caches, sizeof(*pool->caches));
+    if (!pool->caches)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < nb_caches; i++) {
+        if (ff_mutex_init(&pool->caches[i].mutex, NULL)) {
+            while (i--)
+                ff_mutex_destroy(&pool->caches[i].mutex);
+            av_freep(&pool->caches);
+            return AVERROR(ENOMEM);
+        }
+    }
+    pool->nb_caches   = nb_caches;
+    pool->cache_shift = 32 - av_log2(nb_caches);
+
+    return 0;
+}
+
+AVBufferPool *av_buffer_pool_init3(size_t size, void *opaque,
+                                   AVBufferRef* (*alloc)(void *opaque, size_t size),
+                                   void (*pool_free)(void *opaque), int flags)
 {
-    while (pool->pool) {
-        BufferPoolEntry *buf = pool->pool;
-        pool->pool = buf->next;
+    AVBufferPool *pool = av_buffer_pool_init2(size, opaque, alloc, pool_free);
+    if (!pool)
+        return NULL;
+
+    if ((flags & AV_BUFFER_POOL_FLAG_THREAD_CACHES) &&
+        buffer_pool_init_caches(pool) < 0) {
+        ff_mutex_destroy(&pool->mutex);
+        av_free(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+static void buffer_pool_free_entries(BufferPoolEntry **entries)
+{
+    while (*entries) {
+        BufferPoolEntry *buf = *entries;
+        *entries = buf->next;
 
         buf->free(buf->opaque, buf->data);
         av_freep(&buf);
     }
 }
 
+static void buffer_pool_flush(AVBufferPool *pool)
+{
+    buffer_pool_free_entries(&pool->pool);
+
+    for (int i = 0; i < pool->nb_caches; i++) {
+        BufferPoolCache *cache = &pool->caches[i];
+
+        ff_mutex_lock(&cache->mutex);
+        buffer_pool_free_entries(&cache->pool);
+        cache->nb_entries = 0;
+        ff_mutex_unlock(&cache->mutex);
+    }
+}
+
 /*
  * This function gets called when the pool has been uninited and
  * all the buffers returned to it.
@@ -333,6 +392,10 @@ static void buffer_pool_free(AVBufferPool *pool)
     buffer_pool_flush(pool);
     ff_mutex_destroy(&pool->mutex);
 
+    for (int i = 0; i < pool->nb_caches; i++)
+        ff_mutex_destroy(&pool->caches[i].mutex);
+    av_freep(&pool->caches);
+
     if (pool->pool_free)
         pool->pool_free(pool->opaque);
 
@@ -356,15 +419,59 @@ void av_buffer_pool_uninit(AVBufferPool **ppool)
         buffer_pool_free(pool);
 }
 
+/* number of free buffers above which a thread cache returns some of them
+ * to the shared pool; half of it are moved at once in both directions */
+#define POOL_CACHE_SIZE 8
+
+static BufferPoolCache *buffer_pool_thread_cache(AVBufferPool *pool)
+{
+    /* Threads run on separate stacks, so the address of a local variable
+     * tells them apart without thread-local storage. The stack pointer of
+     * a thread seldom moves by more than 64 KiB between calls, so a thread
+     * keeps using the same cache most of the time. */
+    uint8_t local;
+    uint32_t hash = (uint32_t)((uintptr_t)&local >> 16) * 0x9E3779B1U;
+
+    return &pool->caches[hash >> pool->cache_shift];
+}
+
 static void pool_release_buffer(void *opaque, uint8_t *data)
 {
     BufferPoolEntry *buf = opaque;
     AVBufferPool *pool = buf->pool;
 
-    ff_mutex_lock(&pool->mutex);
-    buf->next = pool->pool;
-    pool->pool = buf;
-    ff_mutex_unlock(&pool->mutex);
+    if (pool->caches) {
+        BufferPoolCache *cache = buffer_pool_thread_cache(pool);
+        BufferPoolEntry *batch = NULL, *last;
+
+        ff_mutex_lock(&cache->mutex);
+        buf->next   = cache->pool;
+        cache->pool = buf;
+        if (++cache->nb_entries > POOL_CACHE_SIZE) {
+            /* keep the most recently used buffers */
+            last = cache->pool;
+            for (int i = 1; i < POOL_CACHE_SIZE / 2; i++)
+                last = last->next;
+            batch      = last->next;
+            last->next = NULL;
+            cache->nb_entries = POOL_CACHE_SIZE / 2;
+        }
+        ff_mutex_unlock(&cache->mutex);
+
+        if (batch) {
+            for (last = batch; last->next; last = last->next)
+                ;
+            ff_mutex_lock(&pool->mutex);
+            last->next = pool->pool;
+            pool->pool = batch;
+            ff_mutex_unlock(&pool->mutex);
+        }
+    } else {
+        ff_mutex_lock(&pool->mutex);
+        buf->next = pool->pool;
+        pool->pool = buf;
+        ff_mutex_unlock(&pool->mutex);
+    }
 
     if (atomic_fetch_sub_explicit(&pool->refcount, 1, memory_order_acq_rel) == 1)
         buffer_pool_free(pool);
@@ -401,33 +508,165 @@ static AVBufferRef *pool_alloc_buffer(AVBufferPool *pool)
     return ret;
 }
 
-AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
+/* create a reference to a buffer taken out of the pool */
+static AVBufferRef *pool_reuse_buffer(AVBufferPool *pool, BufferPoolEntry *buf)
 {
     AVBufferRef *ret;
-    BufferPoolEntry *buf;
 
-    ff_mutex_lock(&pool->mutex);
-    buf = pool->pool;
+    memset(&buf->buffer, 0, sizeof(buf->buffer));
+    ret = buffer_create(&buf->buffer, buf->data, pool->size,
+                        pool_release_buffer, buf, 0);
+    if (ret)
+        buf->buffer.flags_internal |= BUFFER_FLAG_NO_FREE;
+
+    return ret;
+}
+
+/* move up to POOL_CACHE_SIZE / 2 buffers from the list *entries to a batch,
+ * the caller holds the lock of the list */
+static BufferPoolEntry *pool_take_batch(BufferPoolEntry **entries, int *nb,
+                                        BufferPoolEntry **last)
+{
+    BufferPoolEntry *batch = *entries;
+
+    while (*entries && *nb < POOL_CACHE_SIZE / 2) {
+        *last    = *entries;
+        *entries = (*entries)->next;
+        (*nb)++;
+    }
+    return batch;
+}
+
+static AVBufferRef *pool_get_cached(AVBufferPool *pool)
+{
+    BufferPoolCache *cache = buffer_pool_thread_cache(pool);
+    BufferPoolEntry *buf, *batch, *last = NULL;
+    AVBufferRef *ret;
+    int nb = 0;
+
+    ff_mutex_lock(&cache->mutex);
+    buf = cache->pool;
     if (buf) {
-        memset(&buf->buffer, 0, sizeof(buf->buffer));
-        ret = buffer_create(&buf->buffer, buf->data, pool->size,
-                            pool_release_buffer, buf, 0);
+        ret = pool_reuse_buffer(pool, buf);
         if (ret) {
-            pool->pool = buf->next;
+            cache->pool = buf->next;
+            cache->nb_entries--;
+            cache->hits++;
             buf->next = NULL;
-            buf->buffer.flags_internal |= BUFFER_FLAG_NO_FREE;
         }
-    } else {
-        ret = pool_alloc_buffer(pool);
+        ff_mutex_unlock(&cache->mutex);
+        return ret;
     }
+    ff_mutex_unlock(&cache->mutex);
+
+    /* refill the cache from the shared pool */
+    ff_mutex_lock(&pool->mutex);
+    batch = pool_take_batch(&pool->pool, &nb, &last);
     ff_mutex_unlock(&pool->mutex);
 
-    if (ret)
-        atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
+    /* Buffers released by another thread than the one that got them stay
+     * in the cache of the releasing thread until it overflows. Take them
+     * from there rather than allocating, so that the pool does not grow
+     * beyond the number of buffers actually in use. */
+    for (int i = 1; !batch && i < pool->nb_caches; i++) {
+        BufferPoolCache *other = &pool->caches[(cache - pool->caches + i) &
+                                               (pool->nb_caches - 1)];
+
+        ff_mutex_lock(&other->mutex);
+        batch = pool_take_batch(&other->pool, &nb, &last);
+        other->nb_entries -= nb;
+        ff_mutex_unlock(&other->mutex);
+    }
+
+    if (!batch) {
+        ff_mutex_lock(&pool->mutex);
+        ret = pool_alloc_buffer(pool);
+        if (ret)
+            pool->misses++;
+        ff_mutex_unlock(&pool->mutex);
+        return ret;
+    }
+    last->next = NULL;
+
+    buf   = batch;
+    batch = buf->next;
+    ret   = pool_reuse_buffer(pool, buf);
+    if (ret) {
+        buf->next = NULL;
+        nb--;
+    } else {
+        batch = buf;
+    }
+
+    ff_mutex_lock(&cache->mutex);
+    if (batch) {
+        last->next  = cache->pool;
+        cache->pool = batch;
+        cache->nb_entries += nb;
+    }
+    cache->hits += !!ret;
+    ff_mutex_unlock(&cache->mutex);
 
     return ret;
 }
 
+AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
+{
+    AVBufferRef *ret;
+    BufferPoolEntry *buf;
+    unsigned in_use, max_in_use;
+
+    if (pool->caches) {
+        ret = pool_get_cached(pool);
+    } else {
+        ff_mutex_lock(&pool->mutex);
+        buf = pool->pool;
+        if (buf) {
+            ret = pool_reuse_buffer(pool, buf);
+            if (ret) {
+                pool->pool = buf->next;
+                buf->next = NULL;
+                pool->hits++;
+            }
+        } else {
+            ret = pool_alloc_buffer(pool);
+            if (ret)
+                pool->misses++;
+        }
+        ff_mutex_unlock(&pool->mutex);
+    }
+
+    if (ret) {
+        /* the caller holds one reference to the pool itself */
+        in_use     = atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
+        max_in_use = atomic_load_explicit(&pool->max_in_use, memory_order_relaxed);
+        while (in_use > max_in_use &&
+               !atomic_compare_exchange_weak_explicit(&pool->max_in_use, &max_in_use, in_use,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+            ;
+    }
+
+    return ret;
+}
+
+void av_buffer_pool_get_stats(AVBufferPool *pool, AVBufferPoolStats *stats)
+{
+    ff_mutex_lock(&pool->mutex);
+    stats->hits   = pool->hits;
+    stats->misses = pool->misses;
+    ff_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->nb_caches; i++) {
+        ff_mutex_lock(&pool->caches[i].mutex);
+        stats->hits += pool->caches[i].hits;
+        ff_mutex_unlock(&pool->caches[i].mutex);
+    }
+
+    stats->in_use     = atomic_load_explicit(&pool->refcount, memory_order_relaxed) - 1;
+    stats->max_in_use = atomic_load_explicit(&pool->max_in_use, memory_order_relaxed);
+}
+
 void *av_buffer_pool_buffer_get_opaque(const AVBufferRef *ref)
 {
     BufferPoolEntry *buf = ref->buffer->opaque;
@@ -284,6 +284,24 @@ AVBufferPool *av_buffer_pool_init2(size_t size, void *opaque,
                                    AVBufferRef* (*alloc)(void *opaque, size_t size),
                                    void (*pool_free)(void *opaque));
 
+/**
+ * Give each thread its own cache of free buffers. Caches are refilled from and
+ * returned to the shared pool a few buffers at a time, so that threads getting
+ * and releasing buffers at a high rate rarely contend for the pool. A few more
+ * buffers than strictly needed may be kept allocated as a result.
+ */
+#define AV_BUFFER_POOL_FLAG_THREAD_CACHES (1 << 0)
+
+/**
+ * Same as av_buffer_pool_init2(), with additional flags.
+ *
+ * @param flags a combination of AV_BUFFER_POOL_FLAG_*
+ * @return newly created buffer pool on success, NULL on error.
+ */
+AVBufferPool *av_buffer_pool_init3(size_t size, void *opaque,
+                                   AVBufferRef* (*alloc)(void *opaque, size_t size),
+                                   void (*pool_free)(void *opaque), int flags);
+
 /**
  * Mark the pool as being available for freeing. It will actually be freed only
  * once all the allocated buffers associated with the pool are released. Thus it
@@ -315,6 +333,24 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool);
  */
 void *av_buffer_pool_buffer_get_opaque(const AVBufferRef *ref);
 
+/**
+ * Usage statistics of a buffer pool.
+ */
+typedef struct AVBufferPoolStats {
+    uint64_t hits;       ///< number of buffers reused from the pool
+    uint64_t misses;     ///< number of buffers newly allocated by the pool
+    size_t   in_use;     ///< number of buffers currently in use
+    size_t   max_in_use; ///< largest number of buffers in use at the same time
+} AVBufferPoolStats;
+
+/**
+ * Get the usage statistics of a buffer pool.
+ * This function may be called simultaneously with av_buffer_pool_get() and
+ * the release of buffers, in which case the statistics may be slightly out
+ * of date.
+ */
+void av_buffer_pool_get_stats(AVBufferPool *pool, AVBufferPoolStats *stats);
+
 /**
  * @}
  */
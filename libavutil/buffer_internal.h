@@ -85,6 +85,20 @@ typedef struct BufferPoolEntry {
     AVBuffer buffer;
 } BufferPoolEntry;
 
+/*
+ * Free buffers kept for the threads mapped to this cache,
+ * see AV_BUFFER_POOL_FLAG_THREAD_CACHES.
+ */
+typedef struct BufferPoolCache {
+    AVMutex mutex;
+    BufferPoolEntry *pool;
+    int nb_entries;
+    uint64_t hits;
+
+    /* keep the caches used by different threads on different cache lines */
+    uint8_t padding[64];
+} BufferPoolCache;
+
 struct AVBufferPool {
     AVMutex mutex;
     BufferPoolEntry *pool;
@@ -105,6 +119,16 @@ struct AVBufferPool {
     AVBufferRef* (*alloc)(size_t size);
     AVBufferRef* (*alloc2)(void *opaque, size_t size);
     void         (*pool_free)(void *opaque);
+
+    /* statistics, the counters are protected by mutex */
+    uint64_t hits;
+    uint64_t misses;
+    atomic_uint max_in_use;
+
+    /* per-thread caches, NULL unless enabled; nb_caches is a power of two */
+    BufferPoolCache *caches;
+    int nb_caches;
+    int cache_shift;
 };
 
 #endif /* AVUTIL_BUFFER_INTERNAL_H */
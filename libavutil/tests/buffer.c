@@ -0,0 +1,245 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Checks buffer pools with and without thread caches: buffers are reused,
+ * never handed out twice at the same time, and the statistics add up.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/macros.h"
+#include "libavutil/thread.h"
+#include "libavutil/threadmessage.h"
+
+#define BUF_SIZE    64
+#define NB_HELD     5
+#define NB_ROUNDS   2000
+#define NB_THREADS  4
+#define NB_QUEUED   8
+/* Buffers that may be allocated beyond the most ever in use: in_use is
+ * updated after a buffer is taken or returned, which can lag by one buffer
+ * per thread, and with thread caches a thread may be moving up to half a
+ * cache of free buffers while another one allocates. */
+#define IN_USE_LAG  1
+#define NB_TRANSIT  4
+
+static int check_stats(AVBufferPool *pool, uint64_t nb_gets, size_t in_use,
+                       size_t max_in_use, uint64_t max_misses)
+{
+    AVBufferPoolStats stats;
+
+    av_buffer_pool_get_stats(pool, &stats);
+    if (stats.hits + stats.misses != nb_gets || stats.in_use != in_use ||
+        stats.max_in_use != max_in_use || stats.misses > max_misses) {
+        fprintf(stderr, "unexpected statistics: %"PRIu64" hits %"PRIu64" misses "
+                "%zu in use %zu max in use\n", stats.hits, stats.misses,
+                stats.in_use, stats.max_in_use);
+        return 1;
+    }
+    return 0;
+}
+
+/* hold a few buffers at a time, marked with the id of the thread */
+static void *worker(void *arg)
+{
+    AVBufferPool *pool = arg;
+    AVBufferRef *held[NB_HELD] = { NULL };
+    uint8_t id = (uintptr_t)&held >> 8;
+    intptr_t err = 0;
+
+    for (int i = 0; i < NB_ROUNDS * NB_HELD; i++) {
+        AVBufferRef **buf = &held[i % NB_HELD];
+
+        if (*buf) {
+            if ((*buf)->data[0] != id || (*buf)->data[BUF_SIZE - 1] != id)
+                err = 1;
+            av_buffer_unref(buf);
+        }
+        *buf = av_buffer_pool_get(pool);
+        if (!*buf)
+            return (void *)1;
+        memset((*buf)->data, id, BUF_SIZE);
+    }
+
+    for (int i = 0; i < NB_HELD; i++)
+        av_buffer_unref(&held[i]);
+    return (void *)err;
+}
+
+#if HAVE_THREADS
+/* every thread gets and releases its own buffers */
+static int test_threads(AVBufferPool *pool, int flags)
+{
+    pthread_t threads[NB_THREADS];
+    AVBufferPoolStats before, stats;
+    int nb_threads, ret = 0;
+    void *res;
+
+    av_buffer_pool_get_stats(pool, &before);
+    for (nb_threads = 0; nb_threads < NB_THREADS; nb_threads++)
+        if (pthread_create(&threads[nb_threads], NULL, worker, pool))
+            break;
+    for (int i = 0; i < nb_threads; i++) {
+        pthread_join(threads[i], &res);
+        if (res)
+            ret = 1;
+    }
+
+    av_buffer_pool_get_stats(pool, &stats);
+    if (stats.hits + stats.misses != before.hits + before.misses +
+                                     nb_threads * NB_ROUNDS * NB_HELD ||
+        stats.in_use || stats.max_in_use < NB_HELD ||
+        stats.max_in_use > FFMAX(nb_threads, 1) * NB_HELD ||
+        stats.misses > stats.max_in_use + nb_threads * (IN_USE_LAG + (flags ? NB_TRANSIT : 0))) {
+        fprintf(stderr, "%d threads: %"PRIu64" hits %"PRIu64" misses %zu in use "
+                "%zu max in use\n", nb_threads, stats.hits, stats.misses,
+                stats.in_use, stats.max_in_use);
+        ret = 1;
+    }
+    return ret;
+}
+
+typedef struct Handoff {
+    AVBufferPool *pool;
+    AVThreadMessageQueue *queue;
+} Handoff;
+
+static void *release_queued(void *arg)
+{
+    Handoff *h = arg;
+    AVBufferRef *buf;
+    intptr_t err = 0;
+
+    while (av_thread_message_queue_recv(h->queue, &buf, 0) >= 0) {
+        if (buf->data[0] != 0x5a || buf->data[BUF_SIZE - 1] != 0x5a)
+            err = 1;
+        av_buffer_unref(&buf);
+    }
+    return (void *)err;
+}
+
+static void free_queued(void *msg)
+{
+    av_buffer_unref(msg);
+}
+
+/* one thread gets the buffers, another one releases them */
+static int test_handoff(AVBufferPool *pool, int flags)
+{
+    Handoff h = { pool };
+    AVBufferPoolStats before, stats;
+    pthread_t thread;
+    int ret = 0;
+    void *res;
+
+    if (av_thread_message_queue_alloc(&h.queue, NB_QUEUED, sizeof(AVBufferRef *)) < 0)
+        return 1;
+    av_thread_message_queue_set_free_func(h.queue, free_queued);
+    if (pthread_create(&thread, NULL, release_queued, &h)) {
+        av_thread_message_queue_free(&h.queue);
+        return 0;
+    }
+
+    av_buffer_pool_get_stats(pool, &before);
+    for (int i = 0; i < NB_ROUNDS * NB_HELD; i++) {
+        AVBufferRef *buf = av_buffer_pool_get(pool);
+
+        if (!buf) {
+            ret = 1;
+            break;
+        }
+        memset(buf->data, 0x5a, BUF_SIZE);
+        if (av_thread_message_queue_send(h.queue, &buf, 0) < 0) {
+            av_buffer_unref(&buf);
+            ret = 1;
+            break;
+        }
+    }
+    av_thread_message_queue_set_err_recv(h.queue, AVERROR_EOF);
+    pthread_join(thread, &res);
+    if (res)
+        ret = 1;
+    av_thread_message_queue_free(&h.queue);
+
+    /* the buffers released by the other thread must be reused rather than
+     * piling up in its cache */
+    av_buffer_pool_get_stats(pool, &stats);
+    if (stats.hits + stats.misses != before.hits + before.misses + NB_ROUNDS * NB_HELD ||
+        stats.in_use || stats.max_in_use > FFMAX(before.max_in_use, NB_QUEUED + 2) ||
+        stats.misses > stats.max_in_use + 2 * IN_USE_LAG + (flags ? NB_TRANSIT : 0)) {
+        fprintf(stderr, "handoff: %"PRIu64" hits %"PRIu64" misses %zu in use "
+                "%zu max in use\n", stats.hits, stats.misses, stats.in_use,
+                stats.max_in_use);
+        ret = 1;
+    }
+    return ret;
+}
+#endif
+
+static int test_pool(int flags)
+{
+    AVBufferPool *pool = av_buffer_pool_init3(BUF_SIZE, NULL, NULL, NULL, flags);
+    AVBufferRef *held[NB_HELD] = { NULL };
+    int ret = 0;
+
+    if (!pool)
+        return 1;
+
+    for (int i = 0; i < NB_HELD; i++)
+        if (!(held[i] = av_buffer_pool_get(pool)))
+            ret = 1;
+    ret |= check_stats(pool, NB_HELD, NB_HELD, NB_HELD, NB_HELD);
+    for (int i = 0; i < NB_HELD; i++)
+        av_buffer_unref(&held[i]);
+    ret |= check_stats(pool, NB_HELD, 0, NB_HELD, NB_HELD);
+
+    /* Buffers may be released to another cache than the one they are taken
+     * from by the same thread, which can cost a few more allocations. */
+    if (worker(pool))
+        ret = 1;
+    ret |= check_stats(pool, NB_HELD + NB_ROUNDS * NB_HELD, 0, NB_HELD,
+                       flags ? 2 * NB_HELD + 8 : NB_HELD);
+
+#if HAVE_THREADS
+    ret |= test_threads(pool, flags);
+    ret |= test_handoff(pool, flags);
+#endif
+
+    av_buffer_pool_uninit(&pool);
+    return ret;
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    if (test_pool(0)) {
+        fprintf(stderr, "pool without thread caches failed\n");
+        ret = 1;
+    }
+    if (test_pool(AV_BUFFER_POOL_FLAG_THREAD_CACHES)) {
+        fprintf(stderr, "pool with thread caches failed\n");
+        ret = 1;
+    }
+
+    return ret;
+}
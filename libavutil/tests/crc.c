@@ -21,6 +21,19 @@
 
 #include "libavutil/crc.h"
 
+/* the CRC computed in pieces of up to 15 bytes, each continuing the previous one */
+static uint32_t crc_pieces(const AVCRC *ctx, uint32_t crc,
+                           const uint8_t *buf, size_t len)
+{
+    while (len) {
+        size_t size = len < 15 ? len : 15;
+        crc = av_crc(ctx, crc, buf, size);
+        buf += size;
+        len -= size;
+    }
+    return crc;
+}
+
 int main(void)
 {
     uint8_t buf[1999];
@@ -43,5 +56,20 @@ int main(void)
         ctx = av_crc_get_table(p[i][0]);
         printf("crc %08X = %X\n", p[i][1], av_crc(ctx, 0, buf, sizeof(buf)));
     }
+
+    for (i = 0; i < AV_CRC_MAX; i++) {
+        static const uint32_t init[] = { 0, UINT32_MAX, 0x12345678 };
+        ctx = av_crc_get_table(i);
+        for (size_t len = 0; len < 300; len += 1 + len / 8) {
+            for (int j = 0; j < 3 * 16; j++) {
+                size_t off = j / 3;
+                if (av_crc(ctx, init[j % 3], buf + off, len) !=
+                    crc_pieces(ctx, init[j % 3], buf + off, len)) {
+                    printf("crc %d mismatch for %zu bytes at %zu\n", i, len, off);
+                    return 1;
+                }
+            }
+        }
+    }
     return 0;
 }
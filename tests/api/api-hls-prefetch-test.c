@@ -0,0 +1,156 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * HLS segment prefetch test: read a playlist with prefetching enabled, check
+ * that the segments come from the prefetch window, then that a seek back
+ * reads the same data and that a custom io_open callback disables
+ * prefetching instead of being bypassed.
+ */
+
+#include "libavutil/adler32.h"
+#include "libavutil/dict.h"
+#include "libavutil/opt.h"
+#include "libavformat/avformat.h"
+
+static int nb_opens;
+
+static int custom_io_open(AVFormatContext *s, AVIOContext **pb, const char *url,
+                          int flags, AVDictionary **options)
+{
+    nb_opens++;
+    return avio_open2(pb, url, flags, &s->interrupt_callback, options);
+}
+
+static int custom_io_close2(AVFormatContext *s, AVIOContext *pb)
+{
+    return avio_close(pb);
+}
+
+static int read_packets(AVFormatContext *fmt_ctx, int max_packets,
+                        int *nb_packets, uint32_t *checksum)
+{
+    AVPacket *pkt = av_packet_alloc();
+    int ret = 0;
+
+    if (!pkt)
+        return AVERROR(ENOMEM);
+
+    *nb_packets = 0;
+    *checksum   = 0;
+    while (!max_packets || *nb_packets < max_packets) {
+        ret = av_read_frame(fmt_ctx, pkt);
+        if (ret == AVERROR_EOF) {
+            ret = 0;
+            break;
+        }
+        if (ret < 0)
+            break;
+        *checksum = av_adler32_update(*checksum, pkt->data, pkt->size);
+        (*nb_packets)++;
+        av_packet_unref(pkt);
+    }
+
+    av_packet_free(&pkt);
+    return ret;
+}
+
+static int test_prefetch(const char *url, int custom_io)
+{
+    AVFormatContext *fmt_ctx = avformat_alloc_context();
+    AVDictionary *opts = NULL;
+    int64_t hits = -1, misses = -1, start;
+    uint32_t checksum, checksum2;
+    int nb_packets, nb_packets2, ret;
+
+    if (!fmt_ctx)
+        return AVERROR(ENOMEM);
+    if (custom_io) {
+        fmt_ctx->io_open   = custom_io_open;
+        fmt_ctx->io_close2 = custom_io_close2;
+    }
+    nb_opens = 0;
+
+    av_dict_set(&opts, "prefetch_segments", "3", 0);
+    ret = avformat_open_input(&fmt_ctx, url, NULL, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't open %s\n", url);
+        return ret;
+    }
+
+    ret = read_packets(fmt_ctx, 0, &nb_packets, &checksum);
+    if (ret < 0)
+        goto end;
+    av_opt_get_int(fmt_ctx, "prefetch_hits",   AV_OPT_SEARCH_CHILDREN, &hits);
+    av_opt_get_int(fmt_ctx, "prefetch_misses", AV_OPT_SEARCH_CHILDREN, &misses);
+    printf("%s: packets %d checksum 0x%08"PRIx32" hits %"PRId64" misses %"PRId64"\n",
+           custom_io ? "custom io_open" : "prefetch",
+           nb_packets, checksum, hits, misses);
+
+    if (custom_io) {
+        if (hits || misses || !nb_opens) {
+            av_log(NULL, AV_LOG_ERROR, "Prefetching bypassed the io_open callback\n");
+            ret = AVERROR_BUG;
+        }
+        goto end;
+    }
+    if (hits <= 0) {
+        av_log(NULL, AV_LOG_ERROR, "No segment was read from the prefetch window\n");
+        ret = AVERROR_BUG;
+        goto end;
+    }
+
+    /* read again after seeking back from the middle of the playlist */
+    start = fmt_ctx->streams[0]->start_time;
+    ret = avformat_seek_file(fmt_ctx, 0, INT64_MIN, start, start, 0);
+    if (ret >= 0)
+        ret = read_packets(fmt_ctx, nb_packets / 2, &nb_packets2, &checksum2);
+    if (ret >= 0)
+        ret = avformat_seek_file(fmt_ctx, 0, INT64_MIN, start, start, 0);
+    if (ret >= 0)
+        ret = read_packets(fmt_ctx, 0, &nb_packets2, &checksum2);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Seeking back failed: %s\n", av_err2str(ret));
+        goto end;
+    }
+    if (nb_packets2 != nb_packets || checksum2 != checksum) {
+        av_log(NULL, AV_LOG_ERROR, "Different data after seeking back\n");
+        ret = AVERROR_BUG;
+        goto end;
+    }
+    printf("seek: packets %d checksum 0x%08"PRIx32"\n", nb_packets2, checksum2);
+
+end:
+    avformat_close_input(&fmt_ctx);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        av_log(NULL, AV_LOG_ERROR, "Incorrect input\n");
+        return 1;
+    }
+
+    if (test_prefetch(argv[1], 0) < 0 ||
+        test_prefetch(argv[1], 1) < 0)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,287 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * MPEG-TS complete_pes_frames test: mux encoded video into a TS with the
+ * data alignment indicator set on the video PES packets, as many broadcast
+ * muxers do, and check that demuxing it with complete_pes_frames returns
+ * the same packets as with full parsing, without falling back. Then clear
+ * the indicator of one PES packet and check that the fallback returns the
+ * same packets as well.
+ */
+
+#include <string.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavcodec/avcodec.h"
+#include "libavformat/avformat.h"
+
+#define TS_PACKET_SIZE 188
+#define NB_FRAMES      25
+#define WIDTH          64
+#define HEIGHT         48
+
+typedef struct BufferData {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+} BufferData;
+
+static int nb_fallbacks;
+
+static void log_callback(void *ptr, int level, const char *fmt, va_list vl)
+{
+    if (strstr(fmt, "reassembling frames"))
+        nb_fallbacks++;
+    if (level <= AV_LOG_WARNING)
+        av_log_default_callback(ptr, level, fmt, vl);
+}
+
+static int read_buffer(void *opaque, uint8_t *buf, int buf_size)
+{
+    BufferData *bd = opaque;
+
+    buf_size = FFMIN(buf_size, bd->size - bd->pos);
+    if (!buf_size)
+        return AVERROR_EOF;
+    memcpy(buf, bd->data + bd->pos, buf_size);
+    bd->pos += buf_size;
+    return buf_size;
+}
+
+static int encode_ts(uint8_t **ts, int *ts_size)
+{
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MPEG2VIDEO);
+    AVFormatContext *oc = NULL;
+    AVCodecContext *enc = NULL;
+    AVFrame *frame = NULL;
+    AVPacket *pkt = NULL;
+    AVStream *st;
+    int ret;
+
+    if (!codec)
+        return AVERROR_ENCODER_NOT_FOUND;
+    enc   = avcodec_alloc_context3(codec);
+    frame = av_frame_alloc();
+    pkt   = av_packet_alloc();
+    if (!enc || !frame || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    enc->width        = WIDTH;
+    enc->height       = HEIGHT;
+    enc->pix_fmt      = AV_PIX_FMT_YUV420P;
+    enc->time_base    = (AVRational){ 1, 25 };
+    enc->gop_size     = 6;
+    enc->max_b_frames = 2;
+    enc->flags       |= AV_CODEC_FLAG_BITEXACT;
+    if ((ret = avcodec_open2(enc, codec, NULL)) < 0)
+        goto end;
+
+    if ((ret = avformat_alloc_output_context2(&oc, NULL, "mpegts", NULL)) < 0)
+        goto end;
+    oc->flags |= AVFMT_FLAG_BITEXACT;
+    st = avformat_new_stream(oc, NULL);
+    if (!st) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    st->time_base = enc->time_base;
+    if ((ret = avcodec_parameters_from_context(st->codecpar, enc)) < 0 ||
+        (ret = avio_open_dyn_buf(&oc->pb)) < 0 ||
+        (ret = avformat_write_header(oc, NULL)) < 0)
+        goto end;
+
+    frame->format = enc->pix_fmt;
+    frame->width  = enc->width;
+    frame->height = enc->height;
+    if ((ret = av_frame_get_buffer(frame, 0)) < 0)
+        goto end;
+
+    for (int i = 0; i <= NB_FRAMES; i++) {
+        if (i < NB_FRAMES) {
+            if ((ret = av_frame_make_writable(frame)) < 0)
+                goto end;
+            for (int y = 0; y < HEIGHT; y++)
+                for (int x = 0; x < WIDTH; x++)
+                    frame->data[0][y * frame->linesize[0] + x] = x * 3 + y * 2 + i * 5;
+            for (int y = 0; y < HEIGHT / 2; y++) {
+                memset(frame->data[1] + y * frame->linesize[1], 128 + i, WIDTH / 2);
+                memset(frame->data[2] + y * frame->linesize[2], 64 + y, WIDTH / 2);
+            }
+            frame->pts = i;
+        }
+        ret = avcodec_send_frame(enc, i < NB_FRAMES ? frame : NULL);
+        if (ret < 0)
+            goto end;
+        while ((ret = avcodec_receive_packet(enc, pkt)) >= 0) {
+            av_packet_rescale_ts(pkt, enc->time_base, st->time_base);
+            if ((ret = av_interleaved_write_frame(oc, pkt)) < 0)
+                goto end;
+        }
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            goto end;
+    }
+    ret = av_write_trailer(oc);
+
+end:
+    if (oc) {
+        if (oc->pb)
+            *ts_size = avio_close_dyn_buf(oc->pb, ts);
+        avformat_free_context(oc);
+    }
+    avcodec_free_context(&enc);
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    return ret;
+}
+
+/**
+ * Set the data alignment indicator of the PES packets of pid, or clear it
+ * in the PES packet number clear_nb.
+ */
+static void set_alignment(uint8_t *ts, int ts_size, int pid, int clear_nb)
+{
+    int nb = 0;
+
+    for (uint8_t *p = ts; p + TS_PACKET_SIZE <= ts + ts_size; p += TS_PACKET_SIZE) {
+        uint8_t *pes = p + 4;
+
+        if (p[0] != 0x47 || (AV_RB16(p + 1) & 0x1fff) != pid || !(p[1] & 0x40))
+            continue;
+        if (p[3] & 0x20)
+            pes += 1 + p[4];
+        if (pes + 9 > p + TS_PACKET_SIZE || AV_RB24(pes) != 1)
+            continue;
+        if (nb++ == clear_nb)
+            pes[6] &= ~0x04;
+        else
+            pes[6] |=  0x04;
+    }
+}
+
+static int demux_ts(const uint8_t *ts, int ts_size, int complete_frames,
+                    int *nb_packets, uint32_t *checksum)
+{
+    BufferData bd = { ts, ts_size };
+    AVFormatContext *ic = avformat_alloc_context();
+    AVDictionary *opts = NULL;
+    AVPacket *pkt = av_packet_alloc();
+    uint8_t *buf = av_malloc(4096);
+    AVIOContext *pb = NULL;
+    int ret;
+
+    if (buf)
+        pb = avio_alloc_context(buf, 4096, 0, &bd, read_buffer, NULL, NULL);
+    if (!ic || !pkt || !pb) {
+        av_free(buf);
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    ic->pb = pb;
+
+    av_dict_set_int(&opts, "complete_pes_frames", complete_frames, 0);
+    ret = avformat_open_input(&ic, NULL, av_find_input_format("mpegts"), &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+        goto end;
+
+    *nb_packets = 0;
+    *checksum   = 0;
+    while ((ret = av_read_frame(ic, pkt)) >= 0) {
+        uint8_t hdr[8 * 4];
+
+        AV_WB64(hdr,      pkt->pts);
+        AV_WB64(hdr + 8,  pkt->dts);
+        AV_WB32(hdr + 16, pkt->size);
+        AV_WB32(hdr + 20, pkt->flags);
+        AV_WB64(hdr + 24, pkt->pos);
+        *checksum = av_adler32_update(*checksum, hdr, sizeof(hdr));
+        *checksum = av_adler32_update(*checksum, pkt->data, pkt->size);
+        (*nb_packets)++;
+        av_packet_unref(pkt);
+    }
+    if (ret == AVERROR_EOF)
+        ret = 0;
+
+end:
+    avformat_close_input(&ic);
+    if (pb)
+        av_freep(&pb->buffer);
+    avio_context_free(&pb);
+    av_packet_free(&pkt);
+    return ret;
+}
+
+static int test_demux(const uint8_t *ts, int ts_size, const char *name)
+{
+    uint32_t checksum, checksum2;
+    int nb_packets, nb_packets2, ret;
+
+    if ((ret = demux_ts(ts, ts_size, 0, &nb_packets, &checksum)) < 0)
+        return ret;
+    nb_fallbacks = 0;
+    if ((ret = demux_ts(ts, ts_size, 1, &nb_packets2, &checksum2)) < 0)
+        return ret;
+
+    printf("%s: packets %d checksum 0x%08"PRIx32" fallbacks %d\n",
+           name, nb_packets2, checksum2, nb_fallbacks);
+    if (nb_packets2 != nb_packets || checksum2 != checksum) {
+        av_log(NULL, AV_LOG_ERROR, "%s: packets differ from full parsing: "
+               "%d 0x%08"PRIx32"\n", name, nb_packets, checksum);
+        return AVERROR_BUG;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    uint8_t *ts = NULL;
+    int ts_size = 0, ret;
+
+    av_log_set_callback(log_callback);
+    av_log_set_level(AV_LOG_VERBOSE);
+
+    ret = encode_ts(&ts, &ts_size);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Encoding failed: %s\n", av_err2str(ret));
+        av_free(ts);
+        return 1;
+    }
+
+    /* 0x100 is the pid of the first stream written by the muxer */
+    set_alignment(ts, ts_size, 0x100, -1);
+    ret = test_demux(ts, ts_size, "aligned");
+    if (ret >= 0 && nb_fallbacks) {
+        av_log(NULL, AV_LOG_ERROR, "Aligned PES packets were reassembled\n");
+        ret = AVERROR_BUG;
+    }
+    if (ret >= 0) {
+        set_alignment(ts, ts_size, 0x100, NB_FRAMES / 2);
+        ret = test_demux(ts, ts_size, "unaligned");
+    }
+    if (ret >= 0 && nb_fallbacks != 1) {
+        av_log(NULL, AV_LOG_ERROR, "Unaligned PES packet did not fall back\n");
+        ret = AVERROR_BUG;
+    }
+
+    av_free(ts);
+    return ret < 0;
+}
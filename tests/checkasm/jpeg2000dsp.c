@@ -89,6 +89,32 @@ static void check_ict_float(void)
     bench_new(new0, new1, new2, BUF_SIZE);
 }
 
+static void check_ht_dequant_quads(void)
+{
+    LOCAL_ALIGNED_32(uint32_t, src, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(int32_t, ref, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(int32_t, new, [BUF_SIZE]);
+    int32_t *ref0 = &ref[0], *ref1 = &ref[BUF_SIZE / 2];
+    int32_t *new0 = &new[0], *new1 = &new[BUF_SIZE / 2];
+    int i, nb_quads, shift;
+
+    declare_func(void, int32_t *dst0, int32_t *dst1, const uint32_t *src,
+                 int nb_quads, int shift);
+
+    for (nb_quads = 1; nb_quads <= BUF_SIZE / 4; nb_quads += nb_quads < 8 ? 1 : 61) {
+        shift = rnd() % 30;
+        for (i = 0; i < BUF_SIZE; i++)
+            src[i] = rnd();
+        memset(ref, 0, BUF_SIZE * sizeof(*ref));
+        memset(new, 0, BUF_SIZE * sizeof(*new));
+        call_ref(ref0, ref1, src, nb_quads, shift);
+        call_new(new0, new1, src, nb_quads, shift);
+        if (memcmp(ref, new, BUF_SIZE * sizeof(*ref)))
+            fail();
+    }
+    bench_new(new0, new1, src, BUF_SIZE / 4, 8);
+}
+
 void checkasm_check_jpeg2000dsp(void)
 {
     Jpeg2000DSPContext h;
@@ -101,4 +127,8 @@ void checkasm_check_jpeg2000dsp(void)
         check_ict_float();
 
     report("mct_decode");
+
+    if (check_func(h.ht_dequant_quads, "jpeg2000_ht_dequant_quads"))
+        check_ht_dequant_quads();
+    report("ht_dequant_quads");
 }
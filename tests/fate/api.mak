@@ -22,6 +22,16 @@ fate-lavf-flv: KEEP_FILES ?= 1
 fate-api-seek: CMD = run $(APITESTSDIR)/api-seek-test$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.flv 0 720
 fate-api-seek: CMP = null
 
+ifdef HAVE_THREADS
+FATE_API_LIBAVFORMAT-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILTER ARESAMPLE_FILTER LAVFI_INDEV MP2FIXED_ENCODER FILE_PROTOCOL) += fate-api-hls-prefetch
+endif
+fate-api-hls-prefetch: $(APITESTSDIR)/api-hls-prefetch-test$(EXESUF) tests/data/hls_segment_size.m3u8
+fate-api-hls-prefetch: CMD = run $(APITESTSDIR)/api-hls-prefetch-test$(EXESUF) $(TARGET_PATH)/tests/data/hls_segment_size.m3u8
+
+FATE_API_LIBAVFORMAT-$(call ALLYES, MPEGTS_MUXER MPEGTS_DEMUXER MPEG2VIDEO_ENCODER MPEG2VIDEO_DECODER MPEGVIDEO_PARSER) += fate-api-mpegts-complete-frames
+fate-api-mpegts-complete-frames: $(APITESTSDIR)/api-mpegts-complete-frames-test$(EXESUF)
+fate-api-mpegts-complete-frames: CMD = run $(APITESTSDIR)/api-mpegts-complete-frames-test$(EXESUF)
+
 FATE_API-$(HAVE_THREADS) += fate-api-threadmessage
 fate-api-threadmessage: $(APITESTSDIR)/api-threadmessage-test$(EXESUF)
 fate-api-threadmessage: CMD = run $(APITESTSDIR)/api-threadmessage-test$(EXESUF) 3 10 30 50 2 20 40
@@ -0,0 +1,39 @@
+tests/data/dash_segment_template.mpd: TAG = GEN
+tests/data/dash_segment_template.mpd: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i "aevalsrc=cos(2*PI*t)*sin(2*PI*(440+4*t)*t):d=20" -f dash -seg_duration 2 -map 0 \
+	-codec:a mp2fixed -flags +bitexact -fflags +bitexact \
+	-init_seg_name 'dash_segment_template_init_$$RepresentationID$$.m4s' \
+	-media_seg_name 'dash_segment_template_$$RepresentationID$$_$$Number%03d$$.m4s' \
+	$(TARGET_PATH)/tests/data/dash_segment_template.mpd 2>/dev/null
+
+tests/data/dash_segment_list.mpd: TAG = GEN
+tests/data/dash_segment_list.mpd: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i "aevalsrc=cos(2*PI*t)*sin(2*PI*(440+4*t)*t):d=20" -f dash -seg_duration 2 -map 0 \
+	-codec:a mp2fixed -flags +bitexact -fflags +bitexact \
+	-use_template 0 -init_seg_name 'dash_segment_list_init_$$RepresentationID$$.m4s' \
+	-media_seg_name 'dash_segment_list_$$RepresentationID$$_$$Number%03d$$.m4s' \
+	$(TARGET_PATH)/tests/data/dash_segment_list.mpd 2>/dev/null
+
+FATE_DASHDEC-$(call ALLYES, DASH_DEMUXER DASH_MUXER MP4_MUXER MOV_DEMUXER AEVALSRC_FILTER ARESAMPLE_FILTER LAVFI_INDEV MP2FIXED_ENCODER FILE_PROTOCOL) += fate-dash-segment-template
+fate-dash-segment-template: tests/data/dash_segment_template.mpd
+fate-dash-segment-template: CMD = framecrc -auto_conversion_filters -flags +bitexact -allowed_extensions ALL -i $(TARGET_PATH)/tests/data/dash_segment_template.mpd
+
+# prefetching must not change the demuxed data
+FATE_DASHDEC-$(call ALLYES, DASH_DEMUXER DASH_MUXER MP4_MUXER MOV_DEMUXER AEVALSRC_FILTER ARESAMPLE_FILTER LAVFI_INDEV MP2FIXED_ENCODER FILE_PROTOCOL) += fate-dash-segment-template-prefetch
+fate-dash-segment-template-prefetch: tests/data/dash_segment_template.mpd
+fate-dash-segment-template-prefetch: REF = $(SRC_PATH)/tests/ref/fate/dash-segment-template
+fate-dash-segment-template-prefetch: CMD = framecrc -auto_conversion_filters -flags +bitexact -allowed_extensions ALL -prefetch_segments 3 -i $(TARGET_PATH)/tests/data/dash_segment_template.mpd
+
+FATE_DASHDEC-$(call ALLYES, DASH_DEMUXER DASH_MUXER MP4_MUXER MOV_DEMUXER AEVALSRC_FILTER ARESAMPLE_FILTER LAVFI_INDEV MP2FIXED_ENCODER FILE_PROTOCOL) += fate-dash-segment-list
+fate-dash-segment-list: tests/data/dash_segment_list.mpd
+fate-dash-segment-list: CMD = framecrc -auto_conversion_filters -flags +bitexact -allowed_extensions ALL -i $(TARGET_PATH)/tests/data/dash_segment_list.mpd
+
+FATE_DASHDEC-$(call ALLYES, DASH_DEMUXER DASH_MUXER MP4_MUXER MOV_DEMUXER AEVALSRC_FILTER ARESAMPLE_FILTER LAVFI_INDEV MP2FIXED_ENCODER FILE_PROTOCOL) += fate-dash-segment-list-prefetch
+fate-dash-segment-list-prefetch: tests/data/dash_segment_list.mpd
+fate-dash-segment-list-prefetch: REF = $(SRC_PATH)/tests/ref/fate/dash-segment-list
+fate-dash-segment-list-prefetch: CMD = framecrc -auto_conversion_filters -flags +bitexact -allowed_extensions ALL -prefetch_segments 4 -prefetch_coalesce_size 100000 -i $(TARGET_PATH)/tests/data/dash_segment_list.mpd
+
+FATE_FFMPEG += $(FATE_DASHDEC-yes)
+fate-dashdec: $(FATE_DASHDEC-yes)
@@ -16,6 +16,10 @@ fate-ffmpeg-filter_colorkey: CMD = framecrc -auto_conversion_filters -idct simpl
 FATE_FFMPEG-$(call FILTERFRAMECRC, COLOR) += fate-ffmpeg-lavfi
 fate-ffmpeg-lavfi: CMD = framecrc -lavfi color=d=1:r=5 -fflags +bitexact
 
+# frames hashed on several threads must give the lines in packet order
+FATE_FFMPEG-$(call FILTERFRAMECRC, TESTSRC2 SINE FORMAT, FRAMEMD5_MUXER) += fate-ffmpeg-framemd5-threads
+fate-ffmpeg-framemd5-threads: CMD = framemd5 -filter_complex "testsrc2=s=64x48:r=25:d=2,format=yuv420p;sine=d=2" -fflags +bitexact -hash_threads 3
+
 FATE_FFMPEG-$(call ENCDEC2, MPEG4, RAWVIDEO, AVI, RAWVIDEO_DEMUXER FRAMECRC_MUXER) += fate-force_key_frames
 fate-force_key_frames: tests/data/vsynth1.yuv
 fate-force_key_frames: CMD = enc_dec \
@@ -186,6 +186,66 @@ fate-filter-pan-downmix2: CMD = framecrc -ss 3.14 -i $(SRC) -frames:a 20 -filter
 FATE_AFILTER-$(call ALLYES, LAVFI_INDEV AEVALSRC_FILTER SILENCEREMOVE_FILTER ARESAMPLE_FILTER) += fate-filter-silenceremove
 fate-filter-silenceremove: CMD = framecrc -auto_conversion_filters -f lavfi -i "aevalsrc=between(t\,1\,2)+between(t\,4\,5)+between(t\,7\,9):d=10:n=8192,silenceremove=start_periods=0:start_duration=0:start_threshold=0:stop_periods=-1:stop_duration=0:stop_threshold=-90dB:window=0:detection=avg"
 
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, LOUDNORM ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-loudnorm-analysis
+fate-filter-loudnorm-analysis: tests/data/asynth-44100-2.wav
+fate-filter-loudnorm-analysis: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-loudnorm-analysis: CMD = framecrc -auto_conversion_filters -i $(SRC) -af loudnorm=analysis=1:print_format=json
+
+# analysis only measures, the output must be the input resampled to 192 kHz
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, AFORMAT ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-loudnorm-analysis-resample
+fate-filter-loudnorm-analysis-resample: tests/data/asynth-44100-2.wav
+fate-filter-loudnorm-analysis-resample: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-loudnorm-analysis-resample: REF = $(SRC_PATH)/tests/ref/fate/filter-loudnorm-analysis
+fate-filter-loudnorm-analysis-resample: CMD = framecrc -auto_conversion_filters -i $(SRC) -af aformat=sample_fmts=dbl:sample_rates=192000
+
+AFFTDN_SRC ="aevalsrc=sin(2*PI*(440+40*t)*t)+0.2*(random(0)-0.5):d=5:s=48000"
+AFFTDN_DEPS = LAVFI_INDEV AEVALSRC_FILTER AFFTDN_FILTER AFORMAT_FILTER ARESAMPLE_FILTER
+
+FATE_AFILTER-$(call FILTERFRAMECRC, , $(AFFTDN_DEPS)) += fate-filter-afftdn
+fate-filter-afftdn: CMD = framecrc -auto_conversion_filters -filter_threads 1 -f lavfi -i $(AFFTDN_SRC) -af afftdn=nr=20:nf=-40:tn=1:gs=5
+
+# the bins of a channel are split in slices with more threads than channels
+FATE_AFILTER-$(call FILTERFRAMECRC, , $(AFFTDN_DEPS)) += fate-filter-afftdn-threads
+fate-filter-afftdn-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-afftdn
+fate-filter-afftdn-threads: CMD = framecrc -auto_conversion_filters -filter_threads 4 -f lavfi -i $(AFFTDN_SRC) -af afftdn=nr=20:nf=-40:tn=1:gs=5
+
+FATE_AFILTER-$(call FILTERFRAMECRC, , $(AFFTDN_DEPS)) += fate-filter-afftdn-flt
+fate-filter-afftdn-flt: CMD = framecrc -auto_conversion_filters -filter_threads 1 -f lavfi -i $(AFFTDN_SRC) -af aformat=fltp,afftdn=nr=20:nf=-40:tn=1:gs=5
+
+FATE_AFILTER-$(call FILTERFRAMECRC, , $(AFFTDN_DEPS)) += fate-filter-afftdn-flt-threads
+fate-filter-afftdn-flt-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-afftdn-flt
+fate-filter-afftdn-flt-threads: CMD = framecrc -auto_conversion_filters -filter_threads 4 -f lavfi -i $(AFFTDN_SRC) -af aformat=fltp,afftdn=nr=20:nf=-40:tn=1:gs=5
+
+AFIR_ASYNC_GRAPH ="aevalsrc=sin(2*PI*(440+40*t)*t)|cos(2*PI*220*t):d=5[in];aevalsrc=exp(-20*t)*sin(2*PI*1000*t)|exp(-30*t)*cos(2*PI*500*t):d=1[ir];[in][ir]afir=minp=64:maxp=4096
+AFIR_ASYNC_DEPS = LAVFI_INDEV AEVALSRC_FILTER AFIR_FILTER ARESAMPLE_FILTER
+
+FATE_AFILTER-$(call FILTERFRAMECRC, , $(AFIR_ASYNC_DEPS)) += fate-filter-afir-async-1
+fate-filter-afir-async-1: CMD = framecrc -auto_conversion_filters -f lavfi -i $(AFIR_ASYNC_GRAPH):async=1[out0]"
+
+# the output must not depend on the number of threads
+FATE_AFILTER-$(call FILTERFRAMECRC, , $(AFIR_ASYNC_DEPS)) += fate-filter-afir-async-2
+fate-filter-afir-async-2: REF = $(SRC_PATH)/tests/ref/fate/filter-afir-async-1
+fate-filter-afir-async-2: CMD = framecrc -auto_conversion_filters -f lavfi -i $(AFIR_ASYNC_GRAPH):async=2[out0]"
+
+FATE_AFILTER-$(call FILTERFRAMECRC, , $(AFIR_ASYNC_DEPS)) += fate-filter-afir-async-4
+fate-filter-afir-async-4: REF = $(SRC_PATH)/tests/ref/fate/filter-afir-async-1
+fate-filter-afir-async-4: CMD = framecrc -auto_conversion_filters -f lavfi -i $(AFIR_ASYNC_GRAPH):async=4[out0]"
+
+ARNNDN_SRC ="aevalsrc=sin(2*PI*(440+40*t)*t)+0.2*(random(0)-0.5)|0.3*(random(1)-0.5):d=1.005:s=48000"
+ARNNDN_DEPS = LAVFI_INDEV AEVALSRC_FILTER ARNNDN_FILTER ARESAMPLE_FILTER
+
+FATE_AFILTER-$(call FILTERFRAMECRC, , $(ARNNDN_DEPS)) += fate-filter-arnndn
+fate-filter-arnndn: CMD = framecrc -auto_conversion_filters -f lavfi -i $(ARNNDN_SRC) -af arnndn=m=$(SRC_PATH)/tests/arnndn.rnnn
+
+# the last frame is partial and must still be output when draining at EOF
+FATE_AFILTER-$(call FILTERFRAMECRC, , $(ARNNDN_DEPS)) += fate-filter-arnndn-pipeline-1
+fate-filter-arnndn-pipeline-1: REF = $(SRC_PATH)/tests/ref/fate/filter-arnndn
+fate-filter-arnndn-pipeline-1: CMD = framecrc -auto_conversion_filters -filter_threads 1 -f lavfi -i $(ARNNDN_SRC) -af arnndn=m=$(SRC_PATH)/tests/arnndn.rnnn:pipeline=1
+
+FATE_AFILTER-$(call FILTERFRAMECRC, , $(ARNNDN_DEPS)) += fate-filter-arnndn-pipeline-4
+fate-filter-arnndn-pipeline-4: REF = $(SRC_PATH)/tests/ref/fate/filter-arnndn
+fate-filter-arnndn-pipeline-4: CMD = framecrc -auto_conversion_filters -filter_threads 4 -f lavfi -i $(ARNNDN_SRC) -af arnndn=m=$(SRC_PATH)/tests/arnndn.rnnn:pipeline=1
+
 FATE_AFILTER_SAMPLES-$(call FILTERDEMDECENCMUX, STEREOTOOLS ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-stereotools
 fate-filter-stereotools: SRC = $(TARGET_SAMPLES)/audio-reference/luckynight_2ch_44kHz_s16.wav
 fate-filter-stereotools: CMD = framecrc -i $(SRC) -frames:a 20 -af aresample,stereotools=mlev=0.015625,aresample
@@ -67,3 +67,13 @@ FATE_JPEG2000DEC += $(FATE_JPEG2000DEC-yes)
 
 FATE_SAMPLES_FFMPEG-$(call FRAMECRC, IMAGE_J2K_PIPE, JPEG2000) += $(FATE_JPEG2000DEC)
 fate-jpeg2000dec: $(FATE_JPEG2000DEC)
+
+FATE_JPEG2000ENC-$(call ENCDEC, JPEG2000, AVI, SCALE_FILTER) += fate-jpeg2000enc-ht fate-jpeg2000enc-ht-97
+fate-jpeg2000enc-ht:    ENCOPTS = -ht 1 -pred 1 -pix_fmt rgb24
+fate-jpeg2000enc-ht-97: ENCOPTS = -ht 1 -qscale 7 -pix_fmt rgb24
+fate-jpeg2000enc-%: CMD = enc_dec "rawvideo -s 352x288 -pix_fmt yuv420p" tests/data/vsynth1.yuv avi "-c jpeg2000 $(ENCOPTS)" rawvideo "-pix_fmt yuv420p -fps_mode passthrough" "" ""
+fate-jpeg2000enc-%: CMP_UNIT = 1
+
+$(FATE_JPEG2000ENC-yes): tests/data/vsynth1.yuv
+FATE_FFMPEG += $(FATE_JPEG2000ENC-yes)
+fate-jpeg2000enc: $(FATE_JPEG2000ENC-yes)
@@ -21,6 +21,8 @@ FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         EXR) += zip1.gbrapf32le.exr
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         EXR) += zip16.grayf32le.exr
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         EXR) += zip16.gbrpf32le.exr
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         EXR) += zip16.gbrapf32le.exr
+FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         EXR) += zip16.tiles.gbrpf32le.exr
+FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         EXR) += rle.tiles.half.gbrapf32le.exr
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,       MJPEG) += jpg
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PAM) += pam
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PAM) += rgba.pam
@@ -72,6 +74,8 @@ fate-lavf-none.gbrapf32le.exr:  CMD = lavf_image "-compression none  -pix_fmt gb
 fate-lavf-rle.gbrapf32le.exr:   CMD = lavf_image "-compression rle   -pix_fmt gbrapf32le" "" "no_file_checksums"
 fate-lavf-zip1.gbrapf32le.exr:  CMD = lavf_image "-compression zip1  -pix_fmt gbrapf32le" "" "no_file_checksums"
 fate-lavf-zip16.gbrapf32le.exr: CMD = lavf_image "-compression zip16 -pix_fmt gbrapf32le" "" "no_file_checksums"
+fate-lavf-zip16.tiles.gbrpf32le.exr:     CMD = lavf_image "-compression zip16 -tiles 64x48 -pix_fmt gbrpf32le" "" "no_file_checksums"
+fate-lavf-rle.tiles.half.gbrapf32le.exr: CMD = lavf_image "-compression rle -tiles 100x40 -format half -threads 3 -thread_type slice -pix_fmt gbrapf32le" "" "no_file_checksums"
 fate-lavf-jpg: CMD = lavf_image "-pix_fmt yuvj420p"
 fate-lavf-tiff: CMD = lavf_image "-pix_fmt rgb24"
 fate-lavf-gbrp10le.dpx: CMD = lavf_image "-pix_fmt gbrp10le" "-pix_fmt gbrp10le"
@@ -270,8 +270,34 @@ fate-matroska-side-data-pref-packet: CMD = run ffprobe$(PROGSSUF)$(EXESUF) $(TAR
     -select_streams v:0 -show_streams -show_frames -show_entries stream=stream_side_data:frame=frame_side_data_list -side_data_prefer_packet mastering_display_metadata,content_light_level
 FATE_MATROSKA_FFPROBE-$(call ALLYES, MATROSKA_DEMUXER HEVC_DECODER) += fate-matroska-side-data-pref-codec fate-matroska-side-data-pref-packet
 
+tests/data/matroska-cluster-prefetch.mkv: TAG = GEN
+tests/data/matroska-cluster-prefetch.mkv: ffmpeg$(PROGSSUF)$(EXESUF) tests/data/asynth-44100-2.wav | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i testsrc=size=64x48:rate=25:duration=4 -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav \
+	-map 0:v -map 1:a -map 1:a -c:v mpeg4 -bf 2 -g 12 -c:a pcm_s16le -t 4 \
+	-cluster_size_limit 100000 -cluster_time_limit 1000 \
+	-flags +bitexact -fflags +bitexact -y $(TARGET_PATH)/$@ 2>/dev/null
+
+# prefetching clusters must not change the demuxed packets, whether all
+# clusters fit into the prefetch size or only some of them
+FATE_MATROSKA_CLUSTER_PREFETCH = fate-matroska-cluster-prefetch fate-matroska-cluster-prefetch-partial
+fate-matroska-cluster-prefetch:         PREFETCH = -cluster_prefetch_size 10000000
+fate-matroska-cluster-prefetch-partial: PREFETCH = -cluster_prefetch_size 100000
+fate-matroska-cluster-default fate-matroska-cluster-prefetch fate-matroska-cluster-prefetch-partial: CMD = framecrc $(PREFETCH) -i $(TARGET_PATH)/tests/data/matroska-cluster-prefetch.mkv -map 0 -c copy
+$(FATE_MATROSKA_CLUSTER_PREFETCH): REF = $(SRC_PATH)/tests/ref/fate/matroska-cluster-default
+
+fate-matroska-cluster-prefetch-seek: PREFETCH = -cluster_prefetch_size 10000000
+fate-matroska-cluster-default-seek fate-matroska-cluster-prefetch-seek: CMD = framecrc $(PREFETCH) -ss 1.5 -i $(TARGET_PATH)/tests/data/matroska-cluster-prefetch.mkv -map 0 -c copy
+fate-matroska-cluster-prefetch-seek: REF = $(SRC_PATH)/tests/ref/fate/matroska-cluster-default-seek
+
+FATE_MATROSKA_CLUSTER_PREFETCH += fate-matroska-cluster-default fate-matroska-cluster-default-seek fate-matroska-cluster-prefetch-seek
+$(FATE_MATROSKA_CLUSTER_PREFETCH): tests/data/matroska-cluster-prefetch.mkv
+FATE_MATROSKA_FFMPEG-$(call ALLYES, MATROSKA_DEMUXER MATROSKA_MUXER LAVFI_INDEV TESTSRC_FILTER MPEG4_ENCODER WAV_DEMUXER PCM_S16LE_ENCODER PCM_S16LE_DECODER FRAMECRC_MUXER) \
+                          += $(FATE_MATROSKA_CLUSTER_PREFETCH)
+
 FATE_SAMPLES_AVCONV += $(FATE_MATROSKA-yes)
 FATE_SAMPLES_FFPROBE += $(FATE_MATROSKA_FFPROBE-yes)
 FATE_SAMPLES_FFMPEG_FFPROBE += $(FATE_MATROSKA_FFMPEG_FFPROBE-yes)
+FATE_FFMPEG += $(FATE_MATROSKA_FFMPEG-yes)
 
-fate-matroska: $(FATE_MATROSKA-yes) $(FATE_MATROSKA_FFPROBE-yes) $(FATE_MATROSKA_FFMPEG_FFPROBE-yes)
+fate-matroska: $(FATE_MATROSKA-yes) $(FATE_MATROSKA_FFPROBE-yes) $(FATE_MATROSKA_FFMPEG_FFPROBE-yes) $(FATE_MATROSKA_FFMPEG-yes)
@@ -219,6 +219,12 @@ FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_S16LE, MOV, WAV_DEMUXER PAN_FILTER) \
 fate-mov-mp4-pcm-float: tests/data/asynth-44100-1.wav
 fate-mov-mp4-pcm-float: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-1.wav mp4 "-af aresample,pan=FR+FL+FR|c0=c0|c1=c0|c2=c0 -c:a pcm_f32le" "-map 0 -c copy -frames:a 0"
 
+# Test writing fragments directly to the output, with fragments cut by frag_direct_samples
+FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_S16LE, MOV, WAV_DEMUXER) \
+                          += fate-mov-mp4-frag-direct
+fate-mov-mp4-frag-direct: tests/data/asynth-44100-1.wav
+fate-mov-mp4-frag-direct: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-1.wav mp4 "-c:a pcm_s16le -movflags +empty_moov -frag_duration 1000000 -frag_direct_samples 16" "-c copy"
+
 fate-mov-pcm-remux: tests/data/asynth-44100-1.wav
 fate-mov-pcm-remux: CMD = md5 -i $(TARGET_PATH)/tests/data/asynth-44100-1.wav -map 0 -c copy -fflags +bitexact -f mp4
 fate-mov-pcm-remux: CMP = oneline
@@ -284,6 +290,31 @@ fate-mov-mp4-iamf-ambisonic_1: CMD = transcode wav $(SRC) mp4 "-auto_conversion_
   -streamid 0:0 -streamid 1:1 -streamid 2:2 -streamid 3:3 -map [MONO0] -map [MONO1] -map [MONO2] -map [MONO3] -c:a flac -t 1" "-c:a copy -map 0" \
   "-show_entries stream_group=index,id,nb_streams,type:stream_group_components:stream_group_disposition:stream_group_tags:stream_group_stream=index,id:stream_group_stream_disposition"
 
+tests/data/mov-lazy-index.mp4: TAG = GEN
+tests/data/mov-lazy-index.mp4: ffmpeg$(PROGSSUF)$(EXESUF) tests/data/asynth-44100-2.wav | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i testsrc=size=64x48:rate=25:duration=4 -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav \
+	-map 0:v -map 1:a -map 1:a -c:v mpeg4 -bf 2 -g 12 -c:a pcm_s16le -t 4 \
+	-flags +bitexact -fflags +bitexact -y $(TARGET_PATH)/$@ 2>/dev/null
+
+# the lazily built indexes must give the same packets as the upfront ones
+FATE_MOV_LAZY_INDEX = fate-mov-lazy-index fate-mov-lazy-index-threads
+fate-mov-lazy-index:         LAZY_INDEX = -lazy_index 1
+fate-mov-lazy-index-threads: LAZY_INDEX = -lazy_index 1 -index_threads 3
+fate-mov-index fate-mov-lazy-index fate-mov-lazy-index-threads: CMD = framecrc $(LAZY_INDEX) -i $(TARGET_PATH)/tests/data/mov-lazy-index.mp4 -map 0 -c copy
+$(FATE_MOV_LAZY_INDEX): REF = $(SRC_PATH)/tests/ref/fate/mov-index
+
+# a seek builds the index of the sought track, the discarded tracks are
+# left alone
+fate-mov-lazy-index-seek: LAZY_INDEX = -lazy_index 1
+fate-mov-index-seek fate-mov-lazy-index-seek: CMD = framecrc $(LAZY_INDEX) -ss 1.5 -i $(TARGET_PATH)/tests/data/mov-lazy-index.mp4 -map 0:a:1 -c copy
+fate-mov-lazy-index-seek: REF = $(SRC_PATH)/tests/ref/fate/mov-index-seek
+
+FATE_MOV_LAZY_INDEX += fate-mov-index fate-mov-index-seek fate-mov-lazy-index-seek
+$(FATE_MOV_LAZY_INDEX): tests/data/mov-lazy-index.mp4
+FATE_MOV_FFMPEG-$(call ALLYES, MOV_DEMUXER MP4_MUXER LAVFI_INDEV TESTSRC_FILTER MPEG4_ENCODER WAV_DEMUXER PCM_S16LE_ENCODER PCM_S16LE_DECODER FRAMECRC_MUXER) \
+                          += $(FATE_MOV_LAZY_INDEX)
+
 FATE_FFMPEG += $(FATE_MOV_FFMPEG-yes)
 FATE_FFMPEG_FFPROBE += $(FATE_MOV_FFMPEG_FFPROBE-yes)
 
@@ -22,4 +22,38 @@ fate-mpegts-probe-pmt-merge: CMD = run $(PROBE_CODEC_NAME_COMMAND) -merge_pmt_ve
 
 FATE_SAMPLES_FFPROBE += $(FATE_MPEGTS_PROBE-yes)
 
-fate-mpegts: $(FATE_MPEGTS_PROBE-yes)
+tests/data/mpegts_programs.ts: TAG = GEN
+tests/data/mpegts_programs.ts: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+        -f lavfi -i "aevalsrc=sin(2*PI*440*t):d=4" \
+        -f lavfi -i "aevalsrc=sin(2*PI*660*t):d=4" \
+        -f lavfi -i "aevalsrc=sin(2*PI*880*t):d=4" \
+        -map 0 -map 1 -map 2 -codec:a mp2fixed -flags +bitexact -fflags +bitexact \
+        -program program_num=1:st=0 -program program_num=2:st=1 -program program_num=3:st=2 \
+        -y $(TARGET_PATH)/$@ 2>/dev/null
+
+# Demuxing a single program skips the packets of the other programs in
+# batches, which must not change the packets of the selected program.
+FATE_MPEGTS-$(call ALLYES, MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILTER ARESAMPLE_FILTER LAVFI_INDEV MP2FIXED_ENCODER FRAMECRC_MUXER) += fate-mpegts-programs-discard
+fate-mpegts-programs-discard: tests/data/mpegts_programs.ts
+fate-mpegts-programs-discard: CMD = framecrc -i $(TARGET_PATH)/tests/data/mpegts_programs.ts -map 0:p:2 -c copy
+
+# Same with all programs demuxed, so that nothing is skipped.
+FATE_MPEGTS-$(call ALLYES, MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILTER ARESAMPLE_FILTER LAVFI_INDEV MP2FIXED_ENCODER FRAMECRC_MUXER NULL_MUXER) += fate-mpegts-programs-all
+fate-mpegts-programs-all: tests/data/mpegts_programs.ts
+fate-mpegts-programs-all: CMD = framecrc -i $(TARGET_PATH)/tests/data/mpegts_programs.ts -map 0 -c copy -f null - -map 0:p:2 -c copy
+fate-mpegts-programs-all: REF = $(SRC_PATH)/tests/ref/fate/mpegts-programs-discard
+
+# Intra MPEG-2 frames of about 17 kB, so that the TS packets of each PES
+# packet are written in several batches.
+MPEGTS_LARGE_PES = -f lavfi -i testsrc2=d=1:s=352x288:r=25 -c:v mpeg2video -g 1 -qscale 1 -flags +bitexact -fflags +bitexact
+
+FATE_MPEGTS-$(call ALLYES, MPEGTS_MUXER TESTSRC2_FILTER LAVFI_INDEV MPEG2VIDEO_ENCODER) += fate-mpegts-large-pes
+fate-mpegts-large-pes: CMD = md5 $(MPEGTS_LARGE_PES) -f mpegts
+
+FATE_MPEGTS-$(call ALLYES, MPEGTS_MUXER TESTSRC2_FILTER LAVFI_INDEV MPEG2VIDEO_ENCODER) += fate-mpegts-large-pes-m2ts
+fate-mpegts-large-pes-m2ts: CMD = md5 $(MPEGTS_LARGE_PES) -mpegts_m2ts_mode 1 -f mpegts
+
+FATE_FFMPEG += $(FATE_MPEGTS-yes)
+
+fate-mpegts: $(FATE_MPEGTS_PROBE-yes) $(FATE_MPEGTS-yes)
@@ -256,7 +256,8 @@ FATE_MPEG2 := mpeg2                                                     \
              mpeg2-ilace                                                \
              mpeg2-ivlc-qprd                                            \
              mpeg2-thread                                               \
-             mpeg2-thread-ivlc
+             mpeg2-thread-ivlc                                          \
+             mpeg2-wavefront
 
 FATE_VCODEC-$(call ENCDEC, MPEG2VIDEO, MPEG2VIDEO MPEGVIDEO) += $(FATE_MPEG2)
 
@@ -285,6 +286,12 @@ fate-vsynth%-mpeg2-thread:       ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
                                            -threads 2 -slices 2
 fate-vsynth%-mpeg2-thread-ivlc:  ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
                                            -intra_vlc 1 -threads 2 -slices 2
+fate-vsynth%-mpeg2-wavefront:    ENCOPTS = -qscale 10 -flags +ildct+ilme       \
+                                           -threads 3 -thread_type slice \
+                                           -mpv_flags wavefront_me
+# wavefront motion estimation must be bit-identical to the serial search
+fate-vsynth%-mpeg2-wavefront:    CMD += | sed -e "s/-mpeg2-wavefront\./-mpeg2-ilace./"
+fate-vsynth%-mpeg2-wavefront:    REF = $(SRC_PATH)/tests/ref/vsynth/$(@:fate-%-wavefront=%-ilace)
 
 FATE_MPEG4_MP4 = mpeg4
 FATE_MPEG4_AVI = mpeg4-rc                                               \
@@ -0,0 +1,147 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measures the time the afir filter takes to return each block of output
+ * when fed one block of minp samples at a time, as a real time host would.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/frame.h"
+#include "libavutil/time.h"
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+#define SAMPLE_RATE 48000
+
+int main(int argc, char **argv)
+{
+    AVFilterGraph *graph = NULL;
+    AVFilterContext *src, *sink;
+    AVFrame *frame = NULL;
+    AVChannelLayout layout;
+    char desc[512], layout_name[64];
+    int64_t total = 0, worst = 0;
+    int channels, minp, maxp, async, threads, nb_blocks, warmup, timed = 0;
+    double ir_seconds;
+    int ret;
+
+    if (argc < 6) {
+        fprintf(stderr, "Usage: %s channels ir_seconds minp maxp async [threads]\n",
+                argv[0]);
+        return 1;
+    }
+    channels   = atoi(argv[1]);
+    ir_seconds = atof(argv[2]);
+    minp       = atoi(argv[3]);
+    maxp       = atoi(argv[4]);
+    async      = atoi(argv[5]);
+    threads    = argc > 6 ? atoi(argv[6]) : 1;
+    if (channels < 1 || channels > 64 || ir_seconds <= 0 || minp < 1 || maxp < minp) {
+        fprintf(stderr, "Invalid arguments\n");
+        return 1;
+    }
+    /* skip the blocks during which the IR is loaded, then run 10 seconds */
+    warmup    = 2 * SAMPLE_RATE / minp + 1;
+    nb_blocks = warmup + 10 * SAMPLE_RATE / minp;
+
+    av_channel_layout_default(&layout, channels);
+    av_channel_layout_describe(&layout, layout_name, sizeof(layout_name));
+
+    graph = avfilter_graph_alloc();
+    if (!graph)
+        return 1;
+    graph->nb_threads = threads;
+
+    snprintf(desc, sizeof(desc),
+             "abuffer@in=sample_rate=%d:sample_fmt=fltp:channel_layout=%s[in];"
+             "aevalsrc=(random(0)*2-1)*exp(-4*t):s=%d:d=%g[ir];"
+             "[in][ir]afir=irfmt=mono:maxir=%g:minp=%d:maxp=%d:async=%d,"
+             "abuffersink@out",
+             SAMPLE_RATE, layout_name, SAMPLE_RATE, ir_seconds, ir_seconds,
+             minp, maxp, async);
+    ret = avfilter_graph_parse_ptr(graph, desc, NULL, NULL, NULL);
+    if (ret >= 0)
+        ret = avfilter_graph_config(graph, NULL);
+    if (ret < 0) {
+        fprintf(stderr, "Could not set up the filter graph: %s\n", av_err2str(ret));
+        goto end;
+    }
+    src  = avfilter_graph_get_filter(graph, "abuffer@in");
+    sink = avfilter_graph_get_filter(graph, "abuffersink@out");
+    if (!src || !sink) {
+        ret = AVERROR_BUG;
+        goto end;
+    }
+
+    frame = av_frame_alloc();
+    if (!frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    for (int i = 0; i < nb_blocks; i++) {
+        int64_t t, elapsed;
+
+        frame->format      = AV_SAMPLE_FMT_FLTP;
+        frame->sample_rate = SAMPLE_RATE;
+        frame->nb_samples  = minp;
+        frame->pts         = (int64_t)i * minp;
+        av_channel_layout_copy(&frame->ch_layout, &layout);
+        ret = av_frame_get_buffer(frame, 0);
+        if (ret < 0)
+            goto end;
+        for (int ch = 0; ch < channels; ch++)
+            for (int n = 0; n < minp; n++)
+                ((float *)frame->extended_data[ch])[n] = ((i * minp + n) * (ch + 3) % 101) / 101.f - 0.5f;
+
+        t = av_gettime_relative();
+        ret = av_buffersrc_add_frame(src, frame);
+        if (ret < 0)
+            goto end;
+        while ((ret = av_buffersink_get_frame(sink, frame)) >= 0)
+            av_frame_unref(frame);
+        if (ret != AVERROR(EAGAIN))
+            goto end;
+        elapsed = av_gettime_relative() - t;
+
+        if (i >= warmup) {
+            total += elapsed;
+            worst  = FFMAX(worst, elapsed);
+            timed++;
+        }
+    }
+    ret = 0;
+
+    printf("latency: %d samples (%.2f ms)\n", minp, minp * 1000.0 / SAMPLE_RATE);
+    printf("block:   %.1f us mean, %"PRId64" us max\n", (double)total / timed, worst);
+    printf("load:    %.1f%% of real time mean, %.1f%% max\n",
+           total * 100.0 / (timed * minp * 1000000.0 / SAMPLE_RATE),
+           worst * 100.0 / (minp * 1000000.0 / SAMPLE_RATE));
+
+end:
+    av_frame_free(&frame);
+    avfilter_graph_free(&graph);
+    if (ret < 0)
+        fprintf(stderr, "Error: %s\n", av_err2str(ret));
+    return ret < 0;
+}
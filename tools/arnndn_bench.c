@@ -0,0 +1,151 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measures the time the arnndn filter takes to denoise each 10 ms frame
+ * when fed one frame at a time, and the resulting throughput, which bounds
+ * the number of streams a host can denoise in real time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/frame.h"
+#include "libavutil/time.h"
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+#define SAMPLE_RATE 48000
+#define FRAME_SIZE  480
+
+int main(int argc, char **argv)
+{
+    AVFilterGraph *graph = NULL;
+    AVFilterContext *src, *sink;
+    AVFrame *frame = NULL;
+    AVChannelLayout layout;
+    char desc[1024], layout_name[64];
+    int64_t total = 0, worst = 0;
+    int channels, pipeline, threads, nb_frames;
+    double seconds;
+    int ret;
+
+    if (argc < 5) {
+        fprintf(stderr, "Usage: %s model channels seconds pipeline [threads]\n",
+                argv[0]);
+        return 1;
+    }
+    channels = atoi(argv[2]);
+    seconds  = atof(argv[3]);
+    pipeline = atoi(argv[4]);
+    threads  = argc > 5 ? atoi(argv[5]) : 1;
+    if (channels < 1 || channels > 64 || seconds <= 0) {
+        fprintf(stderr, "Invalid arguments\n");
+        return 1;
+    }
+    nb_frames = seconds * SAMPLE_RATE / FRAME_SIZE;
+    if (nb_frames < 1)
+        nb_frames = 1;
+
+    av_channel_layout_default(&layout, channels);
+    av_channel_layout_describe(&layout, layout_name, sizeof(layout_name));
+
+    graph = avfilter_graph_alloc();
+    if (!graph)
+        return 1;
+    graph->nb_threads = threads;
+
+    snprintf(desc, sizeof(desc),
+             "abuffer@in=sample_rate=%d:sample_fmt=fltp:channel_layout=%s,"
+             "arnndn=model='%s':pipeline=%d,"
+             "abuffersink@out",
+             SAMPLE_RATE, layout_name, argv[1], pipeline);
+    ret = avfilter_graph_parse_ptr(graph, desc, NULL, NULL, NULL);
+    if (ret >= 0)
+        ret = avfilter_graph_config(graph, NULL);
+    if (ret < 0) {
+        fprintf(stderr, "Could not set up the filter graph: %s\n", av_err2str(ret));
+        goto end;
+    }
+    src  = avfilter_graph_get_filter(graph, "abuffer@in");
+    sink = avfilter_graph_get_filter(graph, "abuffersink@out");
+    if (!src || !sink) {
+        ret = AVERROR_BUG;
+        goto end;
+    }
+
+    frame = av_frame_alloc();
+    if (!frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    for (int i = 0; i < nb_frames; i++) {
+        int64_t t, elapsed;
+
+        frame->format      = AV_SAMPLE_FMT_FLTP;
+        frame->sample_rate = SAMPLE_RATE;
+        frame->nb_samples  = FRAME_SIZE;
+        frame->pts         = (int64_t)i * FRAME_SIZE;
+        av_channel_layout_copy(&frame->ch_layout, &layout);
+        ret = av_frame_get_buffer(frame, 0);
+        if (ret < 0)
+            goto end;
+        /* a harmonic voice-like buzz over broadband noise, in s16 range */
+        for (int ch = 0; ch < channels; ch++) {
+            float *dst = (float *)frame->extended_data[ch];
+
+            for (int n = 0; n < FRAME_SIZE; n++) {
+                const int64_t pos = (int64_t)i * FRAME_SIZE + n;
+
+                dst[n] = ((pos % 218) - 109) * 40.f +
+                         ((pos * (ch + 3) * 7919) % 1021 - 510) * 4.f;
+            }
+        }
+
+        t = av_gettime_relative();
+        ret = av_buffersrc_add_frame(src, frame);
+        if (ret < 0)
+            goto end;
+        while ((ret = av_buffersink_get_frame(sink, frame)) >= 0)
+            av_frame_unref(frame);
+        if (ret != AVERROR(EAGAIN))
+            goto end;
+        elapsed = av_gettime_relative() - t;
+
+        total += elapsed;
+        worst  = FFMAX(worst, elapsed);
+    }
+    ret = 0;
+
+    printf("frame:   %.1f us mean, %"PRId64" us max\n", (double)total / nb_frames, worst);
+    printf("load:    %.1f%% of real time mean, %.1f%% max\n",
+           total * 100.0 / (nb_frames * FRAME_SIZE * 1000000.0 / SAMPLE_RATE),
+           worst * 100.0 / (FRAME_SIZE * 1000000.0 / SAMPLE_RATE));
+    printf("speed:   %.1fx real time\n",
+           nb_frames * FRAME_SIZE * 1000000.0 / SAMPLE_RATE / FFMAX(total, 1));
+
+end:
+    av_frame_free(&frame);
+    avfilter_graph_free(&graph);
+    if (ret < 0)
+        fprintf(stderr, "Error: %s\n", av_err2str(ret));
+    return ret < 0;
+}
@@ -77,6 +77,7 @@ struct hash_impl {
 #include "libavutil/sha512.h"
 #include "libavutil/ripemd.h"
 #include "libavutil/aes.h"
+#include "libavutil/aes_ctr.h"
 #include "libavutil/blowfish.h"
 #include "libavutil/camellia.h"
 #include "libavutil/cast5.h"
@@ -111,6 +112,17 @@ DEFINE_LAVU_MD(sha512,    AVSHA512, sha512, 512);
 DEFINE_LAVU_MD(ripemd128, AVRIPEMD, ripemd, 128);
 DEFINE_LAVU_MD(ripemd160, AVRIPEMD, ripemd, 160);
 
+#define DEFINE_LAVU_CRC(suffix, id)                                          \
+static void run_lavu_ ## suffix(uint8_t *output,                             \
+                                const uint8_t *input, unsigned size)         \
+{                                                                            \
+    AV_WB32(output, av_crc(av_crc_get_table(id), 0, input, size));           \
+}
+
+DEFINE_LAVU_CRC(crc32,    AV_CRC_32_IEEE);
+DEFINE_LAVU_CRC(crc32le,  AV_CRC_32_IEEE_LE);
+DEFINE_LAVU_CRC(crc16,    AV_CRC_16_ANSI);
+
 static void run_lavu_aes128(uint8_t *output,
                             const uint8_t *input, unsigned size)
 {
@@ -121,6 +133,27 @@ static void run_lavu_aes128(uint8_t *output,
     av_aes_crypt(aes, output, input, size >> 4, NULL, 0);
 }
 
+static void run_lavu_aes128cbcdec(uint8_t *output,
+                                  const uint8_t *input, unsigned size)
+{
+    static struct AVAES *aes;
+    uint8_t iv[16] = { 0 };
+    if (!aes && !(aes = av_aes_alloc()))
+        fatal_error("out of memory");
+    av_aes_init(aes, hardcoded_key, 128, 1);
+    av_aes_crypt(aes, output, input, size >> 4, iv, 1);
+}
+
+static void run_lavu_aes128ctr(uint8_t *output,
+                               const uint8_t *input, unsigned size)
+{
+    static struct AVAESCTR *aes;
+    if (!aes && !(aes = av_aes_ctr_alloc()))
+        fatal_error("out of memory");
+    av_aes_ctr_init(aes, hardcoded_key);
+    av_aes_ctr_crypt(aes, output, input, size);
+}
+
 static void run_lavu_blowfish(uint8_t *output,
                               const uint8_t *input, unsigned size)
 {
@@ -647,7 +680,12 @@ struct hash_impl implementations[] = {
     IMPL(lavu,     "RIPEMD-128", ripemd128, "9ab8bfba2ddccc5d99c9d4cdfb844a5f")
     IMPL(tomcrypt, "RIPEMD-128", ripemd128, "9ab8bfba2ddccc5d99c9d4cdfb844a5f")
     IMPL_ALL("RIPEMD-160", ripemd160, "62a5321e4fc8784903bb43ab7752c75f8b25af00")
+    IMPL(lavu,     "CRC-32",     crc32,     "ffe7b880")
+    IMPL(lavu,     "CRC-32-LE",  crc32le,   "b56da6ba")
+    IMPL(lavu,     "CRC-16",     crc16,     "000065e4")
     IMPL_ALL("AES-128",    aes128,    "crc:ff6bc888")
+    IMPL(lavu,     "AES-128-CBC-DEC", aes128cbcdec, "crc:ae4a81eb")
+    IMPL(lavu,     "AES-128-CTR",     aes128ctr,    "crc:b9fd39aa")
     IMPL_ALL("CAMELLIA",   camellia,  "crc:7abb59a7")
     IMPL(lavu,     "CAST-128", cast128, "crc:456aa584")
     IMPL(crypto,   "CAST-128", cast128, "crc:456aa584")